@@ -0,0 +1,49 @@
+#include "TestApplicationPCH.h"
+
+#include "MemoryBenchmark.h"
+
+#include <windows.h>
+
+#include "../Tomato/Tomato.h"
+
+using namespace Tomato;
+
+namespace
+{
+	// Writes totalBytes into a stream that starts at the default size, in records of
+	// recordSize bytes, and returns the best throughput of a few runs in MB/s.
+	f64 MeasureStreamWrite( s32 recordSize, s32 totalBytes )
+	{
+		std::vector<u8> record( recordSize, 0x5A );
+
+		f64 bestTime = Math::FloatPositiveMax;
+		for( s32 run = 0; run < 3; ++run )
+		{
+			Timer timer;
+
+			MessageStream stream;
+			for( s32 written = 0; written + recordSize <= totalBytes; written += recordSize )
+			{
+				stream.Write( &record[ 0 ], recordSize );
+			}
+
+			bestTime = Math::Min( bestTime, timer.GetElapsedTime() );
+		}
+
+		return ( static_cast<f64>( totalBytes ) / ( 1024.0 * 1024.0 ) ) / bestTime;
+	}
+}
+
+void RunMemoryBenchmarks()
+{
+	const s32 totalBytes = 256 * 1024 * 1024;
+	const s32 recordSizes[] = { 4, 16, 256, 65536 };
+	const s32 recordSizeCount = static_cast<s32>( sizeof( recordSizes ) / sizeof( recordSizes[ 0 ] ) );
+
+	printf( "MessageStream write, %d MB per run\n", totalBytes / ( 1024 * 1024 ) );
+
+	for( s32 i = 0; i < recordSizeCount; ++i )
+	{
+		printf( "  %6d byte records: %8.1f MB/s\n", recordSizes[ i ], MeasureStreamWrite( recordSizes[ i ], totalBytes ) );
+	}
+}
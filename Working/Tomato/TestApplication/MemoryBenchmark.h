@@ -0,0 +1,4 @@
+#pragma once
+
+// Prints the write throughput of MessageStream for a range of record sizes.
+void RunMemoryBenchmarks();
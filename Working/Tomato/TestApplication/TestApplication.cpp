@@ -5,8 +5,19 @@
 
 #include "../Tomato/Tomato.h"
 
-int _tmain( int, _TCHAR** )
+#include "MemoryBenchmark.h"
+
+int _tmain( int argc, _TCHAR** argv )
 {
+	// The benchmarks write several GB, so they only run when asked for.
+	for( int i = 1; i < argc; ++i )
+	{
+		if( _tcsicmp( argv[ i ], _T( "-benchmark" ) ) == 0 )
+		{
+			RunMemoryBenchmarks();
+		}
+	}
+
 	return 0;
 }
 
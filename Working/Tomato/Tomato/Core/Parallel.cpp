@@ -0,0 +1,238 @@
+#include "TomatoPCH.h"
+
+#include "Parallel.h"
+
+#include <process.h>
+
+namespace Tomato
+{
+	namespace
+	{
+		enum { MaxWorkerCount = 31 };
+
+		struct ParallelJob
+		{
+			Parallel::RangeFunction Function;
+			void* pContext;
+
+			s32 Begin;
+			s32 End;
+			s32 GrainSize;
+
+			volatile LONG NextRange;
+			LONG RangeCount;
+
+			// The calling thread and every woken worker release one reference.
+			volatile LONG References;
+		};
+
+		class WorkerPool
+		{
+		public:
+			WorkerPool()
+				: m_workerCount( 0 )
+				, m_hWakeUp( NULL )
+				, m_hDone( NULL )
+				, m_pJob( NULL )
+				, m_bShutdown( false )
+				, m_busy( 0 )
+			{
+			}
+
+			s32 GetThreadCount()
+			{
+				if( m_hWakeUp == NULL )
+				{
+					SYSTEM_INFO systemInfo;
+					::GetSystemInfo( &systemInfo );
+
+					return Math::Min( static_cast<s32>( systemInfo.dwNumberOfProcessors ), MaxWorkerCount + 1 );
+				}
+
+				return m_workerCount + 1;
+			}
+
+			void Run( ParallelJob& job )
+			{
+				if( ::InterlockedCompareExchange( &m_busy, 1, 0 ) != 0 )
+				{
+					RunRanges( job );
+					return;
+				}
+
+				if( m_hWakeUp == NULL )
+				{
+					Start();
+				}
+
+				if( m_workerCount == 0 )
+				{
+					RunRanges( job );
+				}
+				else
+				{
+					s32 wakeCount = Math::Min( m_workerCount, static_cast<s32>( job.RangeCount ) - 1 );
+
+					job.References = wakeCount + 1;
+					m_pJob = &job;
+					_ReadWriteBarrier();
+
+					::ReleaseSemaphore( m_hWakeUp, wakeCount, NULL );
+
+					RunRanges( job );
+
+					if( ::InterlockedDecrement( &job.References ) != 0 )
+					{
+						::WaitForSingleObject( m_hDone, INFINITE );
+					}
+
+					m_pJob = NULL;
+				}
+
+				::InterlockedExchange( &m_busy, 0 );
+			}
+
+			void Stop()
+			{
+				while( ::InterlockedCompareExchange( &m_busy, 1, 0 ) != 0 )
+				{
+					::SwitchToThread();
+				}
+
+				if( m_hWakeUp != NULL )
+				{
+					m_bShutdown = true;
+					::ReleaseSemaphore( m_hWakeUp, m_workerCount, NULL );
+
+					for( s32 i = 0; i < m_workerCount; ++i )
+					{
+						::WaitForSingleObject( m_hThreads[ i ], INFINITE );
+						::CloseHandle( m_hThreads[ i ] );
+					}
+
+					::CloseHandle( m_hWakeUp );
+					::CloseHandle( m_hDone );
+
+					m_hWakeUp = NULL;
+					m_hDone = NULL;
+					m_workerCount = 0;
+					m_bShutdown = false;
+				}
+
+				::InterlockedExchange( &m_busy, 0 );
+			}
+
+		private:
+			void Start()
+			{
+				m_workerCount = GetThreadCount() - 1;
+
+				m_hWakeUp = ::CreateSemaphore( NULL, 0, MaxWorkerCount, NULL );
+				m_hDone = ::CreateEvent( NULL, FALSE, FALSE, NULL );
+
+				for( s32 i = 0; i < m_workerCount; ++i )
+				{
+					m_hThreads[ i ] = reinterpret_cast<HANDLE>( ::_beginthreadex( NULL, 0, &WorkerPool::WorkerMain, this, 0, NULL ) );
+				}
+			}
+
+			static unsigned __stdcall WorkerMain( void* pArgument )
+			{
+				WorkerPool* pPool = static_cast<WorkerPool*>( pArgument );
+
+				for( ;; )
+				{
+					::WaitForSingleObject( pPool->m_hWakeUp, INFINITE );
+
+					if( pPool->m_bShutdown )
+					{
+						break;
+					}
+
+					ParallelJob* pJob = pPool->m_pJob;
+
+					RunRanges( *pJob );
+
+					if( ::InterlockedDecrement( &pJob->References ) == 0 )
+					{
+						::SetEvent( pPool->m_hDone );
+					}
+				}
+
+				return 0;
+			}
+
+			static void RunRanges( ParallelJob& job )
+			{
+				for( ;; )
+				{
+					LONG range = ::InterlockedIncrement( &job.NextRange ) - 1;
+					if( range >= job.RangeCount )
+					{
+						break;
+					}
+
+					s32 begin = job.Begin + static_cast<s32>( range ) * job.GrainSize;
+					s32 end = Math::Min( begin + job.GrainSize, job.End );
+
+					job.Function( job.pContext, begin, end );
+				}
+			}
+
+		private:
+			s32 m_workerCount;
+			HANDLE m_hThreads[ MaxWorkerCount ];
+
+			HANDLE m_hWakeUp;
+			HANDLE m_hDone;
+
+			ParallelJob* volatile m_pJob;
+			volatile bool m_bShutdown;
+
+			volatile LONG m_busy;
+		};
+
+		WorkerPool s_workerPool;
+	}
+
+	s32 Parallel::GetThreadCount()
+	{
+		return s_workerPool.GetThreadCount();
+	}
+
+	void Parallel::For( s32 begin, s32 end, s32 grainSize, RangeFunction function, void* pContext )
+	{
+		Assert( function != NULL );
+
+		if( begin >= end )
+		{
+			return;
+		}
+
+		grainSize = Math::Max( grainSize, 1 );
+
+		ParallelJob job;
+		job.Function = function;
+		job.pContext = pContext;
+		job.Begin = begin;
+		job.End = end;
+		job.GrainSize = grainSize;
+		job.NextRange = 0;
+		job.RangeCount = ( end - begin + grainSize - 1 ) / grainSize;
+		job.References = 1;
+
+		if( job.RangeCount == 1 )
+		{
+			function( pContext, begin, end );
+		}
+		else
+		{
+			s_workerPool.Run( job );
+		}
+	}
+
+	void Parallel::Shutdown()
+	{
+		s_workerPool.Stop();
+	}
+}
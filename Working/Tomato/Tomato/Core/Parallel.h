@@ -0,0 +1,37 @@
+#pragma once
+
+namespace Tomato
+{
+	// Runs loops on a pool of worker threads.
+	// The pool is created on first use with one worker per additional processor.
+	class TOMATO_API Parallel
+	{
+	public:
+		typedef void ( *RangeFunction )( void* pContext, s32 begin, s32 end );
+
+		// Number of threads that take part in a loop, including the calling thread.
+		static s32 GetThreadCount();
+
+		// Splits [begin, end) into ranges of grainSize elements and calls function for each of them.
+		// The calling thread takes part and returns once every range has completed.
+		// Calls made while another loop is running (including nested calls) run on the calling thread.
+		static void For( s32 begin, s32 end, s32 grainSize, RangeFunction function, void* pContext );
+
+		// Body must provide: void operator () ( s32 begin, s32 end );
+		template<typename Body>
+		static void For( s32 begin, s32 end, s32 grainSize, Body& body )
+		{
+			For( begin, end, grainSize, &Parallel::InvokeBody<Body>, static_cast<void*>( &body ) );
+		}
+
+		// Stops the worker threads. They are started again by the next For.
+		static void Shutdown();
+
+	private:
+		template<typename Body>
+		static void InvokeBody( void* pContext, s32 begin, s32 end )
+		{
+			( *static_cast<Body*>( pContext ) )( begin, end );
+		}
+	};
+}
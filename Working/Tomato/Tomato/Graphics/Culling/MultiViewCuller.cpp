@@ -0,0 +1,152 @@
+#include "TomatoPCH.h"
+
+#include "MultiViewCuller.h"
+
+#include <emmintrin.h>
+
+namespace Tomato
+{
+	class MultiViewCuller::TestBody
+	{
+	public:
+		TestBody( const MultiViewCuller& culler, const BoundingBox* pBoxes, u32* pMasks )
+			: m_culler( culler )
+			, m_pBoxes( pBoxes )
+			, m_pMasks( pMasks )
+		{
+		}
+
+		void operator () ( s32 begin, s32 end )
+		{
+			for( s32 i = begin; i < end; ++i )
+			{
+				m_pMasks[ i ] = m_culler.Test( m_pBoxes[ i ] );
+			}
+		}
+
+	private:
+		TestBody& operator = ( const TestBody& );
+
+		const MultiViewCuller& m_culler;
+		const BoundingBox* m_pBoxes;
+		u32* m_pMasks;
+	};
+
+	MultiViewCuller::MultiViewCuller()
+		: m_viewCount( 0 )
+	{
+	}
+
+	MultiViewCuller::~MultiViewCuller()
+	{
+	}
+
+	void MultiViewCuller::SetViews( const Matrix4* pViewProjections, s32 count )
+	{
+		Assert( count >= 0 );
+		Assert( count <= MaxViewCount );
+		Assert( count == 0 || pViewProjections != NULL );
+
+		m_viewCount = count;
+
+		for( s32 view = 0; view < MaxViewCount; ++view )
+		{
+			s32 group = view / 4;
+			s32 lane = view % 4;
+
+			if( view < count )
+			{
+				m_frustums[ view ].Set( pViewProjections[ view ] );
+			}
+
+			for( s32 side = 0; side < Frustum::Side::Count; ++side )
+			{
+				PlaneGroup& planes = m_planes[ group ][ side ];
+
+				if( view < count )
+				{
+					const Vector4& plane = m_frustums[ view ].GetPlane( static_cast<Frustum::Side::Type>( side ) );
+
+					planes.NormalX[ lane ] = plane.X;
+					planes.NormalY[ lane ] = plane.Y;
+					planes.NormalZ[ lane ] = plane.Z;
+					planes.Distance[ lane ] = plane.W;
+				}
+				else
+				{
+					// Unused lanes reject everything.
+					planes.NormalX[ lane ] = 0;
+					planes.NormalY[ lane ] = 0;
+					planes.NormalZ[ lane ] = 0;
+					planes.Distance[ lane ] = -1;
+				}
+			}
+		}
+	}
+
+	const Frustum& MultiViewCuller::GetFrustum( s32 view ) const
+	{
+		Assert( view >= 0 );
+		Assert( view < m_viewCount );
+
+		return m_frustums[ view ];
+	}
+
+	u32 MultiViewCuller::Test( const BoundingBox& box ) const
+	{
+		Vector3 center = box.GetCenter();
+		Vector3 extents = box.GetExtents();
+
+		__m128 centerX = _mm_set1_ps( center.X );
+		__m128 centerY = _mm_set1_ps( center.Y );
+		__m128 centerZ = _mm_set1_ps( center.Z );
+		__m128 extentX = _mm_set1_ps( extents.X );
+		__m128 extentY = _mm_set1_ps( extents.Y );
+		__m128 extentZ = _mm_set1_ps( extents.Z );
+		__m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+		__m128 zero = _mm_setzero_ps();
+
+		u32 mask = 0;
+		s32 groupCount = ( m_viewCount + 3 ) / 4;
+
+		for( s32 group = 0; group < groupCount; ++group )
+		{
+			__m128 outside = zero;
+
+			for( s32 side = 0; side < Frustum::Side::Count; ++side )
+			{
+				const PlaneGroup& planes = m_planes[ group ][ side ];
+
+				__m128 normalX = _mm_loadu_ps( planes.NormalX );
+				__m128 normalY = _mm_loadu_ps( planes.NormalY );
+				__m128 normalZ = _mm_loadu_ps( planes.NormalZ );
+
+				__m128 distance = _mm_add_ps( _mm_add_ps( _mm_add_ps(
+					_mm_mul_ps( normalX, centerX ),
+					_mm_mul_ps( normalY, centerY ) ),
+					_mm_mul_ps( normalZ, centerZ ) ),
+					_mm_loadu_ps( planes.Distance ) );
+
+				__m128 radius = _mm_add_ps( _mm_add_ps(
+					_mm_mul_ps( _mm_and_ps( normalX, absMask ), extentX ),
+					_mm_mul_ps( _mm_and_ps( normalY, absMask ), extentY ) ),
+					_mm_mul_ps( _mm_and_ps( normalZ, absMask ), extentZ ) );
+
+				outside = _mm_or_ps( outside, _mm_cmplt_ps( _mm_add_ps( distance, radius ), zero ) );
+			}
+
+			mask |= static_cast<u32>( ~_mm_movemask_ps( outside ) & 0xf ) << ( group * 4 );
+		}
+
+		return mask;
+	}
+
+	void MultiViewCuller::Test( const BoundingBox* pBoxes, s32 count, u32* pMasks ) const
+	{
+		Assert( count == 0 || pBoxes != NULL );
+		Assert( count == 0 || pMasks != NULL );
+
+		TestBody body( *this, pBoxes, pMasks );
+		Parallel::For( 0, count, 256, body );
+	}
+}
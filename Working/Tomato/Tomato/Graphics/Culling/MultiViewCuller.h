@@ -0,0 +1,52 @@
+#pragma once
+
+namespace Tomato
+{
+	// Culls objects against up to 32 views in a single pass.
+	//
+	// Shadow cube faces, cascades and split-screen views are set once per frame; every
+	// bounding box is then read once and tested against all frustums, four views per SSE
+	// instruction. Bit i of the returned mask is set when the box may be visible in view i.
+	class TOMATO_API MultiViewCuller
+	{
+	public:
+		enum { MaxViewCount = 32 };
+
+		MultiViewCuller();
+		~MultiViewCuller();
+
+	public:
+		// Builds one frustum per row-vector view-projection matrix.
+		void SetViews( const Matrix4* pViewProjections, s32 count );
+
+		s32 GetViewCount() const { return m_viewCount; }
+		const Frustum& GetFrustum( s32 view ) const;
+
+		u32 Test( const BoundingBox& box ) const;
+
+		// Test for many boxes, spread over the worker threads.
+		void Test( const BoundingBox* pBoxes, s32 count, u32* pMasks ) const;
+
+	private:
+		MultiViewCuller( const MultiViewCuller& copy );
+		MultiViewCuller& operator = ( const MultiViewCuller& copy );
+
+		class TestBody;
+
+		enum { GroupCount = MaxViewCount / 4 };
+
+		// Per group of four views and per frustum side: normal X, Y, Z and distance, one lane per view.
+		struct PlaneGroup
+		{
+			f32 NormalX[ 4 ];
+			f32 NormalY[ 4 ];
+			f32 NormalZ[ 4 ];
+			f32 Distance[ 4 ];
+		};
+
+	private:
+		s32 m_viewCount;
+		Frustum m_frustums[ MaxViewCount ];
+		PlaneGroup m_planes[ GroupCount ][ Frustum::Side::Count ];
+	};
+}
@@ -0,0 +1,583 @@
+#include "TomatoPCH.h"
+
+#include "OcclusionBuffer.h"
+
+#include <cmath>
+#include <malloc.h>
+#include <emmintrin.h>
+
+namespace Tomato
+{
+	namespace
+	{
+		enum
+		{
+			TrianglesPerBatch = 256,
+
+			// Near clipping turns a triangle into at most two.
+			MaxTrianglesPerBatch = TrianglesPerBatch * 2,
+		};
+
+		f32 HorizontalMin( __m128 v )
+		{
+			v = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+			v = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+			return _mm_cvtss_f32( v );
+		}
+
+		f32 HorizontalMax( __m128 v )
+		{
+			v = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+			v = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+			return _mm_cvtss_f32( v );
+		}
+
+		s32 RoundUp( s32 value, s32 multiple )
+		{
+			return ( ( value + multiple - 1 ) / multiple ) * multiple;
+		}
+
+		// Intersection of edge a-b with the plane z = 0.
+		Vector4 ClipToNearPlane( const Vector4& a, const Vector4& b )
+		{
+			f32 t = a.Z / ( a.Z - b.Z );
+			return Vector4::Lerp( a, b, t );
+		}
+	}
+
+	class OcclusionBuffer::BinBody
+	{
+	public:
+		BinBody( OcclusionBuffer& buffer ) : m_buffer( buffer ) { }
+
+		void operator () ( s32 begin, s32 end )
+		{
+			for( s32 i = begin; i < end; ++i )
+			{
+				m_buffer.BinBatch( i );
+			}
+		}
+
+	private:
+		BinBody& operator = ( const BinBody& );
+
+		OcclusionBuffer& m_buffer;
+	};
+
+	class OcclusionBuffer::RasterizeBody
+	{
+	public:
+		RasterizeBody( OcclusionBuffer& buffer ) : m_buffer( buffer ) { }
+
+		void operator () ( s32 begin, s32 end )
+		{
+			for( s32 i = begin; i < end; ++i )
+			{
+				m_buffer.RasterizeTile( i );
+			}
+		}
+
+	private:
+		RasterizeBody& operator = ( const RasterizeBody& );
+
+		OcclusionBuffer& m_buffer;
+	};
+
+	class OcclusionBuffer::TestBody
+	{
+	public:
+		TestBody( const OcclusionBuffer& buffer, const BoundingBox* pBoxes, bool* pVisible )
+			: m_buffer( buffer )
+			, m_pBoxes( pBoxes )
+			, m_pVisible( pVisible )
+		{
+		}
+
+		void operator () ( s32 begin, s32 end )
+		{
+			for( s32 i = begin; i < end; ++i )
+			{
+				m_pVisible[ i ] = m_buffer.IsVisible( m_pBoxes[ i ] );
+			}
+		}
+
+	private:
+		TestBody& operator = ( const TestBody& );
+
+		const OcclusionBuffer& m_buffer;
+		const BoundingBox* m_pBoxes;
+		bool* m_pVisible;
+	};
+
+	OcclusionBuffer::OcclusionBuffer( s32 width, s32 height )
+		: m_width( width )
+		, m_height( height )
+		, m_pitch( RoundUp( width, TileWidth ) )
+		, m_paddedHeight( RoundUp( height, TileHeight ) )
+		, m_tileCountX( 0 )
+		, m_tileCountY( 0 )
+		, m_blockCountX( 0 )
+		, m_pDepth( NULL )
+		, m_pBlockMaxDepth( NULL )
+		, m_viewProjection( Matrix4::CreateIdentity() )
+		, m_occluders()
+		, m_batches()
+		, m_bins()
+	{
+		Assert( width > 0 );
+		Assert( height > 0 );
+
+		m_tileCountX = m_pitch / TileWidth;
+		m_tileCountY = m_paddedHeight / TileHeight;
+		m_blockCountX = m_pitch / BlockSize;
+
+		m_pDepth = static_cast<f32*>( _aligned_malloc( m_pitch * m_paddedHeight * sizeof( f32 ), 16 ) );
+		m_pBlockMaxDepth = static_cast<f32*>( _aligned_malloc( ( m_pitch / BlockSize ) * ( m_paddedHeight / BlockSize ) * sizeof( f32 ), 16 ) );
+
+		Clear( m_viewProjection );
+	}
+
+	OcclusionBuffer::~OcclusionBuffer()
+	{
+		_aligned_free( m_pDepth );
+		_aligned_free( m_pBlockMaxDepth );
+	}
+
+	void OcclusionBuffer::Clear( const Matrix4& viewProjection )
+	{
+		m_viewProjection = viewProjection;
+
+		__m128 farthest = _mm_set1_ps( 1.0f );
+
+		s32 depthCount = m_pitch * m_paddedHeight;
+		for( s32 i = 0; i < depthCount; i += 4 )
+		{
+			_mm_store_ps( m_pDepth + i, farthest );
+		}
+
+		s32 blockCount = ( m_pitch / BlockSize ) * ( m_paddedHeight / BlockSize );
+		for( s32 i = 0; i < blockCount; ++i )
+		{
+			m_pBlockMaxDepth[ i ] = 1.0f;
+		}
+
+		m_occluders.clear();
+		m_batches.clear();
+	}
+
+	void OcclusionBuffer::AddOccluder( const Matrix4& world, const Vector3* pVertices, s32 vertexCount, const u32* pIndices, s32 indexCount )
+	{
+		Assert( pVertices != NULL );
+		Assert( pIndices != NULL );
+		Assert( ( indexCount % 3 ) == 0 );
+
+		Occluder occluder;
+		occluder.WorldViewProjection = world * m_viewProjection;
+		occluder.pVertices = pVertices;
+		occluder.pIndices = pIndices;
+		occluder.VertexCount = vertexCount;
+		occluder.TriangleCount = indexCount / 3;
+
+		s32 occluderIndex = static_cast<s32>( m_occluders.size() );
+		m_occluders.push_back( occluder );
+
+		for( s32 first = 0; first < occluder.TriangleCount; first += TrianglesPerBatch )
+		{
+			Batch batch;
+			batch.OccluderIndex = occluderIndex;
+			batch.FirstTriangle = first;
+			batch.TriangleCount = Math::Min( static_cast<s32>( TrianglesPerBatch ), occluder.TriangleCount - first );
+
+			m_batches.push_back( batch );
+		}
+	}
+
+	void OcclusionBuffer::Rasterize()
+	{
+		s32 batchCount = static_cast<s32>( m_batches.size() );
+		s32 tileCount = m_tileCountX * m_tileCountY;
+
+		if( static_cast<s32>( m_bins.size() ) < batchCount )
+		{
+			m_bins.resize( batchCount );
+		}
+
+		BinBody binBody( *this );
+		Parallel::For( 0, batchCount, 1, binBody );
+
+		RasterizeBody rasterizeBody( *this );
+		Parallel::For( 0, tileCount, 1, rasterizeBody );
+	}
+
+	void OcclusionBuffer::BinBatch( s32 batchIndex )
+	{
+		const Batch& batch = m_batches[ batchIndex ];
+		const Occluder& occluder = m_occluders[ batch.OccluderIndex ];
+
+		BatchBins& bins = m_bins[ batchIndex ];
+		bins.Triangles.clear();
+		bins.Triangles.reserve( MaxTrianglesPerBatch );
+		bins.Tiles.resize( m_tileCountX * m_tileCountY );
+		for( size_t i = 0; i < bins.Tiles.size(); ++i )
+		{
+			bins.Tiles[ i ].clear();
+		}
+
+		const u32* pIndices = occluder.pIndices + batch.FirstTriangle * 3;
+
+		for( s32 i = 0; i < batch.TriangleCount; ++i )
+		{
+			Vector4 clip[ 3 ];
+			s32 behindCount = 0;
+
+			for( s32 j = 0; j < 3; ++j )
+			{
+				u32 index = pIndices[ i * 3 + j ];
+				Assert( static_cast<s32>( index ) < occluder.VertexCount );
+
+				Matrix4::Transform( occluder.WorldViewProjection, Vector4( occluder.pVertices[ index ], 1.0f ), clip[ j ] );
+
+				if( clip[ j ].Z < 0.0f )
+				{
+					++behindCount;
+				}
+			}
+
+			if( ( clip[ 0 ].X > clip[ 0 ].W && clip[ 1 ].X > clip[ 1 ].W && clip[ 2 ].X > clip[ 2 ].W )
+				|| ( clip[ 0 ].X < -clip[ 0 ].W && clip[ 1 ].X < -clip[ 1 ].W && clip[ 2 ].X < -clip[ 2 ].W )
+				|| ( clip[ 0 ].Y > clip[ 0 ].W && clip[ 1 ].Y > clip[ 1 ].W && clip[ 2 ].Y > clip[ 2 ].W )
+				|| ( clip[ 0 ].Y < -clip[ 0 ].W && clip[ 1 ].Y < -clip[ 1 ].W && clip[ 2 ].Y < -clip[ 2 ].W )
+				|| ( clip[ 0 ].Z > clip[ 0 ].W && clip[ 1 ].Z > clip[ 1 ].W && clip[ 2 ].Z > clip[ 2 ].W ) )
+			{
+				continue;
+			}
+
+			if( behindCount == 0 )
+			{
+				SetupTriangle( clip, bins );
+			}
+			else if( behindCount < 3 )
+			{
+				// Sutherland-Hodgman against the near plane.
+				Vector4 polygon[ 4 ];
+				s32 polygonCount = 0;
+
+				for( s32 j = 0; j < 3; ++j )
+				{
+					const Vector4& a = clip[ j ];
+					const Vector4& b = clip[ ( j + 1 ) % 3 ];
+
+					if( a.Z >= 0.0f )
+					{
+						polygon[ polygonCount++ ] = a;
+					}
+
+					if( ( a.Z >= 0.0f ) != ( b.Z >= 0.0f ) )
+					{
+						polygon[ polygonCount++ ] = ClipToNearPlane( a, b );
+					}
+				}
+
+				for( s32 j = 2; j < polygonCount; ++j )
+				{
+					Vector4 fan[ 3 ] = { polygon[ 0 ], polygon[ j - 1 ], polygon[ j ] };
+					SetupTriangle( fan, bins );
+				}
+			}
+		}
+	}
+
+	void OcclusionBuffer::SetupTriangle( const Vector4* pClip, BatchBins& bins )
+	{
+		f32 x[ 3 ];
+		f32 y[ 3 ];
+		f32 z[ 3 ];
+
+		f32 halfWidth = 0.5f * static_cast<f32>( m_width );
+		f32 halfHeight = 0.5f * static_cast<f32>( m_height );
+
+		for( s32 i = 0; i < 3; ++i )
+		{
+			f32 invW = 1.0f / pClip[ i ].W;
+			x[ i ] = ( pClip[ i ].X * invW + 1.0f ) * halfWidth;
+			y[ i ] = ( 1.0f - pClip[ i ].Y * invW ) * halfHeight;
+			z[ i ] = pClip[ i ].Z * invW;
+		}
+
+		f32 area = ( x[ 1 ] - x[ 0 ] ) * ( y[ 2 ] - y[ 0 ] ) - ( x[ 2 ] - x[ 0 ] ) * ( y[ 1 ] - y[ 0 ] );
+		if( Math::CompareFloatZero( area ) )
+		{
+			return;
+		}
+
+		// Both faces are drawn: flip back faces so the inside is where all edge functions are positive.
+		if( area < 0.0f )
+		{
+			std::swap( x[ 1 ], x[ 2 ] );
+			std::swap( y[ 1 ], y[ 2 ] );
+			std::swap( z[ 1 ], z[ 2 ] );
+			area = -area;
+		}
+
+		f32 minX = Math::Min( x[ 0 ], Math::Min( x[ 1 ], x[ 2 ] ) );
+		f32 maxX = Math::Max( x[ 0 ], Math::Max( x[ 1 ], x[ 2 ] ) );
+		f32 minY = Math::Min( y[ 0 ], Math::Min( y[ 1 ], y[ 2 ] ) );
+		f32 maxY = Math::Max( y[ 0 ], Math::Max( y[ 1 ], y[ 2 ] ) );
+
+		// Pixels whose centers lie inside the bounds.
+		Triangle triangle;
+		triangle.MinX = Math::Max( static_cast<s32>( ::ceilf( minX - 0.5f ) ), 0 );
+		triangle.MaxX = Math::Min( static_cast<s32>( ::floorf( maxX - 0.5f ) ), m_width - 1 );
+		triangle.MinY = Math::Max( static_cast<s32>( ::ceilf( minY - 0.5f ) ), 0 );
+		triangle.MaxY = Math::Min( static_cast<s32>( ::floorf( maxY - 0.5f ) ), m_height - 1 );
+
+		if( triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY )
+		{
+			return;
+		}
+
+		// Edge functions and depth are evaluated at integer pixel coordinates; the half pixel offset is folded into C.
+		for( s32 i = 0; i < 3; ++i )
+		{
+			s32 j = ( i + 1 ) % 3;
+
+			f32 a = y[ i ] - y[ j ];
+			f32 b = x[ j ] - x[ i ];
+			f32 c = -( a * x[ i ] + b * y[ i ] );
+
+			triangle.EdgeA[ i ] = a;
+			triangle.EdgeB[ i ] = b;
+			triangle.EdgeC[ i ] = c + 0.5f * ( a + b );
+		}
+
+		f32 invArea = 1.0f / area;
+		f32 depthA = ( ( z[ 1 ] - z[ 0 ] ) * ( y[ 2 ] - y[ 0 ] ) - ( z[ 2 ] - z[ 0 ] ) * ( y[ 1 ] - y[ 0 ] ) ) * invArea;
+		f32 depthB = ( ( z[ 2 ] - z[ 0 ] ) * ( x[ 1 ] - x[ 0 ] ) - ( z[ 1 ] - z[ 0 ] ) * ( x[ 2 ] - x[ 0 ] ) ) * invArea;
+
+		triangle.DepthA = depthA;
+		triangle.DepthB = depthB;
+		triangle.DepthC = z[ 0 ] - depthA * x[ 0 ] - depthB * y[ 0 ] + 0.5f * ( depthA + depthB );
+
+		u16 triangleIndex = static_cast<u16>( bins.Triangles.size() );
+		bins.Triangles.push_back( triangle );
+
+		s32 tileMinX = triangle.MinX / TileWidth;
+		s32 tileMaxX = triangle.MaxX / TileWidth;
+		s32 tileMinY = triangle.MinY / TileHeight;
+		s32 tileMaxY = triangle.MaxY / TileHeight;
+
+		for( s32 ty = tileMinY; ty <= tileMaxY; ++ty )
+		{
+			for( s32 tx = tileMinX; tx <= tileMaxX; ++tx )
+			{
+				bins.Tiles[ ty * m_tileCountX + tx ].push_back( triangleIndex );
+			}
+		}
+	}
+
+	void OcclusionBuffer::RasterizeTile( s32 tileIndex )
+	{
+		s32 tileX = ( tileIndex % m_tileCountX ) * TileWidth;
+		s32 tileY = ( tileIndex / m_tileCountX ) * TileHeight;
+
+		const __m128 columnOffsets = _mm_setr_ps( 0.0f, 1.0f, 2.0f, 3.0f );
+		const __m128 zero = _mm_setzero_ps();
+
+		// Batches are visited in submission order so the result does not depend on thread timing.
+		s32 batchCount = static_cast<s32>( m_batches.size() );
+		for( s32 batchIndex = 0; batchIndex < batchCount; ++batchIndex )
+		{
+			const BatchBins& bins = m_bins[ batchIndex ];
+			const std::vector<u16>& tile = bins.Tiles[ tileIndex ];
+
+			for( size_t i = 0; i < tile.size(); ++i )
+			{
+				const Triangle& triangle = bins.Triangles[ tile[ i ] ];
+
+				// Rows start on a 4 pixel boundary; tiles are a multiple of 4 wide so no quad crosses into a neighbour.
+				s32 x0 = Math::Max( triangle.MinX, tileX ) & ~3;
+				s32 x1 = Math::Min( triangle.MaxX, tileX + TileWidth - 1 );
+				s32 y0 = Math::Max( triangle.MinY, tileY );
+				s32 y1 = Math::Min( triangle.MaxY, tileY + TileHeight - 1 );
+
+				f32 fx0 = static_cast<f32>( x0 );
+
+				__m128 edgeA0 = _mm_set1_ps( triangle.EdgeA[ 0 ] );
+				__m128 edgeA1 = _mm_set1_ps( triangle.EdgeA[ 1 ] );
+				__m128 edgeA2 = _mm_set1_ps( triangle.EdgeA[ 2 ] );
+				__m128 depthA = _mm_set1_ps( triangle.DepthA );
+
+				__m128 edgeStep0 = _mm_set1_ps( triangle.EdgeA[ 0 ] * 4.0f );
+				__m128 edgeStep1 = _mm_set1_ps( triangle.EdgeA[ 1 ] * 4.0f );
+				__m128 edgeStep2 = _mm_set1_ps( triangle.EdgeA[ 2 ] * 4.0f );
+				__m128 depthStep = _mm_set1_ps( triangle.DepthA * 4.0f );
+
+				for( s32 y = y0; y <= y1; ++y )
+				{
+					f32 fy = static_cast<f32>( y );
+
+					__m128 edge0 = _mm_add_ps( _mm_set1_ps( triangle.EdgeA[ 0 ] * fx0 + triangle.EdgeB[ 0 ] * fy + triangle.EdgeC[ 0 ] ), _mm_mul_ps( edgeA0, columnOffsets ) );
+					__m128 edge1 = _mm_add_ps( _mm_set1_ps( triangle.EdgeA[ 1 ] * fx0 + triangle.EdgeB[ 1 ] * fy + triangle.EdgeC[ 1 ] ), _mm_mul_ps( edgeA1, columnOffsets ) );
+					__m128 edge2 = _mm_add_ps( _mm_set1_ps( triangle.EdgeA[ 2 ] * fx0 + triangle.EdgeB[ 2 ] * fy + triangle.EdgeC[ 2 ] ), _mm_mul_ps( edgeA2, columnOffsets ) );
+					__m128 depth = _mm_add_ps( _mm_set1_ps( triangle.DepthA * fx0 + triangle.DepthB * fy + triangle.DepthC ), _mm_mul_ps( depthA, columnOffsets ) );
+
+					f32* pRow = m_pDepth + y * m_pitch;
+
+					for( s32 x = x0; x <= x1; x += 4 )
+					{
+						__m128 inside = _mm_and_ps(
+							_mm_and_ps( _mm_cmpge_ps( edge0, zero ), _mm_cmpge_ps( edge1, zero ) ),
+							_mm_cmpge_ps( edge2, zero ) );
+
+						if( _mm_movemask_ps( inside ) != 0 )
+						{
+							__m128 current = _mm_load_ps( pRow + x );
+							__m128 nearest = _mm_min_ps( current, depth );
+
+							_mm_store_ps( pRow + x, _mm_or_ps( _mm_and_ps( inside, nearest ), _mm_andnot_ps( inside, current ) ) );
+						}
+
+						edge0 = _mm_add_ps( edge0, edgeStep0 );
+						edge1 = _mm_add_ps( edge1, edgeStep1 );
+						edge2 = _mm_add_ps( edge2, edgeStep2 );
+						depth = _mm_add_ps( depth, depthStep );
+					}
+				}
+			}
+		}
+
+		// Farthest depth of every 8x8 block in the tile.
+		for( s32 by = tileY; by < tileY + TileHeight; by += BlockSize )
+		{
+			for( s32 bx = tileX; bx < tileX + TileWidth; bx += BlockSize )
+			{
+				__m128 farthest = _mm_setzero_ps();
+
+				for( s32 y = by; y < by + BlockSize; ++y )
+				{
+					const f32* pRow = m_pDepth + y * m_pitch + bx;
+					farthest = _mm_max_ps( farthest, _mm_max_ps( _mm_load_ps( pRow ), _mm_load_ps( pRow + 4 ) ) );
+				}
+
+				m_pBlockMaxDepth[ ( by / BlockSize ) * m_blockCountX + ( bx / BlockSize ) ] = HorizontalMax( farthest );
+			}
+		}
+	}
+
+	bool OcclusionBuffer::IsVisible( const BoundingBox& box ) const
+	{
+		const Matrix4& m = m_viewProjection;
+
+		// The 8 corners as two groups of 4, one group per Z slab.
+		__m128 cornerX = _mm_setr_ps( box.Min.X, box.Max.X, box.Min.X, box.Max.X );
+		__m128 cornerY = _mm_setr_ps( box.Min.Y, box.Min.Y, box.Max.Y, box.Max.Y );
+
+		__m128 partialX = _mm_add_ps( _mm_add_ps( _mm_mul_ps( cornerX, _mm_set1_ps( m.M[ 0 ][ 0 ] ) ), _mm_mul_ps( cornerY, _mm_set1_ps( m.M[ 1 ][ 0 ] ) ) ), _mm_set1_ps( m.M[ 3 ][ 0 ] ) );
+		__m128 partialY = _mm_add_ps( _mm_add_ps( _mm_mul_ps( cornerX, _mm_set1_ps( m.M[ 0 ][ 1 ] ) ), _mm_mul_ps( cornerY, _mm_set1_ps( m.M[ 1 ][ 1 ] ) ) ), _mm_set1_ps( m.M[ 3 ][ 1 ] ) );
+		__m128 partialZ = _mm_add_ps( _mm_add_ps( _mm_mul_ps( cornerX, _mm_set1_ps( m.M[ 0 ][ 2 ] ) ), _mm_mul_ps( cornerY, _mm_set1_ps( m.M[ 1 ][ 2 ] ) ) ), _mm_set1_ps( m.M[ 3 ][ 2 ] ) );
+		__m128 partialW = _mm_add_ps( _mm_add_ps( _mm_mul_ps( cornerX, _mm_set1_ps( m.M[ 0 ][ 3 ] ) ), _mm_mul_ps( cornerY, _mm_set1_ps( m.M[ 1 ][ 3 ] ) ) ), _mm_set1_ps( m.M[ 3 ][ 3 ] ) );
+
+		__m128 minScreenX = _mm_set1_ps( Math::FloatPositiveMax );
+		__m128 maxScreenX = _mm_set1_ps( -Math::FloatPositiveMax );
+		__m128 minScreenY = _mm_set1_ps( Math::FloatPositiveMax );
+		__m128 maxScreenY = _mm_set1_ps( -Math::FloatPositiveMax );
+		__m128 minDepth = _mm_set1_ps( Math::FloatPositiveMax );
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 half = _mm_set1_ps( 0.5f );
+		const __m128 width = _mm_set1_ps( static_cast<f32>( m_width ) );
+		const __m128 height = _mm_set1_ps( static_cast<f32>( m_height ) );
+
+		for( s32 slab = 0; slab < 2; ++slab )
+		{
+			__m128 cornerZ = _mm_set1_ps( ( slab == 0 ) ? box.Min.Z : box.Max.Z );
+
+			__m128 clipX = _mm_add_ps( partialX, _mm_mul_ps( cornerZ, _mm_set1_ps( m.M[ 2 ][ 0 ] ) ) );
+			__m128 clipY = _mm_add_ps( partialY, _mm_mul_ps( cornerZ, _mm_set1_ps( m.M[ 2 ][ 1 ] ) ) );
+			__m128 clipZ = _mm_add_ps( partialZ, _mm_mul_ps( cornerZ, _mm_set1_ps( m.M[ 2 ][ 2 ] ) ) );
+			__m128 clipW = _mm_add_ps( partialW, _mm_mul_ps( cornerZ, _mm_set1_ps( m.M[ 2 ][ 3 ] ) ) );
+
+			// Crossing the near plane: the projected bounds are meaningless.
+			if( _mm_movemask_ps( _mm_or_ps( _mm_cmplt_ps( clipZ, zero ), _mm_cmple_ps( clipW, zero ) ) ) != 0 )
+			{
+				return true;
+			}
+
+			__m128 invW = _mm_div_ps( _mm_set1_ps( 1.0f ), clipW );
+
+			__m128 screenX = _mm_mul_ps( _mm_add_ps( _mm_mul_ps( _mm_mul_ps( clipX, invW ), half ), half ), width );
+			__m128 screenY = _mm_mul_ps( _mm_sub_ps( half, _mm_mul_ps( _mm_mul_ps( clipY, invW ), half ) ), height );
+
+			minScreenX = _mm_min_ps( minScreenX, screenX );
+			maxScreenX = _mm_max_ps( maxScreenX, screenX );
+			minScreenY = _mm_min_ps( minScreenY, screenY );
+			maxScreenY = _mm_max_ps( maxScreenY, screenY );
+			minDepth = _mm_min_ps( minDepth, _mm_mul_ps( clipZ, invW ) );
+		}
+
+		f32 nearestDepth = HorizontalMin( minDepth );
+
+		// Every pixel the projected box touches.
+		s32 x0 = static_cast<s32>( ::floorf( HorizontalMin( minScreenX ) ) );
+		s32 x1 = static_cast<s32>( ::floorf( HorizontalMax( maxScreenX ) ) );
+		s32 y0 = static_cast<s32>( ::floorf( HorizontalMin( minScreenY ) ) );
+		s32 y1 = static_cast<s32>( ::floorf( HorizontalMax( maxScreenY ) ) );
+
+		if( x1 < 0 || y1 < 0 || x0 >= m_width || y0 >= m_height )
+		{
+			return true;
+		}
+
+		x0 = Math::Max( x0, 0 );
+		y0 = Math::Max( y0, 0 );
+		x1 = Math::Min( x1, m_width - 1 );
+		y1 = Math::Min( y1, m_height - 1 );
+
+		__m128 boxDepth = _mm_set1_ps( nearestDepth );
+		__m128i firstColumn = _mm_set1_epi32( x0 - 1 );
+		__m128i lastColumn = _mm_set1_epi32( x1 + 1 );
+		const __m128i columnOffsets = _mm_setr_epi32( 0, 1, 2, 3 );
+
+		for( s32 by = y0 / BlockSize; by <= y1 / BlockSize; ++by )
+		{
+			for( s32 bx = x0 / BlockSize; bx <= x1 / BlockSize; ++bx )
+			{
+				if( nearestDepth > m_pBlockMaxDepth[ by * m_blockCountX + bx ] )
+				{
+					continue;
+				}
+
+				s32 rowBegin = Math::Max( by * BlockSize, y0 );
+				s32 rowEnd = Math::Min( by * BlockSize + BlockSize - 1, y1 );
+
+				for( s32 y = rowBegin; y <= rowEnd; ++y )
+				{
+					const f32* pRow = m_pDepth + y * m_pitch;
+
+					for( s32 x = bx * BlockSize; x < bx * BlockSize + BlockSize; x += 4 )
+					{
+						__m128i columns = _mm_add_epi32( _mm_set1_epi32( x ), columnOffsets );
+						__m128 inside = _mm_castsi128_ps( _mm_and_si128( _mm_cmpgt_epi32( columns, firstColumn ), _mm_cmplt_epi32( columns, lastColumn ) ) );
+
+						__m128 uncovered = _mm_and_ps( inside, _mm_cmple_ps( boxDepth, _mm_load_ps( pRow + x ) ) );
+						if( _mm_movemask_ps( uncovered ) != 0 )
+						{
+							return true;
+						}
+					}
+				}
+			}
+		}
+
+		return false;
+	}
+
+	void OcclusionBuffer::TestVisibility( const BoundingBox* pBoxes, s32 count, bool* pVisible ) const
+	{
+		Assert( pBoxes != NULL );
+		Assert( pVisible != NULL );
+
+		TestBody body( *this, pBoxes, pVisible );
+		Parallel::For( 0, count, 64, body );
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+namespace Tomato
+{
+	// Software depth buffer for occlusion culling.
+	//
+	// Occluder meshes are transformed to clip space, binned into screen tiles and rasterized
+	// into a low-resolution depth buffer without a GPU. Each 8x8 block keeps the farthest depth
+	// it holds, so bounding boxes can be rejected a block at a time before any pixel is read.
+	//
+	// Usage per frame:
+	//		Clear( viewProjection ) -> AddOccluder()... -> Rasterize() -> IsVisible() / TestVisibility()
+	//
+	// Depth follows the D3D convention of Matrix4::SetPerspectiveFovLH: z / w is 0 on the near
+	// plane and 1 on the far plane.
+	class TOMATO_API OcclusionBuffer
+	{
+	public:
+		enum
+		{
+			TileWidth = 32,
+			TileHeight = 32,
+
+			BlockSize = 8,
+		};
+
+		OcclusionBuffer( s32 width, s32 height );
+		~OcclusionBuffer();
+
+	public:
+		s32 GetWidth() const { return m_width; }
+		s32 GetHeight() const { return m_height; }
+
+		// Row pitch of GetDepthBuffer() in elements.
+		s32 GetPitch() const { return m_pitch; }
+		const f32* GetDepthBuffer() const { return m_pDepth; }
+
+		// Resets the depth buffer to the far plane and removes every occluder.
+		void Clear( const Matrix4& viewProjection );
+
+		// The vertex and index arrays are referenced, not copied, and must stay valid until Rasterize returns.
+		// Both faces of every triangle are rasterized.
+		void AddOccluder( const Matrix4& world, const Vector3* pVertices, s32 vertexCount, const u32* pIndices, s32 indexCount );
+
+		// Renders all occluders added since the last Clear.
+		void Rasterize();
+
+		// Returns false if the box is hidden behind the rasterized occluders.
+		// Boxes that cross the near plane or fall outside the screen are reported visible.
+		bool IsVisible( const BoundingBox& box ) const;
+
+		// IsVisible for many boxes, spread over the worker threads.
+		void TestVisibility( const BoundingBox* pBoxes, s32 count, bool* pVisible ) const;
+
+	private:
+		OcclusionBuffer( const OcclusionBuffer& copy );
+		OcclusionBuffer& operator = ( const OcclusionBuffer& copy );
+
+		struct Occluder
+		{
+			Matrix4 WorldViewProjection;
+			const Vector3* pVertices;
+			const u32* pIndices;
+			s32 VertexCount;
+			s32 TriangleCount;
+		};
+
+		struct Batch
+		{
+			s32 OccluderIndex;
+			s32 FirstTriangle;
+			s32 TriangleCount;
+		};
+
+		// Screen space edge functions and depth plane of a triangle.
+		struct Triangle
+		{
+			f32 EdgeA[ 3 ];
+			f32 EdgeB[ 3 ];
+			f32 EdgeC[ 3 ];
+
+			f32 DepthA;
+			f32 DepthB;
+			f32 DepthC;
+
+			s32 MinX;
+			s32 MinY;
+			s32 MaxX;
+			s32 MaxY;
+		};
+
+		// Triangles set up from one batch and, per tile, the triangles that overlap it.
+		struct BatchBins
+		{
+			std::vector<Triangle> Triangles;
+			std::vector< std::vector<u16> > Tiles;
+		};
+
+		class BinBody;
+		class RasterizeBody;
+		class TestBody;
+
+		void BinBatch( s32 batchIndex );
+		void SetupTriangle( const Vector4* pClip, BatchBins& bins );
+		void RasterizeTile( s32 tileIndex );
+
+	private:
+		s32 m_width;
+		s32 m_height;
+		s32 m_pitch;
+		s32 m_paddedHeight;
+
+		s32 m_tileCountX;
+		s32 m_tileCountY;
+
+		s32 m_blockCountX;
+
+		f32* m_pDepth;
+		f32* m_pBlockMaxDepth;
+
+		Matrix4 m_viewProjection;
+
+		std::vector<Occluder> m_occluders;
+		std::vector<Batch> m_batches;
+		std::vector<BatchBins> m_bins;
+	};
+}
@@ -0,0 +1,912 @@
+#include "TomatoPCH.h"
+
+#include "ConvexHull.h"
+
+#include <algorithm>
+#include <float.h>
+
+namespace Tomato
+{
+	namespace
+	{
+		// Edges are stored as half-edges, one per face side, so faces can be polygons.
+		struct HalfEdge
+		{
+			// Point the edge starts at; it ends where Next starts.
+			s32 Vertex;
+			s32 Face;
+
+			s32 Next;
+			s32 Previous;
+
+			// The same edge in the neighbouring face, running the other way.
+			s32 Twin;
+		};
+
+		struct Face
+		{
+			// Any edge of the face; the others follow through HalfEdge::Next.
+			s32 Edge;
+			s32 VertexCount;
+
+			Vector3 Normal;
+			f32 Distance;
+			Vector3 Centroid;
+
+			// Twice the area, used to decide which of two faces to trust when they disagree.
+			f32 Area;
+
+			// Points outside this face and not yet on the hull, and the farthest of them.
+			std::vector<s32> OutsidePoints;
+			s32 FarthestPoint;
+			f32 FarthestDistance;
+
+			// Convex with respect to the larger face only; merged again in the second pass.
+			bool bNonConvex;
+
+			bool bDeleted;
+		};
+
+		// Farthest outside point of a face when it was recorded; stale once the face changes.
+		struct EyeCandidate
+		{
+			f32 Distance;
+			s32 Face;
+			s32 Point;
+
+			// Orders a max heap by distance, then by the lower face index.
+			bool operator < ( const EyeCandidate& other ) const
+			{
+				return ( Distance < other.Distance ) || ( Distance == other.Distance && Face > other.Face );
+			}
+		};
+
+		struct MergeTest
+		{
+			enum Type
+			{
+				// Merges when the centroid of the smaller face is not clearly below the larger one.
+				NonConvexToLargerFace,
+
+				// Merges when either centroid is not clearly below the other face.
+				NonConvex,
+			};
+		};
+
+		class Quickhull
+		{
+		public:
+			Quickhull( const Vector3* pPoints, s32 count )
+				: m_pPoints( pPoints )
+				, m_count( count )
+				, m_tolerance( 0.0f )
+			{
+			}
+
+			bool Run( s32 maxVertexCount, std::vector<Vector3>& vertices, std::vector<u32>& indices, std::vector<Vector4>& planes )
+			{
+				ComputeTolerance();
+
+				s32 simplex[ 4 ];
+				if( !FindInitialSimplex( simplex ) )
+				{
+					return false;
+				}
+
+				BuildInitialHull( simplex );
+
+				s32 vertexCount = 4;
+
+				for( ;; )
+				{
+					if( maxVertexCount > 0 && vertexCount >= maxVertexCount )
+					{
+						break;
+					}
+
+					s32 eyeFace = PopEyeFace();
+					if( eyeFace < 0 )
+					{
+						break;
+					}
+
+					AddPoint( eyeFace, m_faces[ eyeFace ].FarthestPoint );
+					++vertexCount;
+				}
+
+				Output( vertices, indices, planes );
+				return true;
+			}
+
+		private:
+			// Distance scale of single precision rounding for coordinates of this magnitude.
+			void ComputeTolerance()
+			{
+				Vector3 maxAbs( 0.0f, 0.0f, 0.0f );
+
+				for( s32 i = 0; i < m_count; ++i )
+				{
+					for( s32 axis = 0; axis < 3; ++axis )
+					{
+						maxAbs[ axis ] = Math::Max( maxAbs[ axis ], Math::Abs( m_pPoints[ i ][ axis ] ) );
+					}
+				}
+
+				m_tolerance = 3.0f * FLT_EPSILON * ( maxAbs.X + maxAbs.Y + maxAbs.Z );
+			}
+
+			// The face with the point farthest outside any face; the first face wins ties.
+			s32 PopEyeFace()
+			{
+				while( !m_eyeCandidates.empty() )
+				{
+					std::pop_heap( m_eyeCandidates.begin(), m_eyeCandidates.end() );
+					EyeCandidate candidate = m_eyeCandidates.back();
+					m_eyeCandidates.pop_back();
+
+					const Face& face = m_faces[ candidate.Face ];
+					if( !face.bDeleted && face.FarthestPoint == candidate.Point && face.FarthestDistance == candidate.Distance
+						&& candidate.Distance > m_tolerance )
+					{
+						return candidate.Face;
+					}
+				}
+
+				return -1;
+			}
+
+			void SetFarthestPoint( s32 faceIndex, s32 point, f32 distance )
+			{
+				m_faces[ faceIndex ].FarthestPoint = point;
+				m_faces[ faceIndex ].FarthestDistance = distance;
+
+				EyeCandidate candidate;
+				candidate.Distance = distance;
+				candidate.Face = faceIndex;
+				candidate.Point = point;
+
+				m_eyeCandidates.push_back( candidate );
+				std::push_heap( m_eyeCandidates.begin(), m_eyeCandidates.end() );
+			}
+
+			f32 GetDistance( const Face& face, const Vector3& point ) const
+			{
+				return Vector3::Dot( face.Normal, point ) + face.Distance;
+			}
+
+			f32 GetDistance( const Face& face, s32 point ) const
+			{
+				return GetDistance( face, m_pPoints[ point ] );
+			}
+
+			s32 GetNeighbour( s32 edge ) const
+			{
+				return m_edges[ m_edges[ edge ].Twin ].Face;
+			}
+
+			bool FindInitialSimplex( s32* pSimplex )
+			{
+				if( m_count < 4 )
+				{
+					return false;
+				}
+
+				// The two most distant of the six axis extremes.
+				s32 extremes[ 6 ] = { 0, 0, 0, 0, 0, 0 };
+
+				for( s32 i = 1; i < m_count; ++i )
+				{
+					for( s32 axis = 0; axis < 3; ++axis )
+					{
+						if( m_pPoints[ i ][ axis ] < m_pPoints[ extremes[ axis * 2 ] ][ axis ] )
+						{
+							extremes[ axis * 2 ] = i;
+						}
+
+						if( m_pPoints[ i ][ axis ] > m_pPoints[ extremes[ axis * 2 + 1 ] ][ axis ] )
+						{
+							extremes[ axis * 2 + 1 ] = i;
+						}
+					}
+				}
+
+				f32 bestDistance = -1.0f;
+				for( s32 i = 0; i < 6; ++i )
+				{
+					for( s32 j = i + 1; j < 6; ++j )
+					{
+						f32 distance = ( m_pPoints[ extremes[ i ] ] - m_pPoints[ extremes[ j ] ] ).GetLengthSquared();
+						if( distance > bestDistance )
+						{
+							bestDistance = distance;
+							pSimplex[ 0 ] = extremes[ i ];
+							pSimplex[ 1 ] = extremes[ j ];
+						}
+					}
+				}
+
+				if( bestDistance <= m_tolerance * m_tolerance )
+				{
+					return false;
+				}
+
+				// The point farthest from the line through the first two.
+				const Vector3& a = m_pPoints[ pSimplex[ 0 ] ];
+				Vector3 direction = Vector3::Normalize( m_pPoints[ pSimplex[ 1 ] ] - a );
+
+				bestDistance = -1.0f;
+				for( s32 i = 0; i < m_count; ++i )
+				{
+					Vector3 offset = m_pPoints[ i ] - a;
+					f32 distance = ( offset - direction * Vector3::Dot( offset, direction ) ).GetLengthSquared();
+
+					if( distance > bestDistance )
+					{
+						bestDistance = distance;
+						pSimplex[ 2 ] = i;
+					}
+				}
+
+				if( bestDistance <= m_tolerance * m_tolerance )
+				{
+					return false;
+				}
+
+				// The point farthest from the plane through the first three.
+				Vector3 normal = Vector3::Normalize( Vector3::Cross( m_pPoints[ pSimplex[ 1 ] ] - a, m_pPoints[ pSimplex[ 2 ] ] - a ) );
+
+				bestDistance = -1.0f;
+				for( s32 i = 0; i < m_count; ++i )
+				{
+					f32 distance = Math::Abs( Vector3::Dot( normal, m_pPoints[ i ] - a ) );
+
+					if( distance > bestDistance )
+					{
+						bestDistance = distance;
+						pSimplex[ 3 ] = i;
+					}
+				}
+
+				return bestDistance > m_tolerance;
+			}
+
+			// Adds a triangle whose vertices are clockwise seen from outside; returns its index.
+			// The edges run v0 to v1, v1 to v2 and v2 to v0, starting with Face::Edge.
+			s32 AddFace( s32 v0, s32 v1, s32 v2 )
+			{
+				s32 faceIndex = static_cast<s32>( m_faces.size() );
+				s32 firstEdge = static_cast<s32>( m_edges.size() );
+				s32 vertices[ 3 ] = { v0, v1, v2 };
+
+				for( s32 i = 0; i < 3; ++i )
+				{
+					HalfEdge edge;
+					edge.Vertex = vertices[ i ];
+					edge.Face = faceIndex;
+					edge.Next = firstEdge + ( i + 1 ) % 3;
+					edge.Previous = firstEdge + ( i + 2 ) % 3;
+					edge.Twin = -1;
+
+					m_edges.push_back( edge );
+				}
+
+				Face face;
+				face.Edge = firstEdge;
+				face.FarthestPoint = -1;
+				face.FarthestDistance = 0.0f;
+				face.bNonConvex = false;
+				face.bDeleted = false;
+
+				m_faces.push_back( face );
+				ComputePlane( faceIndex );
+
+				return faceIndex;
+			}
+
+			void LinkEdges( s32 edge, s32 twin )
+			{
+				m_edges[ edge ].Twin = twin;
+				m_edges[ twin ].Twin = edge;
+			}
+
+			// Plane through the centroid with the summed normal of the fan of triangles, which
+			// stays stable for polygons that are not quite planar. Refreshes the farthest point.
+			void ComputePlane( s32 faceIndex )
+			{
+				Face& face = m_faces[ faceIndex ];
+
+				s32 edge = face.Edge;
+				const Vector3& origin = m_pPoints[ m_edges[ edge ].Vertex ];
+
+				Vector3 normal( 0.0f, 0.0f, 0.0f );
+				Vector3 sum = origin;
+				s32 vertexCount = 1;
+
+				edge = m_edges[ edge ].Next;
+				Vector3 previous = m_pPoints[ m_edges[ edge ].Vertex ] - origin;
+
+				while( edge != face.Edge )
+				{
+					sum += m_pPoints[ m_edges[ edge ].Vertex ];
+					++vertexCount;
+
+					edge = m_edges[ edge ].Next;
+					if( edge == face.Edge )
+					{
+						break;
+					}
+
+					Vector3 current = m_pPoints[ m_edges[ edge ].Vertex ] - origin;
+					normal += Vector3::Cross( previous, current );
+					previous = current;
+				}
+
+				face.VertexCount = vertexCount;
+				face.Area = normal.GetLength();
+				face.Normal = ( face.Area > 0.0f ) ? normal * ( 1.0f / face.Area ) : normal;
+				face.Centroid = sum * ( 1.0f / static_cast<f32>( vertexCount ) );
+				face.Distance = -Vector3::Dot( face.Normal, face.Centroid );
+
+				s32 farthestPoint = -1;
+				f32 farthestDistance = 0.0f;
+				for( size_t i = 0; i < face.OutsidePoints.size(); ++i )
+				{
+					f32 distance = GetDistance( face, face.OutsidePoints[ i ] );
+					if( farthestPoint < 0 || distance > farthestDistance )
+					{
+						farthestDistance = distance;
+						farthestPoint = face.OutsidePoints[ i ];
+					}
+				}
+
+				face.FarthestPoint = -1;
+				face.FarthestDistance = 0.0f;
+				if( farthestPoint >= 0 )
+				{
+					SetFarthestPoint( faceIndex, farthestPoint, farthestDistance );
+				}
+			}
+
+			void AddOutsidePoint( s32 faceIndex, s32 point, f32 distance )
+			{
+				Face& face = m_faces[ faceIndex ];
+				face.OutsidePoints.push_back( point );
+
+				if( face.FarthestPoint < 0 || distance > face.FarthestDistance )
+				{
+					SetFarthestPoint( faceIndex, point, distance );
+				}
+			}
+
+			// Empties a face that leaves the hull. Its points move to the face absorbing it when
+			// they are outside that face, and to m_orphans otherwise.
+			void ReleasePoints( s32 faceIndex, s32 absorbingFace )
+			{
+				std::vector<s32> points;
+				points.swap( m_faces[ faceIndex ].OutsidePoints );
+
+				for( size_t i = 0; i < points.size(); ++i )
+				{
+					f32 distance = ( absorbingFace >= 0 ) ? GetDistance( m_faces[ absorbingFace ], points[ i ] ) : 0.0f;
+					if( absorbingFace >= 0 && distance > m_tolerance )
+					{
+						AddOutsidePoint( absorbingFace, points[ i ], distance );
+					}
+					else
+					{
+						m_orphans.push_back( points[ i ] );
+					}
+				}
+			}
+
+			// Moves each point to the face it is farthest outside of; points inside every face are dropped.
+			void AssignPoints( const std::vector<s32>& points, const std::vector<s32>& faces )
+			{
+				for( size_t i = 0; i < points.size(); ++i )
+				{
+					s32 point = points[ i ];
+					s32 bestFace = -1;
+					f32 bestDistance = m_tolerance;
+
+					for( size_t j = 0; j < faces.size(); ++j )
+					{
+						if( m_faces[ faces[ j ] ].bDeleted )
+						{
+							continue;
+						}
+
+						f32 distance = GetDistance( m_faces[ faces[ j ] ], point );
+						if( distance > bestDistance )
+						{
+							bestDistance = distance;
+							bestFace = faces[ j ];
+						}
+					}
+
+					if( bestFace >= 0 )
+					{
+						AddOutsidePoint( bestFace, point, bestDistance );
+					}
+				}
+			}
+
+			void BuildInitialHull( const s32* pSimplex )
+			{
+				s32 a = pSimplex[ 0 ];
+				s32 b = pSimplex[ 1 ];
+				s32 c = pSimplex[ 2 ];
+				s32 d = pSimplex[ 3 ];
+
+				// Orient the base so that d is behind it.
+				Vector3 normal = Vector3::Cross( m_pPoints[ b ] - m_pPoints[ a ], m_pPoints[ c ] - m_pPoints[ a ] );
+				if( Vector3::Dot( normal, m_pPoints[ d ] - m_pPoints[ a ] ) > 0.0f )
+				{
+					s32 swap = b;
+					b = c;
+					c = swap;
+				}
+
+				m_faces.reserve( 64 );
+				m_edges.reserve( 192 );
+				AddFace( a, b, c );
+				AddFace( a, d, b );
+				AddFace( b, d, c );
+				AddFace( c, d, a );
+
+				// Each edge meets the edge of another face that runs between the same points the other way.
+				for( s32 i = 0; i < 12; ++i )
+				{
+					for( s32 j = 0; j < 12; ++j )
+					{
+						if( m_edges[ i ].Vertex == m_edges[ m_edges[ j ].Next ].Vertex
+							&& m_edges[ j ].Vertex == m_edges[ m_edges[ i ].Next ].Vertex )
+						{
+							m_edges[ i ].Twin = j;
+						}
+					}
+				}
+
+				std::vector<s32> points;
+				points.reserve( m_count );
+				for( s32 i = 0; i < m_count; ++i )
+				{
+					if( i != a && i != b && i != c && i != d )
+					{
+						points.push_back( i );
+					}
+				}
+
+				std::vector<s32> faces;
+				for( s32 i = 0; i < 4; ++i )
+				{
+					faces.push_back( i );
+				}
+
+				AssignPoints( points, faces );
+			}
+
+			// Deletes the faces the eye point sees, walking from the face entered through 'edge',
+			// and collects the horizon edges in order around the eye.
+			void FindHorizon( s32 eye, s32 faceIndex, s32 edge, std::vector<s32>& horizon )
+			{
+				m_faces[ faceIndex ].bDeleted = true;
+				ReleasePoints( faceIndex, -1 );
+
+				s32 firstEdge = ( edge < 0 ) ? m_faces[ faceIndex ].Edge : edge;
+				s32 current = ( edge < 0 ) ? firstEdge : m_edges[ edge ].Next;
+
+				do
+				{
+					s32 neighbour = GetNeighbour( current );
+
+					if( !m_faces[ neighbour ].bDeleted )
+					{
+						if( GetDistance( m_faces[ neighbour ], eye ) > m_tolerance )
+						{
+							FindHorizon( eye, neighbour, m_edges[ current ].Twin, horizon );
+						}
+						else
+						{
+							horizon.push_back( current );
+						}
+					}
+
+					current = m_edges[ current ].Next;
+				}
+				while( current != firstEdge );
+			}
+
+			void AddPoint( s32 eyeFace, s32 eye )
+			{
+				std::vector<s32> horizon;
+				m_orphans.clear();
+				FindHorizon( eye, eyeFace, -1, horizon );
+
+				// A cone of new faces from the horizon to the eye.
+				s32 horizonCount = static_cast<s32>( horizon.size() );
+
+				std::vector<s32> newFaces;
+				for( s32 i = 0; i < horizonCount; ++i )
+				{
+					const HalfEdge& edge = m_edges[ horizon[ i ] ];
+					s32 face = AddFace( edge.Vertex, m_edges[ edge.Next ].Vertex, eye );
+
+					LinkEdges( m_faces[ face ].Edge, m_edges[ horizon[ i ] ].Twin );
+					newFaces.push_back( face );
+				}
+
+				// Edge 1 of a new face runs to the eye and meets edge 2 of the next one.
+				for( s32 i = 0; i < horizonCount; ++i )
+				{
+					s32 edge = m_edges[ m_faces[ newFaces[ i ] ].Edge ].Next;
+					s32 nextEdge = m_edges[ m_faces[ newFaces[ ( i + 1 ) % horizonCount ] ].Edge ].Previous;
+
+					LinkEdges( edge, nextEdge );
+				}
+
+				// Rounding leaves some new faces slightly concave against their neighbours. Merging
+				// them, first where the larger face decides and then where either face does,
+				// keeps the hull convex (Barber et al., section 4).
+				for( s32 i = 0; i < horizonCount; ++i )
+				{
+					s32 face = newFaces[ i ];
+					while( !m_faces[ face ].bDeleted && !m_faces[ face ].bNonConvex && MergeAdjacentFace( face, MergeTest::NonConvexToLargerFace ) )
+					{
+					}
+				}
+
+				for( s32 i = 0; i < horizonCount; ++i )
+				{
+					s32 face = newFaces[ i ];
+					if( !m_faces[ face ].bDeleted && m_faces[ face ].bNonConvex )
+					{
+						m_faces[ face ].bNonConvex = false;
+						while( MergeAdjacentFace( face, MergeTest::NonConvex ) )
+						{
+						}
+					}
+				}
+
+				std::vector<s32> orphans;
+				for( size_t i = 0; i < m_orphans.size(); ++i )
+				{
+					if( m_orphans[ i ] != eye )
+					{
+						orphans.push_back( m_orphans[ i ] );
+					}
+				}
+
+				// Keeps the reassignment independent of the order the faces were visited in.
+				std::sort( orphans.begin(), orphans.end() );
+
+				AssignPoints( orphans, newFaces );
+			}
+
+			// Merges the first neighbour that fails the test into the face; returns false if none does.
+			bool MergeAdjacentFace( s32 faceIndex, MergeTest::Type test )
+			{
+				bool bConvex = true;
+
+				s32 edge = m_faces[ faceIndex ].Edge;
+				do
+				{
+					const Face& face = m_faces[ faceIndex ];
+					const Face& neighbour = m_faces[ GetNeighbour( edge ) ];
+
+					// How far each face's centroid is above the other face.
+					f32 neighbourDistance = GetDistance( face, neighbour.Centroid );
+					f32 faceDistance = GetDistance( neighbour, face.Centroid );
+
+					bool bMerge = false;
+					if( test == MergeTest::NonConvex )
+					{
+						bMerge = ( neighbourDistance > -m_tolerance || faceDistance > -m_tolerance );
+					}
+					else if( face.Area > neighbour.Area )
+					{
+						bMerge = ( neighbourDistance > -m_tolerance );
+						bConvex = bConvex && ( bMerge || faceDistance <= -m_tolerance );
+					}
+					else
+					{
+						bMerge = ( faceDistance > -m_tolerance );
+						bConvex = bConvex && ( bMerge || neighbourDistance <= -m_tolerance );
+					}
+
+					if( bMerge )
+					{
+						MergeFaces( faceIndex, edge );
+						return true;
+					}
+
+					edge = m_edges[ edge ].Next;
+				}
+				while( edge != m_faces[ faceIndex ].Edge );
+
+				if( !bConvex )
+				{
+					m_faces[ faceIndex ].bNonConvex = true;
+				}
+
+				return false;
+			}
+
+			// Absorbs the face on the other side of 'edge', including every other edge the two
+			// faces share, into faceIndex.
+			void MergeFaces( s32 faceIndex, s32 edge )
+			{
+				s32 discarded[ 3 ];
+				s32 discardedCount = 0;
+
+				s32 neighbour = GetNeighbour( edge );
+				m_faces[ neighbour ].bDeleted = true;
+				discarded[ discardedCount++ ] = neighbour;
+
+				s32 twin = m_edges[ edge ].Twin;
+				s32 previous = m_edges[ edge ].Previous;
+				s32 next = m_edges[ edge ].Next;
+				s32 twinPrevious = m_edges[ twin ].Previous;
+				s32 twinNext = m_edges[ twin ].Next;
+
+				// Extend over the whole run of shared edges.
+				while( GetNeighbour( previous ) == neighbour )
+				{
+					previous = m_edges[ previous ].Previous;
+					twinNext = m_edges[ twinNext ].Next;
+				}
+
+				while( GetNeighbour( next ) == neighbour )
+				{
+					twinPrevious = m_edges[ twinPrevious ].Previous;
+					next = m_edges[ next ].Next;
+				}
+
+				for( s32 current = twinNext; current != m_edges[ twinPrevious ].Next; current = m_edges[ current ].Next )
+				{
+					m_edges[ current ].Face = faceIndex;
+				}
+
+				m_faces[ faceIndex ].Edge = next;
+
+				s32 removed = ConnectEdges( faceIndex, twinPrevious, next );
+				if( removed >= 0 )
+				{
+					discarded[ discardedCount++ ] = removed;
+				}
+
+				removed = ConnectEdges( faceIndex, previous, twinNext );
+				if( removed >= 0 )
+				{
+					discarded[ discardedCount++ ] = removed;
+				}
+
+				ComputePlane( faceIndex );
+
+				for( s32 i = 0; i < discardedCount; ++i )
+				{
+					ReleasePoints( discarded[ i ], faceIndex );
+				}
+			}
+
+			// Joins two consecutive edges of the face. When both border the same neighbour, the
+			// point between them is redundant and is removed, and a triangle neighbour left with
+			// two sides along the face is deleted; its index is returned, -1 otherwise.
+			s32 ConnectEdges( s32 faceIndex, s32 previous, s32 edge )
+			{
+				s32 neighbour = GetNeighbour( edge );
+				if( GetNeighbour( previous ) != neighbour )
+				{
+					m_edges[ previous ].Next = edge;
+					m_edges[ edge ].Previous = previous;
+
+					return -1;
+				}
+
+				s32 removed = -1;
+				s32 twin = m_edges[ edge ].Twin;
+				s32 newTwin;
+
+				if( m_faces[ faceIndex ].Edge == previous )
+				{
+					m_faces[ faceIndex ].Edge = edge;
+				}
+
+				if( m_faces[ neighbour ].VertexCount == 3 )
+				{
+					// The neighbour's third edge takes the place of both shared edges.
+					newTwin = m_edges[ m_edges[ twin ].Previous ].Twin;
+
+					m_faces[ neighbour ].bDeleted = true;
+					removed = neighbour;
+				}
+				else
+				{
+					// The neighbour keeps the twin of 'previous', which now starts where 'twin' did.
+					newTwin = m_edges[ twin ].Next;
+
+					if( m_faces[ neighbour ].Edge == twin )
+					{
+						m_faces[ neighbour ].Edge = newTwin;
+					}
+
+					m_edges[ newTwin ].Vertex = m_edges[ twin ].Vertex;
+					m_edges[ newTwin ].Previous = m_edges[ twin ].Previous;
+					m_edges[ m_edges[ newTwin ].Previous ].Next = newTwin;
+				}
+
+				m_edges[ edge ].Vertex = m_edges[ previous ].Vertex;
+				m_edges[ edge ].Previous = m_edges[ previous ].Previous;
+				m_edges[ m_edges[ edge ].Previous ].Next = edge;
+
+				LinkEdges( edge, newTwin );
+
+				if( removed < 0 )
+				{
+					ComputePlane( neighbour );
+				}
+
+				return removed;
+			}
+
+			void Output( std::vector<Vector3>& vertices, std::vector<u32>& indices, std::vector<Vector4>& planes ) const
+			{
+				std::vector<s32> remap( m_count, -1 );
+				std::vector<u32> polygon;
+
+				for( size_t i = 0; i < m_faces.size(); ++i )
+				{
+					const Face& face = m_faces[ i ];
+					if( face.bDeleted )
+					{
+						continue;
+					}
+
+					polygon.clear();
+					s32 edge = face.Edge;
+					do
+					{
+						s32 point = m_edges[ edge ].Vertex;
+						if( remap[ point ] < 0 )
+						{
+							remap[ point ] = static_cast<s32>( vertices.size() );
+							vertices.push_back( m_pPoints[ point ] );
+						}
+
+						polygon.push_back( remap[ point ] );
+						edge = m_edges[ edge ].Next;
+					}
+					while( edge != face.Edge );
+
+					for( size_t k = 2; k < polygon.size(); ++k )
+					{
+						indices.push_back( polygon[ 0 ] );
+						indices.push_back( polygon[ k - 1 ] );
+						indices.push_back( polygon[ k ] );
+					}
+
+					planes.push_back( Vector4( face.Normal.X, face.Normal.Y, face.Normal.Z, GetOuterDistance( face ) ) );
+				}
+			}
+
+			// The plane goes through the centroid, and merging only keeps neighbours convex to
+			// within the tolerance. Moving it out past the vertices of every face that touches
+			// this one puts every vertex of the hull inside every plane.
+			f32 GetOuterDistance( const Face& face ) const
+			{
+				f32 distance = face.Distance;
+
+				s32 edge = face.Edge;
+				do
+				{
+					// The edges leaving this vertex, one per face around it.
+					s32 spoke = edge;
+					do
+					{
+						s32 current = spoke;
+						do
+						{
+							distance = Math::Min( distance, -Vector3::Dot( face.Normal, m_pPoints[ m_edges[ current ].Vertex ] ) );
+							current = m_edges[ current ].Next;
+						}
+						while( current != spoke );
+
+						spoke = m_edges[ m_edges[ spoke ].Twin ].Next;
+					}
+					while( spoke != edge );
+
+					edge = m_edges[ edge ].Next;
+				}
+				while( edge != face.Edge );
+
+				return distance;
+			}
+
+		private:
+			Quickhull& operator = ( const Quickhull& );
+
+			const Vector3* m_pPoints;
+			s32 m_count;
+			f32 m_tolerance;
+
+			std::vector<Face> m_faces;
+			std::vector<HalfEdge> m_edges;
+
+			// Points released by deleted faces during AddPoint.
+			std::vector<s32> m_orphans;
+
+			// Max heap of EyeCandidate, so that finding the next point does not visit every face.
+			std::vector<EyeCandidate> m_eyeCandidates;
+		};
+	}
+
+	class ConvexHull::BuildBody
+	{
+	public:
+		explicit BuildBody( Job* pJobs )
+			: m_pJobs( pJobs )
+		{
+		}
+
+		void operator () ( s32 begin, s32 end )
+		{
+			for( s32 i = begin; i < end; ++i )
+			{
+				Job& job = m_pJobs[ i ];
+				job.bResult = job.pHull->Build( job.pPoints, job.PointCount, job.Settings );
+			}
+		}
+
+	private:
+		BuildBody& operator = ( const BuildBody& );
+
+		Job* m_pJobs;
+	};
+
+	ConvexHull::Parameters::Parameters()
+		: MaxVertexCount( 0 )
+	{
+	}
+
+	ConvexHull::Job::Job()
+		: pPoints( NULL )
+		, PointCount( 0 )
+		, Settings()
+		, pHull( NULL )
+		, bResult( false )
+	{
+	}
+
+	ConvexHull::ConvexHull()
+	{
+	}
+
+	ConvexHull::~ConvexHull()
+	{
+	}
+
+	bool ConvexHull::Build( const Vector3* pPoints, s32 count, const Parameters& parameters )
+	{
+		Assert( count == 0 || pPoints != NULL );
+		Assert( parameters.MaxVertexCount == 0 || parameters.MaxVertexCount >= 4 );
+
+		Clear();
+
+		Quickhull quickhull( pPoints, count );
+		return quickhull.Run( parameters.MaxVertexCount, m_vertices, m_indices, m_planes );
+	}
+
+	void ConvexHull::Build( Job* pJobs, s32 count )
+	{
+		Assert( count == 0 || pJobs != NULL );
+
+		BuildBody body( pJobs );
+		Parallel::For( 0, count, 1, body );
+	}
+
+	void ConvexHull::Clear()
+	{
+		m_vertices.clear();
+		m_indices.clear();
+		m_planes.clear();
+	}
+}
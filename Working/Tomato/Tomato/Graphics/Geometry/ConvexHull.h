@@ -0,0 +1,71 @@
+#pragma once
+
+namespace Tomato
+{
+	// Convex hull of a point set, built with quickhull (Barber, Dobkin and Huhdanpaa, "The
+	// Quickhull Algorithm for Convex Hulls", 1996).
+	//
+	// The hull grows from an initial tetrahedron by always adding the point farthest outside
+	// it, so a vertex limit keeps the most significant points and yields a simplified hull
+	// inside the full one. Points closer to a face than a tolerance scaled to the extents of
+	// the point set count as inside. There is no randomness and ties are broken by point order,
+	// so the same input always yields the same hull.
+	//
+	// Neighbouring faces that rounding leaves nearly coplanar or slightly concave are merged
+	// into convex polygons. Input points dropped as inside may end up a few tolerances outside
+	// a merged face, but every vertex of the hull is inside every plane.
+	class TOMATO_API ConvexHull
+	{
+	public:
+		struct Parameters
+		{
+			Parameters();
+
+			// Stops adding points once the hull has this many vertices; 0 for no limit.
+			s32 MaxVertexCount;
+		};
+
+		// Input and output of one hull for building many hulls at once.
+		struct Job
+		{
+			Job();
+
+			const Vector3* pPoints;
+			s32 PointCount;
+			Parameters Settings;
+
+			ConvexHull* pHull;
+			bool bResult;
+		};
+
+		ConvexHull();
+		~ConvexHull();
+
+	public:
+		// Returns false and leaves the hull empty when the points are all coplanar.
+		bool Build( const Vector3* pPoints, s32 count, const Parameters& parameters );
+
+		// Builds every job's hull on the worker threads.
+		static void Build( Job* pJobs, s32 count );
+
+		void Clear();
+
+		const std::vector<Vector3>& GetVertices() const { return m_vertices; }
+
+		// Triangle list, clockwise when seen from outside as with D3D front faces.
+		const std::vector<u32>& GetIndices() const { return m_indices; }
+
+		// One plane per polygon of the hull, which GetIndices splits into a fan. Planes face outwards:
+		// a point p is inside when Dot( normal, p ) + distance <= 0 for every plane,
+		// which holds for every vertex.
+		const std::vector<Vector4>& GetPlanes() const { return m_planes; }
+
+	private:
+		class BuildBody;
+
+	private:
+		std::vector<Vector3> m_vertices;
+		std::vector<u32> m_indices;
+		std::vector<Vector4> m_planes;
+	};
+}
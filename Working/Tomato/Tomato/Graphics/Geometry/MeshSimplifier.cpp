@@ -0,0 +1,728 @@
+#include "TomatoPCH.h"
+
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+
+namespace Tomato
+{
+	namespace
+	{
+		// Symmetric 4x4 matrix sum of plane outer products; only the upper triangle is kept.
+		struct Quadric
+		{
+			f64 A2, B2, C2, D2;
+			f64 AB, AC, AD;
+			f64 BC, BD;
+			f64 CD;
+
+			// Total area or length the planes were weighted by.
+			f64 Weight;
+
+			Quadric()
+				: A2( 0 ), B2( 0 ), C2( 0 ), D2( 0 )
+				, AB( 0 ), AC( 0 ), AD( 0 )
+				, BC( 0 ), BD( 0 )
+				, CD( 0 )
+				, Weight( 0 )
+			{
+			}
+
+			// Adds the plane Dot( normal, p ) + d = 0 with the given weight.
+			void AddPlane( const Vector3& normal, f32 d, f32 weight )
+			{
+				f64 a = normal.X;
+				f64 b = normal.Y;
+				f64 c = normal.Z;
+
+				A2 += weight * a * a;
+				B2 += weight * b * b;
+				C2 += weight * c * c;
+				D2 += weight * d * d;
+				AB += weight * a * b;
+				AC += weight * a * c;
+				AD += weight * a * d;
+				BC += weight * b * c;
+				BD += weight * b * d;
+				CD += weight * c * d;
+
+				Weight += weight;
+			}
+
+			Quadric& operator += ( const Quadric& q )
+			{
+				A2 += q.A2; B2 += q.B2; C2 += q.C2; D2 += q.D2;
+				AB += q.AB; AC += q.AC; AD += q.AD;
+				BC += q.BC; BD += q.BD;
+				CD += q.CD;
+				Weight += q.Weight;
+				return *this;
+			}
+
+			// Weighted mean squared distance of p to the planes.
+			f32 Evaluate( const Vector3& p ) const
+			{
+				f64 x = p.X;
+				f64 y = p.Y;
+				f64 z = p.Z;
+
+				f64 error = A2 * x * x + B2 * y * y + C2 * z * z + D2
+					+ 2.0 * ( AB * x * y + AC * x * z + BC * y * z )
+					+ 2.0 * ( AD * x + BD * y + CD * z );
+
+				error = ( error < 0.0 ) ? -error : error;
+				return static_cast<f32>( ( Weight > 0.0 ) ? error / Weight : error );
+			}
+		};
+
+		struct VertexKind
+		{
+			enum Type
+			{
+				// Interior vertex with a single set of attributes; can collapse anywhere.
+				Manifold,
+
+				// On an open border; can only collapse along the border.
+				Border,
+
+				// Two vertices with the same position and different attributes; can only collapse along the seam.
+				Seam,
+
+				Locked,
+			};
+		};
+
+		// A collapse moves Vertex onto Target.
+		struct Collapse
+		{
+			u32 Vertex;
+			u32 Target;
+			f32 Error;
+
+			bool operator < ( const Collapse& collapse ) const
+			{
+				return Error < collapse.Error;
+			}
+		};
+
+		// Extra weight of the planes that hold borders and seams in place.
+		const f32 BoundaryWeight = 10.0f;
+
+		// Compressed lists of the triangles, or of the outgoing edges, around each vertex.
+		class Adjacency
+		{
+		public:
+			void Build( const u32* pIndices, s32 indexCount, s32 vertexCount )
+			{
+				m_offsets.assign( vertexCount + 1, 0 );
+
+				for( s32 i = 0; i < indexCount; ++i )
+				{
+					++m_offsets[ pIndices[ i ] + 1 ];
+				}
+
+				for( s32 v = 0; v < vertexCount; ++v )
+				{
+					m_offsets[ v + 1 ] += m_offsets[ v ];
+				}
+
+				m_triangles.resize( indexCount );
+				m_nextVertices.resize( indexCount );
+
+				std::vector<s32> cursor( m_offsets.begin(), m_offsets.end() - 1 );
+
+				for( s32 i = 0; i < indexCount; ++i )
+				{
+					s32 corner = i % 3;
+					s32 next = i - corner + ( corner + 1 ) % 3;
+
+					s32 slot = cursor[ pIndices[ i ] ]++;
+					m_triangles[ slot ] = i / 3;
+					m_nextVertices[ slot ] = pIndices[ next ];
+				}
+			}
+
+			s32 Begin( u32 vertex ) const { return m_offsets[ vertex ]; }
+			s32 End( u32 vertex ) const { return m_offsets[ vertex + 1 ]; }
+
+			s32 GetTriangle( s32 slot ) const { return m_triangles[ slot ]; }
+			u32 GetNextVertex( s32 slot ) const { return m_nextVertices[ slot ]; }
+
+			bool HasEdge( u32 from, u32 to ) const
+			{
+				for( s32 slot = Begin( from ); slot < End( from ); ++slot )
+				{
+					if( m_nextVertices[ slot ] == to )
+					{
+						return true;
+					}
+				}
+
+				return false;
+			}
+
+		private:
+			std::vector<s32> m_offsets;
+			std::vector<s32> m_triangles;
+			std::vector<u32> m_nextVertices;
+		};
+
+		class Simplifier
+		{
+		public:
+			Simplifier( const Vector3* pPositions, s32 vertexCount )
+				: m_vertexCount( vertexCount )
+			{
+				NormalizePositions( pPositions );
+				BuildWedges();
+			}
+
+			s32 Run( const u32* pIndices, s32 indexCount, const MeshSimplifier::Parameters& parameters, u32* pResultIndices, f32* pResultError )
+			{
+				if( pResultIndices != pIndices )
+				{
+					std::copy( pIndices, pIndices + indexCount, pResultIndices );
+				}
+
+				m_adjacency.Build( pResultIndices, indexCount, m_vertexCount );
+
+				ClassifyVertices( pResultIndices, indexCount, parameters.bLockBorders );
+				BuildQuadrics( pResultIndices, indexCount );
+
+				f32 errorLimit = parameters.TargetError * parameters.TargetError;
+				f32 maxError = 0.0f;
+
+				m_collapseRemap.resize( m_vertexCount );
+				m_collapseLocked.resize( m_vertexCount );
+
+				while( indexCount > parameters.TargetIndexCount )
+				{
+					BuildCollapses( pResultIndices, indexCount );
+					if( m_collapses.empty() )
+					{
+						break;
+					}
+
+					std::sort( m_collapses.begin(), m_collapses.end() );
+
+					// Each collapse removes about two triangles.
+					s32 collapseGoal = Math::Max( ( indexCount - parameters.TargetIndexCount ) / 6, 1 );
+
+					s32 collapseCount = PerformCollapses( pResultIndices, collapseGoal, errorLimit, maxError );
+					if( collapseCount == 0 )
+					{
+						break;
+					}
+
+					indexCount = RemapIndices( pResultIndices, indexCount );
+					m_adjacency.Build( pResultIndices, indexCount, m_vertexCount );
+				}
+
+				if( pResultError != NULL )
+				{
+					*pResultError = sqrtf( maxError );
+				}
+
+				return indexCount;
+			}
+
+		private:
+			// Scales the mesh into the unit cube so errors are relative to its size.
+			void NormalizePositions( const Vector3* pPositions )
+			{
+				Vector3 min = pPositions[ 0 ];
+				Vector3 max = pPositions[ 0 ];
+
+				for( s32 i = 1; i < m_vertexCount; ++i )
+				{
+					min = Vector3::Min( min, pPositions[ i ] );
+					max = Vector3::Max( max, pPositions[ i ] );
+				}
+
+				f32 extent = Math::Max( Math::Max( max.X - min.X, max.Y - min.Y ), max.Z - min.Z );
+				f32 scale = ( extent > 0.0f ) ? 1.0f / extent : 0.0f;
+
+				m_positions.resize( m_vertexCount );
+				for( s32 i = 0; i < m_vertexCount; ++i )
+				{
+					m_positions[ i ] = ( pPositions[ i ] - min ) * scale;
+				}
+			}
+
+			class PositionLess
+			{
+			public:
+				explicit PositionLess( const std::vector<Vector3>& positions )
+					: m_positions( positions )
+				{
+				}
+
+				bool operator () ( u32 a, u32 b ) const
+				{
+					const Vector3& p = m_positions[ a ];
+					const Vector3& q = m_positions[ b ];
+
+					if( p.X != q.X ) return p.X < q.X;
+					if( p.Y != q.Y ) return p.Y < q.Y;
+					if( p.Z != q.Z ) return p.Z < q.Z;
+					return a < b;
+				}
+
+			private:
+				PositionLess& operator = ( const PositionLess& );
+
+				const std::vector<Vector3>& m_positions;
+			};
+
+			// Links the vertices that share a position into rings and picks a representative for each ring.
+			void BuildWedges()
+			{
+				std::vector<u32> order( m_vertexCount );
+				for( s32 i = 0; i < m_vertexCount; ++i )
+				{
+					order[ i ] = i;
+				}
+
+				std::sort( order.begin(), order.end(), PositionLess( m_positions ) );
+
+				m_remap.resize( m_vertexCount );
+				m_wedges.resize( m_vertexCount );
+
+				for( s32 first = 0; first < m_vertexCount; )
+				{
+					s32 last = first + 1;
+					while( last < m_vertexCount && m_positions[ order[ last ] ] == m_positions[ order[ first ] ] )
+					{
+						++last;
+					}
+
+					for( s32 i = first; i < last; ++i )
+					{
+						m_remap[ order[ i ] ] = order[ first ];
+						m_wedges[ order[ i ] ] = order[ ( i + 1 < last ) ? i + 1 : first ];
+					}
+
+					first = last;
+				}
+			}
+
+			// True when an edge leads from any wedge of 'to' back to any wedge of 'from'.
+			bool HasWeldedEdge( u32 from, u32 to ) const
+			{
+				u32 wedge = to;
+				do
+				{
+					for( s32 slot = m_adjacency.Begin( wedge ); slot < m_adjacency.End( wedge ); ++slot )
+					{
+						if( m_remap[ m_adjacency.GetNextVertex( slot ) ] == m_remap[ from ] )
+						{
+							return true;
+						}
+					}
+
+					wedge = m_wedges[ wedge ];
+				}
+				while( wedge != to );
+
+				return false;
+			}
+
+			void ClassifyVertices( const u32* pIndices, s32 indexCount, bool bLockBorders )
+			{
+				std::vector<s32> openIn( m_vertexCount, 0 );
+				std::vector<s32> openOut( m_vertexCount, 0 );
+				std::vector<bool> border( m_vertexCount, false );
+
+				for( s32 i = 0; i < indexCount; ++i )
+				{
+					u32 from = pIndices[ i ];
+					u32 to = pIndices[ i - i % 3 + ( i % 3 + 1 ) % 3 ];
+
+					if( !m_adjacency.HasEdge( to, from ) )
+					{
+						++openOut[ from ];
+						++openIn[ to ];
+
+						// An edge without a twin is a seam when a twin exists between other wedges.
+						if( !HasWeldedEdge( from, to ) )
+						{
+							border[ from ] = true;
+							border[ to ] = true;
+						}
+					}
+				}
+
+				m_kinds.resize( m_vertexCount );
+
+				for( s32 v = 0; v < m_vertexCount; ++v )
+				{
+					u32 wedge = m_wedges[ v ];
+					bool bOneOpenEdgePair = ( openIn[ v ] == 1 && openOut[ v ] == 1 );
+
+					if( wedge == static_cast<u32>( v ) )
+					{
+						if( openIn[ v ] == 0 && openOut[ v ] == 0 )
+						{
+							m_kinds[ v ] = VertexKind::Manifold;
+						}
+						else if( bOneOpenEdgePair && border[ v ] && !bLockBorders )
+						{
+							m_kinds[ v ] = VertexKind::Border;
+						}
+						else
+						{
+							m_kinds[ v ] = VertexKind::Locked;
+						}
+					}
+					else if( m_wedges[ wedge ] == static_cast<u32>( v )
+						&& bOneOpenEdgePair && openIn[ wedge ] == 1 && openOut[ wedge ] == 1
+						&& !border[ v ] && !border[ wedge ] )
+					{
+						m_kinds[ v ] = VertexKind::Seam;
+					}
+					else
+					{
+						m_kinds[ v ] = VertexKind::Locked;
+					}
+				}
+			}
+
+			void BuildQuadrics( const u32* pIndices, s32 indexCount )
+			{
+				m_quadrics.assign( m_vertexCount, Quadric() );
+
+				for( s32 i = 0; i < indexCount; i += 3 )
+				{
+					const Vector3& p0 = m_positions[ pIndices[ i + 0 ] ];
+					const Vector3& p1 = m_positions[ pIndices[ i + 1 ] ];
+					const Vector3& p2 = m_positions[ pIndices[ i + 2 ] ];
+
+					Vector3 normal = Vector3::Cross( p1 - p0, p2 - p0 );
+					f32 length = normal.GetLength();
+					if( length <= 0.0f )
+					{
+						continue;
+					}
+
+					normal = normal * ( 1.0f / length );
+
+					Quadric quadric;
+					quadric.AddPlane( normal, -Vector3::Dot( normal, p0 ), length * 0.5f );
+
+					for( s32 k = 0; k < 3; ++k )
+					{
+						m_quadrics[ m_remap[ pIndices[ i + k ] ] ] += quadric;
+					}
+
+					// Planes through open edges, perpendicular to the triangle, keep borders and seams from drifting.
+					for( s32 k = 0; k < 3; ++k )
+					{
+						u32 from = pIndices[ i + k ];
+						u32 to = pIndices[ i + ( k + 1 ) % 3 ];
+
+						if( m_adjacency.HasEdge( to, from ) )
+						{
+							continue;
+						}
+
+						Vector3 edge = m_positions[ to ] - m_positions[ from ];
+						f32 edgeLength = edge.GetLength();
+						if( edgeLength <= 0.0f )
+						{
+							continue;
+						}
+
+						Vector3 edgeNormal = Vector3::Cross( edge, normal ) * ( 1.0f / edgeLength );
+
+						Quadric edgeQuadric;
+						edgeQuadric.AddPlane( edgeNormal, -Vector3::Dot( edgeNormal, m_positions[ from ] ), edgeLength * edgeLength * BoundaryWeight );
+
+						m_quadrics[ m_remap[ from ] ] += edgeQuadric;
+						m_quadrics[ m_remap[ to ] ] += edgeQuadric;
+					}
+				}
+			}
+
+			bool CanCollapse( u32 vertex, u32 target ) const
+			{
+				VertexKind::Type kind = m_kinds[ vertex ];
+
+				if( kind == VertexKind::Manifold )
+				{
+					return true;
+				}
+
+				if( kind == VertexKind::Locked || m_kinds[ target ] != kind )
+				{
+					return false;
+				}
+
+				// Borders and seams only move along their own open edges.
+				bool bOpenOut = !m_adjacency.HasEdge( target, vertex ) && m_adjacency.HasEdge( vertex, target );
+				bool bOpenIn = !m_adjacency.HasEdge( vertex, target ) && m_adjacency.HasEdge( target, vertex );
+
+				return bOpenOut || bOpenIn;
+			}
+
+			void BuildCollapses( const u32* pIndices, s32 indexCount )
+			{
+				m_collapses.clear();
+
+				for( s32 i = 0; i < indexCount; ++i )
+				{
+					u32 v0 = pIndices[ i ];
+					u32 v1 = pIndices[ i - i % 3 + ( i % 3 + 1 ) % 3 ];
+
+					// Interior edges show up once per direction; keep one.
+					if( v0 > v1 && m_adjacency.HasEdge( v1, v0 ) )
+					{
+						continue;
+					}
+
+					Collapse collapse;
+					collapse.Error = Math::FloatPositiveMax;
+
+					if( CanCollapse( v0, v1 ) )
+					{
+						collapse.Vertex = v0;
+						collapse.Target = v1;
+						collapse.Error = m_quadrics[ m_remap[ v0 ] ].Evaluate( m_positions[ v1 ] );
+					}
+
+					if( CanCollapse( v1, v0 ) )
+					{
+						f32 error = m_quadrics[ m_remap[ v1 ] ].Evaluate( m_positions[ v0 ] );
+						if( error < collapse.Error )
+						{
+							collapse.Vertex = v1;
+							collapse.Target = v0;
+							collapse.Error = error;
+						}
+					}
+
+					if( collapse.Error < Math::FloatPositiveMax )
+					{
+						m_collapses.push_back( collapse );
+					}
+				}
+			}
+
+			// The wedge of 'target' that shares a triangle with 'vertex', or ~0u if there is none.
+			u32 FindWedgeNeighbour( u32 vertex, u32 target ) const
+			{
+				for( s32 slot = m_adjacency.Begin( vertex ); slot < m_adjacency.End( vertex ); ++slot )
+				{
+					u32 next = m_adjacency.GetNextVertex( slot );
+					if( m_remap[ next ] == m_remap[ target ] )
+					{
+						return next;
+					}
+				}
+
+				for( u32 wedge = m_wedges[ target ]; wedge != target; wedge = m_wedges[ wedge ] )
+				{
+					if( m_adjacency.HasEdge( wedge, vertex ) )
+					{
+						return wedge;
+					}
+				}
+
+				return ~0u;
+			}
+
+			// True when moving 'vertex' onto the position of 'target' turns a surrounding triangle over.
+			bool FlipsTriangle( u32 vertex, u32 target, const u32* pIndices ) const
+			{
+				const Vector3& position = m_positions[ target ];
+
+				for( s32 slot = m_adjacency.Begin( vertex ); slot < m_adjacency.End( vertex ); ++slot )
+				{
+					const u32* pTriangle = pIndices + m_adjacency.GetTriangle( slot ) * 3;
+
+					s32 corner = ( pTriangle[ 0 ] == vertex ) ? 0 : ( ( pTriangle[ 1 ] == vertex ) ? 1 : 2 );
+					u32 next = pTriangle[ ( corner + 1 ) % 3 ];
+					u32 previous = pTriangle[ ( corner + 2 ) % 3 ];
+
+					// Triangles that contain the target disappear with the collapse.
+					if( m_remap[ next ] == m_remap[ target ] || m_remap[ previous ] == m_remap[ target ] )
+					{
+						continue;
+					}
+
+					const Vector3& p1 = m_positions[ next ];
+					const Vector3& p2 = m_positions[ previous ];
+
+					Vector3 before = Vector3::Cross( p1 - m_positions[ vertex ], p2 - m_positions[ vertex ] );
+					Vector3 after = Vector3::Cross( p1 - position, p2 - position );
+
+					// Also rejects triangles that become very thin.
+					if( Vector3::Dot( before, after ) <= 0.25f * before.GetLength() * after.GetLength() )
+					{
+						return true;
+					}
+				}
+
+				return false;
+			}
+
+			s32 PerformCollapses( const u32* pIndices, s32 collapseGoal, f32 errorLimit, f32& maxError )
+			{
+				for( s32 v = 0; v < m_vertexCount; ++v )
+				{
+					m_collapseRemap[ v ] = v;
+					m_collapseLocked[ v ] = false;
+				}
+
+				s32 collapseCount = 0;
+
+				for( size_t i = 0; i < m_collapses.size() && collapseCount < collapseGoal; ++i )
+				{
+					const Collapse& collapse = m_collapses[ i ];
+
+					if( collapse.Error > errorLimit )
+					{
+						break;
+					}
+
+					u32 vertex = collapse.Vertex;
+					u32 target = collapse.Target;
+
+					if( m_collapseLocked[ m_remap[ vertex ] ] || m_collapseLocked[ m_remap[ target ] ] )
+					{
+						continue;
+					}
+
+					// Every wedge of the vertex moves together with its counterpart on the target.
+					u32 vertexWedge = m_wedges[ vertex ];
+					u32 targetWedge = target;
+
+					if( m_kinds[ vertex ] == VertexKind::Seam )
+					{
+						targetWedge = FindWedgeNeighbour( vertexWedge, target );
+						if( targetWedge == ~0u || targetWedge == target )
+						{
+							continue;
+						}
+					}
+
+					if( FlipsTriangle( vertex, target, pIndices ) || ( vertexWedge != vertex && FlipsTriangle( vertexWedge, targetWedge, pIndices ) ) )
+					{
+						continue;
+					}
+
+					m_collapseRemap[ vertex ] = target;
+					m_collapseRemap[ vertexWedge ] = targetWedge;
+
+					m_collapseLocked[ m_remap[ vertex ] ] = true;
+					m_collapseLocked[ m_remap[ target ] ] = true;
+
+					m_quadrics[ m_remap[ target ] ] += m_quadrics[ m_remap[ vertex ] ];
+
+					maxError = Math::Max( maxError, collapse.Error );
+					++collapseCount;
+				}
+
+				return collapseCount;
+			}
+
+			s32 RemapIndices( u32* pIndices, s32 indexCount )
+			{
+				s32 writeCount = 0;
+
+				for( s32 i = 0; i < indexCount; i += 3 )
+				{
+					u32 v0 = m_collapseRemap[ pIndices[ i + 0 ] ];
+					u32 v1 = m_collapseRemap[ pIndices[ i + 1 ] ];
+					u32 v2 = m_collapseRemap[ pIndices[ i + 2 ] ];
+
+					if( v0 != v1 && v1 != v2 && v2 != v0 )
+					{
+						pIndices[ writeCount + 0 ] = v0;
+						pIndices[ writeCount + 1 ] = v1;
+						pIndices[ writeCount + 2 ] = v2;
+						writeCount += 3;
+					}
+				}
+
+				return writeCount;
+			}
+
+		private:
+			s32 m_vertexCount;
+
+			std::vector<Vector3> m_positions;
+			std::vector<u32> m_remap;
+			std::vector<u32> m_wedges;
+			std::vector<VertexKind::Type> m_kinds;
+			std::vector<Quadric> m_quadrics;
+
+			Adjacency m_adjacency;
+			std::vector<Collapse> m_collapses;
+			std::vector<u32> m_collapseRemap;
+			std::vector<bool> m_collapseLocked;
+		};
+	}
+
+	class MeshSimplifier::PartBody
+	{
+	public:
+		PartBody( const Vector3* pPositions, s32 vertexCount, Part* pParts )
+			: m_pPositions( pPositions )
+			, m_vertexCount( vertexCount )
+			, m_pParts( pParts )
+		{
+		}
+
+		void operator () ( s32 begin, s32 end )
+		{
+			for( s32 i = begin; i < end; ++i )
+			{
+				Part& part = m_pParts[ i ];
+				part.ResultIndexCount = MeshSimplifier::Simplify( m_pPositions, m_vertexCount, part.pIndices, part.IndexCount, part.Settings, part.pResultIndices, &part.ResultError );
+			}
+		}
+
+	private:
+		PartBody& operator = ( const PartBody& );
+
+		const Vector3* m_pPositions;
+		s32 m_vertexCount;
+		Part* m_pParts;
+	};
+
+	MeshSimplifier::Parameters::Parameters()
+		: TargetIndexCount( 0 )
+		, TargetError( 0.01f )
+		, bLockBorders( false )
+	{
+	}
+
+	MeshSimplifier::Part::Part()
+		: pIndices( NULL )
+		, IndexCount( 0 )
+		, Settings()
+		, pResultIndices( NULL )
+		, ResultIndexCount( 0 )
+		, ResultError( 0.0f )
+	{
+	}
+
+	s32 MeshSimplifier::Simplify( const Vector3* pPositions, s32 vertexCount, const u32* pIndices, s32 indexCount, const Parameters& parameters, u32* pResultIndices, f32* pResultError )
+	{
+		Assert( pPositions != NULL && vertexCount > 0 );
+		Assert( pIndices != NULL && pResultIndices != NULL );
+		Assert( indexCount % 3 == 0 );
+		Assert( parameters.TargetIndexCount >= 0 );
+
+		Simplifier simplifier( pPositions, vertexCount );
+		return simplifier.Run( pIndices, indexCount, parameters, pResultIndices, pResultError );
+	}
+
+	void MeshSimplifier::Simplify( const Vector3* pPositions, s32 vertexCount, Part* pParts, s32 partCount )
+	{
+		Assert( partCount == 0 || pParts != NULL );
+
+		PartBody body( pPositions, vertexCount, pParts );
+		Parallel::For( 0, partCount, 1, body );
+	}
+}
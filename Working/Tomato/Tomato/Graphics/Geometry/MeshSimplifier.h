@@ -0,0 +1,58 @@
+#pragma once
+
+namespace Tomato
+{
+	// Triangle mesh decimation for generating levels of detail offline.
+	//
+	// Edges are collapsed in order of their quadric error (Garland and Heckbert, "Surface
+	// Simplification Using Quadric Error Metrics", 1997); every collapse moves a vertex onto
+	// one of its neighbours, so the vertex buffer is shared by all levels and only the index
+	// buffer changes. Vertices that share a position but not their attributes form a seam and
+	// only move along it, and open borders only move along the border, so texture seams and
+	// mesh outlines stay in place.
+	class TOMATO_API MeshSimplifier
+	{
+	public:
+		struct Parameters
+		{
+			Parameters();
+
+			// Simplification stops at this index count or at TargetError, whichever comes first.
+			s32 TargetIndexCount;
+
+			// Largest allowed deviation relative to the size of the mesh, e.g. 0.01 for 1%.
+			f32 TargetError;
+
+			// Keeps every vertex on an open border in place.
+			bool bLockBorders;
+		};
+
+		// One index range of a shared vertex buffer, simplified independently of the others.
+		struct Part
+		{
+			Part();
+
+			const u32* pIndices;
+			s32 IndexCount;
+			Parameters Settings;
+
+			// Receives up to IndexCount indices.
+			u32* pResultIndices;
+			s32 ResultIndexCount;
+
+			// Deviation reached, relative to the size of the mesh.
+			f32 ResultError;
+		};
+
+	public:
+		// Writes the simplified triangle list to pResultIndices, which may equal pIndices,
+		// and returns its index count.
+		static s32 Simplify( const Vector3* pPositions, s32 vertexCount, const u32* pIndices, s32 indexCount, const Parameters& parameters, u32* pResultIndices, f32* pResultError = NULL );
+
+		// Simplifies every part on the worker threads.
+		static void Simplify( const Vector3* pPositions, s32 vertexCount, Part* pParts, s32 partCount );
+
+	private:
+		class PartBody;
+	};
+}
@@ -0,0 +1,422 @@
+#include "TomatoPCH.h"
+
+#include "MeshletBuilder.h"
+
+#include <emmintrin.h>
+
+namespace Tomato
+{
+	namespace
+	{
+		const u8 NoLocalIndex = 0xff;
+
+		// Triangles around every vertex, as compressed lists.
+		struct TriangleAdjacency
+		{
+			std::vector<s32> Offsets;
+			std::vector<s32> Triangles;
+
+			void Build( const u32* pIndices, s32 indexCount, s32 vertexCount )
+			{
+				Offsets.assign( vertexCount + 1, 0 );
+
+				for( s32 i = 0; i < indexCount; ++i )
+				{
+					++Offsets[ pIndices[ i ] + 1 ];
+				}
+
+				for( s32 v = 0; v < vertexCount; ++v )
+				{
+					Offsets[ v + 1 ] += Offsets[ v ];
+				}
+
+				Triangles.resize( indexCount );
+
+				std::vector<s32> cursor( Offsets.begin(), Offsets.end() - 1 );
+				for( s32 i = 0; i < indexCount; ++i )
+				{
+					Triangles[ cursor[ pIndices[ i ] ]++ ] = i / 3;
+				}
+			}
+		};
+
+		Vector3 GetTriangleCenter( const Vector3* pPositions, const u32* pTriangle )
+		{
+			return ( pPositions[ pTriangle[ 0 ] ] + pPositions[ pTriangle[ 1 ] ] + pPositions[ pTriangle[ 2 ] ] ) * ( 1.0f / 3.0f );
+		}
+	}
+
+	class MeshletBuilder::BoundsBody
+	{
+	public:
+		BoundsBody( const Meshlet* pMeshlets, const u32* pMeshletVertices, const u8* pMeshletTriangles, const Vector3* pPositions, MeshletBounds* pBounds )
+			: m_pMeshlets( pMeshlets )
+			, m_pMeshletVertices( pMeshletVertices )
+			, m_pMeshletTriangles( pMeshletTriangles )
+			, m_pPositions( pPositions )
+			, m_pBounds( pBounds )
+		{
+		}
+
+		void operator () ( s32 begin, s32 end )
+		{
+			for( s32 i = begin; i < end; ++i )
+			{
+				m_pBounds[ i ] = MeshletBuilder::ComputeBounds( m_pMeshlets[ i ], m_pMeshletVertices, m_pMeshletTriangles, m_pPositions );
+			}
+		}
+
+	private:
+		BoundsBody& operator = ( const BoundsBody& );
+
+		const Meshlet* m_pMeshlets;
+		const u32* m_pMeshletVertices;
+		const u8* m_pMeshletTriangles;
+		const Vector3* m_pPositions;
+		MeshletBounds* m_pBounds;
+	};
+
+	void MeshletBuilder::Build( const Vector3* pPositions, s32 vertexCount, const u32* pIndices, s32 indexCount,
+		std::vector<Meshlet>& meshlets, std::vector<u32>& meshletVertices, std::vector<u8>& meshletTriangles )
+	{
+		Assert( pPositions != NULL );
+		Assert( pIndices != NULL );
+		Assert( indexCount % 3 == 0 );
+
+		s32 triangleCount = indexCount / 3;
+
+		TriangleAdjacency adjacency;
+		adjacency.Build( pIndices, indexCount, vertexCount );
+
+		std::vector<bool> emitted( triangleCount, false );
+		std::vector<u8> localIndices( vertexCount, NoLocalIndex );
+
+		Meshlet meshlet = { static_cast<u32>( meshletVertices.size() ), static_cast<u32>( meshletTriangles.size() / 3 ), 0, 0 };
+		Vector3 centerSum( 0.0f, 0.0f, 0.0f );
+
+		s32 nextSeed = 0;
+
+		for( ;; )
+		{
+			// Among the triangles touching the meshlet, the one adding the fewest vertices, then the closest.
+			s32 best = -1;
+			s32 bestNewVertices = 3;
+			f32 bestDistance = Math::FloatPositiveMax;
+
+			Vector3 center = centerSum * ( 1.0f / Math::Max( static_cast<f32>( meshlet.TriangleCount ), 1.0f ) );
+
+			for( u32 i = 0; i < meshlet.VertexCount; ++i )
+			{
+				u32 vertex = meshletVertices[ meshlet.VertexOffset + i ];
+
+				for( s32 slot = adjacency.Offsets[ vertex ]; slot < adjacency.Offsets[ vertex + 1 ]; ++slot )
+				{
+					s32 triangle = adjacency.Triangles[ slot ];
+					if( emitted[ triangle ] )
+					{
+						continue;
+					}
+
+					const u32* pTriangle = pIndices + triangle * 3;
+
+					s32 newVertices = ( localIndices[ pTriangle[ 0 ] ] == NoLocalIndex )
+						+ ( localIndices[ pTriangle[ 1 ] ] == NoLocalIndex )
+						+ ( localIndices[ pTriangle[ 2 ] ] == NoLocalIndex );
+
+					if( meshlet.VertexCount + newVertices > MaxVertexCount || newVertices > bestNewVertices )
+					{
+						continue;
+					}
+
+					f32 distance = ( GetTriangleCenter( pPositions, pTriangle ) - center ).GetLengthSquared();
+
+					if( newVertices < bestNewVertices || distance < bestDistance )
+					{
+						best = triangle;
+						bestNewVertices = newVertices;
+						bestDistance = distance;
+					}
+				}
+			}
+
+			// Nothing connected fits; continue with the next triangle in index order.
+			if( best < 0 )
+			{
+				while( nextSeed < triangleCount && emitted[ nextSeed ] )
+				{
+					++nextSeed;
+				}
+
+				if( nextSeed == triangleCount )
+				{
+					break;
+				}
+
+				best = nextSeed;
+			}
+
+			const u32* pTriangle = pIndices + best * 3;
+
+			s32 newVertices = ( localIndices[ pTriangle[ 0 ] ] == NoLocalIndex )
+				+ ( localIndices[ pTriangle[ 1 ] ] == NoLocalIndex )
+				+ ( localIndices[ pTriangle[ 2 ] ] == NoLocalIndex );
+
+			if( meshlet.VertexCount + newVertices > MaxVertexCount || meshlet.TriangleCount == MaxTriangleCount )
+			{
+				meshlets.push_back( meshlet );
+
+				for( u32 i = 0; i < meshlet.VertexCount; ++i )
+				{
+					localIndices[ meshletVertices[ meshlet.VertexOffset + i ] ] = NoLocalIndex;
+				}
+
+				meshlet.VertexOffset += meshlet.VertexCount;
+				meshlet.TriangleOffset += meshlet.TriangleCount;
+				meshlet.VertexCount = 0;
+				meshlet.TriangleCount = 0;
+				centerSum.Set( 0.0f, 0.0f, 0.0f );
+			}
+
+			for( s32 k = 0; k < 3; ++k )
+			{
+				u32 vertex = pIndices[ best * 3 + k ];
+
+				if( localIndices[ vertex ] == NoLocalIndex )
+				{
+					localIndices[ vertex ] = static_cast<u8>( meshlet.VertexCount++ );
+					meshletVertices.push_back( vertex );
+				}
+
+				meshletTriangles.push_back( localIndices[ vertex ] );
+			}
+
+			++meshlet.TriangleCount;
+			centerSum += GetTriangleCenter( pPositions, pTriangle );
+			emitted[ best ] = true;
+		}
+
+		if( meshlet.TriangleCount > 0 )
+		{
+			meshlets.push_back( meshlet );
+		}
+	}
+
+	MeshletBounds MeshletBuilder::ComputeBounds( const Meshlet& meshlet, const u32* pMeshletVertices, const u8* pMeshletTriangles, const Vector3* pPositions )
+	{
+		Assert( meshlet.VertexCount > 0 );
+
+		const u32* pVertices = pMeshletVertices + meshlet.VertexOffset;
+		const u8* pTriangles = pMeshletTriangles + meshlet.TriangleOffset * 3;
+
+		MeshletBounds bounds;
+
+		// Ritter, "An Efficient Bounding Sphere", Graphics Gems (1990): start from the farthest pair found
+		// from the first vertex, then grow the sphere over the vertices left outside.
+		Vector3 first = pPositions[ pVertices[ 0 ] ];
+		Vector3 a = first;
+		Vector3 b = first;
+
+		for( u32 i = 1; i < meshlet.VertexCount; ++i )
+		{
+			const Vector3& p = pPositions[ pVertices[ i ] ];
+			if( ( p - first ).GetLengthSquared() > ( a - first ).GetLengthSquared() )
+			{
+				a = p;
+			}
+		}
+
+		for( u32 i = 0; i < meshlet.VertexCount; ++i )
+		{
+			const Vector3& p = pPositions[ pVertices[ i ] ];
+			if( ( p - a ).GetLengthSquared() > ( b - a ).GetLengthSquared() )
+			{
+				b = p;
+			}
+		}
+
+		Vector3 center = ( a + b ) * 0.5f;
+		f32 radius = ( b - a ).GetLength() * 0.5f;
+
+		for( u32 i = 0; i < meshlet.VertexCount; ++i )
+		{
+			const Vector3& p = pPositions[ pVertices[ i ] ];
+			f32 distance = ( p - center ).GetLength();
+
+			if( distance > radius )
+			{
+				f32 grownRadius = ( radius + distance ) * 0.5f;
+				center += ( p - center ) * ( ( grownRadius - radius ) / distance );
+				radius = grownRadius;
+			}
+		}
+
+		bounds.Center = center;
+		bounds.Radius = radius;
+
+		// Cone around the mean of the unit triangle normals.
+		std::vector<Vector3> normals;
+		normals.reserve( meshlet.TriangleCount );
+
+		Vector3 axis( 0.0f, 0.0f, 0.0f );
+
+		for( u32 i = 0; i < meshlet.TriangleCount; ++i )
+		{
+			const Vector3& p0 = pPositions[ pVertices[ pTriangles[ i * 3 + 0 ] ] ];
+			const Vector3& p1 = pPositions[ pVertices[ pTriangles[ i * 3 + 1 ] ] ];
+			const Vector3& p2 = pPositions[ pVertices[ pTriangles[ i * 3 + 2 ] ] ];
+
+			// Clockwise front faces, as with D3D's default culling.
+			Vector3 normal = Vector3::Cross( p1 - p0, p2 - p0 );
+			f32 length = normal.GetLength();
+
+			if( length > 0.0f )
+			{
+				normals.push_back( normal * ( 1.0f / length ) );
+				axis += normals.back();
+			}
+		}
+
+		f32 axisLength = axis.GetLength();
+		f32 minDot = 1.0f;
+
+		if( axisLength > 0.0f )
+		{
+			axis = axis * ( 1.0f / axisLength );
+
+			for( size_t i = 0; i < normals.size(); ++i )
+			{
+				minDot = Math::Min( minDot, Vector3::Dot( axis, normals[ i ] ) );
+			}
+		}
+
+		bounds.ConeAxis = axis;
+
+		// Cones wider than about 84 degrees hardly ever cull.
+		bounds.ConeCutoff = ( axisLength > 0.0f && minDot > 0.1f ) ? sqrtf( 1.0f - minDot * minDot ) : 1.0f;
+
+		return bounds;
+	}
+
+	void MeshletBuilder::ComputeBounds( const Meshlet* pMeshlets, s32 count, const u32* pMeshletVertices, const u8* pMeshletTriangles, const Vector3* pPositions, MeshletBounds* pBounds )
+	{
+		Assert( count == 0 || ( pMeshlets != NULL && pBounds != NULL ) );
+
+		BoundsBody body( pMeshlets, pMeshletVertices, pMeshletTriangles, pPositions, pBounds );
+		Parallel::For( 0, count, 64, body );
+	}
+
+	void MeshletBuilder::PackBounds( const MeshletBounds* pBounds, s32 count, std::vector<MeshletBoundsGroup>& groups )
+	{
+		Assert( count == 0 || pBounds != NULL );
+
+		groups.resize( ( count + 3 ) / 4 );
+
+		for( s32 i = 0; i < static_cast<s32>( groups.size() ) * 4; ++i )
+		{
+			MeshletBoundsGroup& group = groups[ i / 4 ];
+			s32 lane = i % 4;
+
+			if( i < count )
+			{
+				const MeshletBounds& bounds = pBounds[ i ];
+
+				group.CenterX[ lane ] = bounds.Center.X;
+				group.CenterY[ lane ] = bounds.Center.Y;
+				group.CenterZ[ lane ] = bounds.Center.Z;
+				group.Radius[ lane ] = bounds.Radius;
+				group.AxisX[ lane ] = bounds.ConeAxis.X;
+				group.AxisY[ lane ] = bounds.ConeAxis.Y;
+				group.AxisZ[ lane ] = bounds.ConeAxis.Z;
+				group.Cutoff[ lane ] = bounds.ConeCutoff;
+			}
+			else
+			{
+				// A negative radius fails every plane.
+				group.CenterX[ lane ] = 0.0f;
+				group.CenterY[ lane ] = 0.0f;
+				group.CenterZ[ lane ] = 0.0f;
+				group.Radius[ lane ] = -Math::FloatPositiveMax;
+				group.AxisX[ lane ] = 0.0f;
+				group.AxisY[ lane ] = 0.0f;
+				group.AxisZ[ lane ] = 0.0f;
+				group.Cutoff[ lane ] = 1.0f;
+			}
+		}
+	}
+
+	s32 MeshletBuilder::Cull( const MeshletBoundsGroup* pGroups, s32 meshletCount, const Vector3& cameraPosition, const Frustum& frustum, u32* pVisibleMeshlets )
+	{
+		Assert( meshletCount == 0 || ( pGroups != NULL && pVisibleMeshlets != NULL ) );
+
+		__m128 planeX[ Frustum::Side::Count ];
+		__m128 planeY[ Frustum::Side::Count ];
+		__m128 planeZ[ Frustum::Side::Count ];
+		__m128 planeW[ Frustum::Side::Count ];
+
+		for( s32 side = 0; side < Frustum::Side::Count; ++side )
+		{
+			const Vector4& plane = frustum.GetPlane( static_cast<Frustum::Side::Type>( side ) );
+
+			planeX[ side ] = _mm_set1_ps( plane.X );
+			planeY[ side ] = _mm_set1_ps( plane.Y );
+			planeZ[ side ] = _mm_set1_ps( plane.Z );
+			planeW[ side ] = _mm_set1_ps( plane.W );
+		}
+
+		__m128 cameraX = _mm_set1_ps( cameraPosition.X );
+		__m128 cameraY = _mm_set1_ps( cameraPosition.Y );
+		__m128 cameraZ = _mm_set1_ps( cameraPosition.Z );
+
+		s32 visibleCount = 0;
+
+		for( s32 groupIndex = 0; groupIndex * 4 < meshletCount; ++groupIndex )
+		{
+			const MeshletBoundsGroup& group = pGroups[ groupIndex ];
+
+			__m128 centerX = _mm_loadu_ps( group.CenterX );
+			__m128 centerY = _mm_loadu_ps( group.CenterY );
+			__m128 centerZ = _mm_loadu_ps( group.CenterZ );
+			__m128 radius = _mm_loadu_ps( group.Radius );
+			__m128 negativeRadius = _mm_sub_ps( _mm_setzero_ps(), radius );
+
+			// Sphere against each frustum plane.
+			__m128 visible = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+
+			for( s32 side = 0; side < Frustum::Side::Count; ++side )
+			{
+				__m128 distance = _mm_add_ps(
+					_mm_add_ps( _mm_mul_ps( planeX[ side ], centerX ), _mm_mul_ps( planeY[ side ], centerY ) ),
+					_mm_add_ps( _mm_mul_ps( planeZ[ side ], centerZ ), planeW[ side ] ) );
+
+				visible = _mm_and_ps( visible, _mm_cmpge_ps( distance, negativeRadius ) );
+			}
+
+			// Backfacing when Dot( center - camera, axis ) >= cutoff * | center - camera | + radius.
+			__m128 toCenterX = _mm_sub_ps( centerX, cameraX );
+			__m128 toCenterY = _mm_sub_ps( centerY, cameraY );
+			__m128 toCenterZ = _mm_sub_ps( centerZ, cameraZ );
+
+			__m128 dot = _mm_add_ps(
+				_mm_add_ps( _mm_mul_ps( toCenterX, _mm_loadu_ps( group.AxisX ) ), _mm_mul_ps( toCenterY, _mm_loadu_ps( group.AxisY ) ) ),
+				_mm_mul_ps( toCenterZ, _mm_loadu_ps( group.AxisZ ) ) );
+
+			__m128 distance = _mm_sqrt_ps( _mm_add_ps(
+				_mm_add_ps( _mm_mul_ps( toCenterX, toCenterX ), _mm_mul_ps( toCenterY, toCenterY ) ),
+				_mm_mul_ps( toCenterZ, toCenterZ ) ) );
+
+			__m128 backfacing = _mm_cmpge_ps( dot, _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( group.Cutoff ), distance ), radius ) );
+
+			s32 mask = _mm_movemask_ps( _mm_andnot_ps( backfacing, visible ) );
+
+			for( s32 lane = 0; lane < 4; ++lane )
+			{
+				if( mask & ( 1 << lane ) )
+				{
+					pVisibleMeshlets[ visibleCount++ ] = groupIndex * 4 + lane;
+				}
+			}
+		}
+
+		return visibleCount;
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+namespace Tomato
+{
+	// A small cluster of triangles with its own local vertex list.
+	// Vertices [ VertexOffset, VertexOffset + VertexCount ) of the meshlet vertex array index the
+	// mesh vertex buffer; triangles are three local vertex indices each, starting at TriangleOffset * 3
+	// in the meshlet triangle array.
+	struct Meshlet
+	{
+		u32 VertexOffset;
+		u32 TriangleOffset;
+		u32 VertexCount;
+		u32 TriangleCount;
+	};
+
+	// Culling data of a meshlet.
+	struct MeshletBounds
+	{
+		Vector3 Center;
+		f32 Radius;
+
+		// Every triangle normal is within the cone around ConeAxis; ConeCutoff is the sine of the
+		// cone half angle, or 1 when the normals spread too far for the cone to cull anything.
+		Vector3 ConeAxis;
+		f32 ConeCutoff;
+	};
+
+	// Bounds of four meshlets, one lane each, for Cull.
+	struct MeshletBoundsGroup
+	{
+		f32 CenterX[ 4 ];
+		f32 CenterY[ 4 ];
+		f32 CenterZ[ 4 ];
+		f32 Radius[ 4 ];
+		f32 AxisX[ 4 ];
+		f32 AxisY[ 4 ];
+		f32 AxisZ[ 4 ];
+		f32 Cutoff[ 4 ];
+	};
+
+	// Splits indexed triangle meshes into meshlets for culling below the mesh level.
+	//
+	// Triangles are added to a meshlet preferring those that share the most vertices with it and
+	// lie closest to its center, so meshlets stay compact and their bounds and normal cones tight.
+	// Each frame Cull rejects whole meshlets that are outside the frustum or face away from the
+	// camera, four meshlets per SSE instruction.
+	class TOMATO_API MeshletBuilder
+	{
+	public:
+		enum
+		{
+			MaxVertexCount = 64,
+			MaxTriangleCount = 124,
+		};
+
+		// Appends the meshlets of the mesh to the three arrays.
+		static void Build( const Vector3* pPositions, s32 vertexCount, const u32* pIndices, s32 indexCount,
+			std::vector<Meshlet>& meshlets, std::vector<u32>& meshletVertices, std::vector<u8>& meshletTriangles );
+
+		static MeshletBounds ComputeBounds( const Meshlet& meshlet, const u32* pMeshletVertices, const u8* pMeshletTriangles, const Vector3* pPositions );
+
+		// ComputeBounds for many meshlets, spread over the worker threads.
+		static void ComputeBounds( const Meshlet* pMeshlets, s32 count, const u32* pMeshletVertices, const u8* pMeshletTriangles, const Vector3* pPositions, MeshletBounds* pBounds );
+
+		// Packs bounds four at a time; the last group is padded with meshlets that are always culled.
+		static void PackBounds( const MeshletBounds* pBounds, s32 count, std::vector<MeshletBoundsGroup>& groups );
+
+		// Writes the indices of the meshlets that may be visible and returns how many there are.
+		// The camera position and the frustum must be in the space of the mesh vertices.
+		static s32 Cull( const MeshletBoundsGroup* pGroups, s32 meshletCount, const Vector3& cameraPosition, const Frustum& frustum, u32* pVisibleMeshlets );
+
+	private:
+		class BoundsBody;
+	};
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <xmmintrin.h>
+
+namespace Tomato
+{
+	// Per-instance vertex layouts for InstanceStreamWriter.
+	//
+	// A format names the CPU side Instance type, the Stride of one packed instance in bytes
+	// and a Pack function that writes one instance to 16 byte aligned, possibly write-combined
+	// memory. World matrices are stored as the three float4 rows of the transposed 3x4 matrix,
+	// which a shader rebuilds with three dot products per position.
+
+	// Transposes the affine part of a row-vector Matrix4 into three float4 rows and streams them out.
+	inline void PackWorld3x4( const Matrix4& world, f32* pTarget )
+	{
+		__m128 row1 = _mm_loadu_ps( world.E + 0 );
+		__m128 row2 = _mm_loadu_ps( world.E + 4 );
+		__m128 row3 = _mm_loadu_ps( world.E + 8 );
+		__m128 row4 = _mm_loadu_ps( world.E + 12 );
+
+		_MM_TRANSPOSE4_PS( row1, row2, row3, row4 );
+
+		_mm_stream_ps( pTarget + 0, row1 );
+		_mm_stream_ps( pTarget + 4, row2 );
+		_mm_stream_ps( pTarget + 8, row3 );
+	}
+
+	struct InstanceWorld
+	{
+		enum { Stride = 48 };
+
+		typedef Matrix4 Instance;
+
+		static void Pack( const Instance& instance, f32* pTarget )
+		{
+			PackWorld3x4( instance, pTarget );
+		}
+	};
+
+	struct InstanceWorldColor
+	{
+		enum { Stride = 64 };
+
+		struct Instance
+		{
+			Matrix4 World;
+			Vector4 Color;
+		};
+
+		static void Pack( const Instance& instance, f32* pTarget )
+		{
+			PackWorld3x4( instance.World, pTarget );
+			_mm_stream_ps( pTarget + 12, _mm_loadu_ps( &instance.Color.X ) );
+		}
+	};
+}
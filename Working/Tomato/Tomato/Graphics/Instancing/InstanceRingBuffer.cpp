@@ -0,0 +1,135 @@
+#include "TomatoPCH.h"
+
+#include "InstanceRingBuffer.h"
+
+#include <malloc.h>
+
+namespace Tomato
+{
+	InstanceRingBuffer::InstanceRingBuffer( u32 capacity )
+		: m_pData( static_cast<byte*>( _aligned_malloc( capacity, 16 ) ) )
+		, m_bOwnsMemory( true )
+		, m_capacity( capacity )
+		, m_head( 0 )
+		, m_tail( 0 )
+		, m_allocated( 0 )
+		, m_released( 0 )
+		, m_frames()
+	{
+		Assert( capacity > 0 );
+	}
+
+	InstanceRingBuffer::InstanceRingBuffer( void* pMemory, u32 capacity )
+		: m_pData( static_cast<byte*>( pMemory ) )
+		, m_bOwnsMemory( false )
+		, m_capacity( capacity )
+		, m_head( 0 )
+		, m_tail( 0 )
+		, m_allocated( 0 )
+		, m_released( 0 )
+		, m_frames()
+	{
+		Assert( pMemory != NULL );
+		Assert( capacity > 0 );
+
+		// Instances are written with streaming stores, which need 16 byte alignment.
+		Assert( ( reinterpret_cast<size_t>( pMemory ) & 15 ) == 0 );
+	}
+
+	InstanceRingBuffer::~InstanceRingBuffer()
+	{
+		if( m_bOwnsMemory )
+		{
+			_aligned_free( m_pData );
+		}
+	}
+
+	byte* InstanceRingBuffer::Allocate( u32 size, u32 alignment, u32& offset )
+	{
+		Assert( alignment > 0 );
+		Assert( ( alignment & ( alignment - 1 ) ) == 0 );
+
+		// Frames still waiting on a fence carry an End that Retire will move the tail to.
+		u32 used = GetUsedSize();
+		if( used == 0 && m_frames.empty() )
+		{
+			m_head = 0;
+			m_tail = 0;
+		}
+		else if( used == m_capacity )
+		{
+			return NULL;
+		}
+
+		u32 start = ( m_head + alignment - 1 ) & ~( alignment - 1 );
+		u32 consumed = 0;
+
+		if( m_head >= m_tail )
+		{
+			if( start <= m_capacity && size <= m_capacity - start )
+			{
+				consumed = start - m_head + size;
+			}
+			else if( size <= m_tail )
+			{
+				// Skip the end of the ring and start over at the beginning.
+				consumed = m_capacity - m_head + size;
+				start = 0;
+			}
+			else
+			{
+				return NULL;
+			}
+		}
+		else
+		{
+			if( start <= m_tail && size <= m_tail - start )
+			{
+				consumed = start - m_head + size;
+			}
+			else
+			{
+				return NULL;
+			}
+		}
+
+		m_head = start + size;
+		m_allocated += consumed;
+
+		offset = start;
+		return m_pData + start;
+	}
+
+	void InstanceRingBuffer::EndFrame( u64 fence )
+	{
+		Assert( m_frames.empty() || m_frames.back().Fence <= fence );
+
+		// A frame that allocated nothing has nothing for the GPU to read.
+		u64 previous = m_frames.empty() ? m_released : m_frames.back().Allocated;
+		if( m_allocated == previous )
+		{
+			return;
+		}
+
+		FrameMark mark;
+		mark.Fence = fence;
+		mark.Allocated = m_allocated;
+		mark.End = m_head;
+
+		m_frames.push_back( mark );
+	}
+
+	void InstanceRingBuffer::Retire( u64 completedFence )
+	{
+		size_t retired = 0;
+
+		while( retired < m_frames.size() && m_frames[ retired ].Fence <= completedFence )
+		{
+			m_released = m_frames[ retired ].Allocated;
+			m_tail = m_frames[ retired ].End;
+			++retired;
+		}
+
+		m_frames.erase( m_frames.begin(), m_frames.begin() + retired );
+	}
+}
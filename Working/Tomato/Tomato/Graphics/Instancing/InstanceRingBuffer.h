@@ -0,0 +1,64 @@
+#pragma once
+
+namespace Tomato
+{
+	// Ring of per-instance data shared with the GPU.
+	//
+	// The memory is either a persistently mapped buffer owned by the renderer or a staging
+	// block allocated here. Space written during a frame is handed to the GPU by EndFrame
+	// with a fence value and only becomes writable again once Retire reports that fence as
+	// completed, so the CPU never overwrites instances the GPU may still be reading.
+	class TOMATO_API InstanceRingBuffer
+	{
+	public:
+		// Staging memory owned by the ring.
+		explicit InstanceRingBuffer( u32 capacity );
+
+		// External memory, e.g. a persistently mapped vertex buffer; not freed by the ring.
+		// Must be 16 byte aligned.
+		InstanceRingBuffer( void* pMemory, u32 capacity );
+
+		~InstanceRingBuffer();
+
+	public:
+		byte* GetData() const { return m_pData; }
+		u32 GetCapacity() const { return m_capacity; }
+
+		// Bytes still in flight or written this frame, including padding lost to wrapping.
+		u32 GetUsedSize() const { return static_cast<u32>( m_allocated - m_released ); }
+
+		// Returns NULL when the space is still owned by the GPU; Retire and try again.
+		byte* Allocate( u32 size, u32 alignment, u32& offset );
+
+		// Everything allocated since the previous EndFrame is read by the GPU until fence completes.
+		void EndFrame( u64 fence );
+
+		// Releases the frames whose fence is less than or equal to completedFence.
+		void Retire( u64 completedFence );
+
+	private:
+		InstanceRingBuffer( const InstanceRingBuffer& copy );
+		InstanceRingBuffer& operator = ( const InstanceRingBuffer& copy );
+
+		struct FrameMark
+		{
+			u64 Fence;
+			u64 Allocated;
+			u32 End;
+		};
+
+	private:
+		byte* m_pData;
+		bool m_bOwnsMemory;
+		u32 m_capacity;
+
+		u32 m_head;
+		u32 m_tail;
+
+		// Running byte totals; the difference is the space in use.
+		u64 m_allocated;
+		u64 m_released;
+
+		std::vector<FrameMark> m_frames;
+	};
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "InstanceRingBuffer.h"
+
+namespace Tomato
+{
+	// Packs instances of one InstanceFormat into an InstanceRingBuffer.
+	//
+	// Either hand over a whole array with Write, or Begin with an upper bound, Append one
+	// instance at a time and End. GetOffset and GetCount then describe the range to bind
+	// as the instance stream of the draw call.
+	template<typename Format>
+	class InstanceStreamWriter
+	{
+	public:
+		typedef typename Format::Instance Instance;
+
+		explicit InstanceStreamWriter( InstanceRingBuffer& buffer )
+			: m_buffer( buffer )
+			, m_pTarget( NULL )
+			, m_offset( 0 )
+			, m_count( 0 )
+			, m_maxCount( 0 )
+		{
+		}
+
+	public:
+		static u32 GetStride() { return Format::Stride; }
+
+		u32 GetOffset() const { return m_offset; }
+		s32 GetCount() const { return m_count; }
+
+		// Reserves room for maxCount instances; returns false when the ring has no space left this frame.
+		bool Begin( s32 maxCount )
+		{
+			Assert( m_pTarget == NULL );
+			Assert( maxCount > 0 );
+
+			byte* pTarget = m_buffer.Allocate( maxCount * Format::Stride, 16, m_offset );
+			if( pTarget == NULL )
+			{
+				return false;
+			}
+
+			m_pTarget = reinterpret_cast<f32*>( pTarget );
+			m_count = 0;
+			m_maxCount = maxCount;
+
+			return true;
+		}
+
+		void Append( const Instance& instance )
+		{
+			Assert( m_pTarget != NULL );
+			Assert( m_count < m_maxCount );
+
+			Format::Pack( instance, m_pTarget + m_count * ( Format::Stride / sizeof( f32 ) ) );
+			++m_count;
+		}
+
+		// Returns the number of instances written since Begin.
+		s32 End()
+		{
+			Assert( m_pTarget != NULL );
+
+			// Streaming stores must be visible before the GPU is told to read.
+			_mm_sfence();
+
+			m_pTarget = NULL;
+			return m_count;
+		}
+
+		bool Write( const Instance* pInstances, s32 count )
+		{
+			if( count == 0 )
+			{
+				m_count = 0;
+				return true;
+			}
+
+			if( !Begin( count ) )
+			{
+				return false;
+			}
+
+			for( s32 i = 0; i < count; ++i )
+			{
+				Append( pInstances[ i ] );
+			}
+
+			End();
+			return true;
+		}
+
+		// Writes pInstances[ pIndices[ i ] ], e.g. only the instances that passed culling.
+		bool Write( const Instance* pInstances, const u32* pIndices, s32 count )
+		{
+			if( count == 0 )
+			{
+				m_count = 0;
+				return true;
+			}
+
+			if( !Begin( count ) )
+			{
+				return false;
+			}
+
+			for( s32 i = 0; i < count; ++i )
+			{
+				Append( pInstances[ pIndices[ i ] ] );
+			}
+
+			End();
+			return true;
+		}
+
+	private:
+		InstanceStreamWriter( const InstanceStreamWriter& copy );
+		InstanceStreamWriter& operator = ( const InstanceStreamWriter& copy );
+
+	private:
+		InstanceRingBuffer& m_buffer;
+		f32* m_pTarget;
+		u32 m_offset;
+		s32 m_count;
+		s32 m_maxCount;
+	};
+}
@@ -0,0 +1,210 @@
+#include "TomatoPCH.h"
+
+#include "LightProbeGrid.h"
+
+namespace Tomato
+{
+	class LightProbeGrid::BakeBody
+	{
+	public:
+		BakeBody( LightProbeGrid& grid, BakeFunction function, void* pContext )
+			: m_grid( grid )
+			, m_function( function )
+			, m_pContext( pContext )
+		{
+		}
+
+		void operator () ( s32 begin, s32 end )
+		{
+			for( s32 i = begin; i < end; ++i )
+			{
+				s32 x = i % m_grid.m_countX;
+				s32 y = ( i / m_grid.m_countX ) % m_grid.m_countY;
+				s32 z = i / ( m_grid.m_countX * m_grid.m_countY );
+
+				m_function( m_pContext, m_grid.GetProbePosition( x, y, z ), m_grid.m_probes[ i ] );
+			}
+		}
+
+	private:
+		BakeBody& operator = ( const BakeBody& );
+
+		LightProbeGrid& m_grid;
+		BakeFunction m_function;
+		void* m_pContext;
+	};
+
+	class LightProbeGrid::SampleBody
+	{
+	public:
+		SampleBody( const LightProbeGrid& grid, const Vector3* pPositions, SphericalHarmonics* pResults )
+			: m_grid( grid )
+			, m_pPositions( pPositions )
+			, m_pResults( pResults )
+		{
+		}
+
+		void operator () ( s32 begin, s32 end )
+		{
+			for( s32 i = begin; i < end; ++i )
+			{
+				m_pResults[ i ] = m_grid.Sample( m_pPositions[ i ] );
+			}
+		}
+
+	private:
+		SampleBody& operator = ( const SampleBody& );
+
+		const LightProbeGrid& m_grid;
+		const Vector3* m_pPositions;
+		SphericalHarmonics* m_pResults;
+	};
+
+	class LightProbeGrid::EvaluateBody
+	{
+	public:
+		EvaluateBody( const LightProbeGrid& grid, const Vector3* pPositions, const Vector3* pNormals, Vector3* pResults )
+			: m_grid( grid )
+			, m_pPositions( pPositions )
+			, m_pNormals( pNormals )
+			, m_pResults( pResults )
+		{
+		}
+
+		void operator () ( s32 begin, s32 end )
+		{
+			for( s32 i = begin; i < end; ++i )
+			{
+				m_pResults[ i ] = m_grid.Sample( m_pPositions[ i ] ).Evaluate( m_pNormals[ i ] );
+			}
+		}
+
+	private:
+		EvaluateBody& operator = ( const EvaluateBody& );
+
+		const LightProbeGrid& m_grid;
+		const Vector3* m_pPositions;
+		const Vector3* m_pNormals;
+		Vector3* m_pResults;
+	};
+
+	LightProbeGrid::LightProbeGrid()
+		: m_bounds()
+		, m_countX( 0 )
+		, m_countY( 0 )
+		, m_countZ( 0 )
+		, m_inverseSpacing()
+	{
+	}
+
+	LightProbeGrid::~LightProbeGrid()
+	{
+	}
+
+	void LightProbeGrid::Create( const BoundingBox& bounds, s32 countX, s32 countY, s32 countZ, s32 order )
+	{
+		Assert( countX > 1 && countY > 1 && countZ > 1 );
+
+		m_bounds = bounds;
+		m_countX = countX;
+		m_countY = countY;
+		m_countZ = countZ;
+
+		Vector3 size = bounds.Max - bounds.Min;
+		m_inverseSpacing.Set(
+			( size.X > 0.0f ) ? ( countX - 1 ) / size.X : 0.0f,
+			( size.Y > 0.0f ) ? ( countY - 1 ) / size.Y : 0.0f,
+			( size.Z > 0.0f ) ? ( countZ - 1 ) / size.Z : 0.0f );
+
+		m_probes.assign( countX * countY * countZ, SphericalHarmonics( order ) );
+	}
+
+	Vector3 LightProbeGrid::GetProbePosition( s32 x, s32 y, s32 z ) const
+	{
+		Vector3 size = m_bounds.Max - m_bounds.Min;
+
+		return m_bounds.Min + Vector3(
+			size.X * x / ( m_countX - 1 ),
+			size.Y * y / ( m_countY - 1 ),
+			size.Z * z / ( m_countZ - 1 ) );
+	}
+
+	SphericalHarmonics& LightProbeGrid::GetProbe( s32 x, s32 y, s32 z )
+	{
+		Assert( x >= 0 && x < m_countX && y >= 0 && y < m_countY && z >= 0 && z < m_countZ );
+
+		return m_probes[ ( z * m_countY + y ) * m_countX + x ];
+	}
+
+	const SphericalHarmonics& LightProbeGrid::GetProbe( s32 x, s32 y, s32 z ) const
+	{
+		Assert( x >= 0 && x < m_countX && y >= 0 && y < m_countY && z >= 0 && z < m_countZ );
+
+		return m_probes[ ( z * m_countY + y ) * m_countX + x ];
+	}
+
+	void LightProbeGrid::Bake( BakeFunction function, void* pContext )
+	{
+		Assert( function != NULL );
+
+		BakeBody body( *this, function, pContext );
+		Parallel::For( 0, static_cast<s32>( m_probes.size() ), 1, body );
+	}
+
+	SphericalHarmonics LightProbeGrid::Sample( const Vector3& position ) const
+	{
+		Assert( !m_probes.empty() );
+
+		const s32 counts[ 3 ] = { m_countX, m_countY, m_countZ };
+
+		s32 cell[ 3 ];
+		f32 fraction[ 3 ];
+
+		for( s32 axis = 0; axis < 3; ++axis )
+		{
+			f32 coordinate = ( position[ axis ] - m_bounds.Min[ axis ] ) * m_inverseSpacing[ axis ];
+			coordinate = Math::Max( 0.0f, Math::Min( coordinate, static_cast<f32>( counts[ axis ] - 1 ) ) );
+
+			cell[ axis ] = Math::Min( static_cast<s32>( coordinate ), counts[ axis ] - 2 );
+			fraction[ axis ] = coordinate - cell[ axis ];
+		}
+
+		SphericalHarmonics result( m_probes[ 0 ].GetOrder() );
+
+		for( s32 corner = 0; corner < 8; ++corner )
+		{
+			s32 dx = corner & 1;
+			s32 dy = ( corner >> 1 ) & 1;
+			s32 dz = ( corner >> 2 ) & 1;
+
+			f32 weight = ( dx ? fraction[ 0 ] : 1.0f - fraction[ 0 ] )
+				* ( dy ? fraction[ 1 ] : 1.0f - fraction[ 1 ] )
+				* ( dz ? fraction[ 2 ] : 1.0f - fraction[ 2 ] );
+
+			const SphericalHarmonics& probe = GetProbe( cell[ 0 ] + dx, cell[ 1 ] + dy, cell[ 2 ] + dz );
+
+			for( s32 i = 0; i < result.GetCoefficientCount(); ++i )
+			{
+				result.Coefficients[ i ] += probe.Coefficients[ i ] * weight;
+			}
+		}
+
+		return result;
+	}
+
+	void LightProbeGrid::Sample( const Vector3* pPositions, s32 count, SphericalHarmonics* pResults ) const
+	{
+		Assert( count == 0 || ( pPositions != NULL && pResults != NULL ) );
+
+		SampleBody body( *this, pPositions, pResults );
+		Parallel::For( 0, count, 256, body );
+	}
+
+	void LightProbeGrid::Evaluate( const Vector3* pPositions, const Vector3* pNormals, s32 count, Vector3* pResults ) const
+	{
+		Assert( count == 0 || ( pPositions != NULL && pNormals != NULL && pResults != NULL ) );
+
+		EvaluateBody body( *this, pPositions, pNormals, pResults );
+		Parallel::For( 0, count, 256, body );
+	}
+}
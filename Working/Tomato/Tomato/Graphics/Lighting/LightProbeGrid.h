@@ -0,0 +1,65 @@
+#pragma once
+
+namespace Tomato
+{
+	// Regular 3D grid of spherical harmonics light probes spanning a bounding box.
+	//
+	// Probes are baked once through a callback, then sampled at any position with trilinear
+	// interpolation of the eight surrounding probes. Objects take ambient light from one sample
+	// at their center; Evaluate returns the irradiance for many positions and normals at once.
+	class TOMATO_API LightProbeGrid
+	{
+	public:
+		// Fills the probe at the given world position.
+		typedef void ( *BakeFunction )( void* pContext, const Vector3& position, SphericalHarmonics& probe );
+
+		LightProbeGrid();
+		~LightProbeGrid();
+
+	public:
+		// Every count must be at least 2; probes sit on the corners and faces of the box.
+		void Create( const BoundingBox& bounds, s32 countX, s32 countY, s32 countZ, s32 order );
+
+		const BoundingBox& GetBounds() const { return m_bounds; }
+		s32 GetCountX() const { return m_countX; }
+		s32 GetCountY() const { return m_countY; }
+		s32 GetCountZ() const { return m_countZ; }
+
+		Vector3 GetProbePosition( s32 x, s32 y, s32 z ) const;
+
+		SphericalHarmonics& GetProbe( s32 x, s32 y, s32 z );
+		const SphericalHarmonics& GetProbe( s32 x, s32 y, s32 z ) const;
+
+		// Calls the function for every probe, spread over the worker threads.
+		void Bake( BakeFunction function, void* pContext );
+
+		// Positions outside the bounds take the nearest probes on the boundary.
+		SphericalHarmonics Sample( const Vector3& position ) const;
+
+		// Sample for many positions, spread over the worker threads.
+		void Sample( const Vector3* pPositions, s32 count, SphericalHarmonics* pResults ) const;
+
+		// Sample( pPositions[ i ] ).Evaluate( pNormals[ i ] ), spread over the worker threads.
+		void Evaluate( const Vector3* pPositions, const Vector3* pNormals, s32 count, Vector3* pResults ) const;
+
+	private:
+		LightProbeGrid( const LightProbeGrid& copy );
+		LightProbeGrid& operator = ( const LightProbeGrid& copy );
+
+		class BakeBody;
+		class SampleBody;
+		class EvaluateBody;
+
+	private:
+		BoundingBox m_bounds;
+
+		s32 m_countX;
+		s32 m_countY;
+		s32 m_countZ;
+
+		// Probes per unit of distance on each axis.
+		Vector3 m_inverseSpacing;
+
+		std::vector<SphericalHarmonics> m_probes;
+	};
+}
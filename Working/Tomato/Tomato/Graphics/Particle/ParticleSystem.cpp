@@ -0,0 +1,396 @@
+#include "TomatoPCH.h"
+
+#include "ParticleSystem.h"
+
+#include <malloc.h>
+#include <emmintrin.h>
+
+namespace Tomato
+{
+	namespace
+	{
+		s32 RoundUp( s32 value, s32 multiple )
+		{
+			return ( ( value + multiple - 1 ) / multiple ) * multiple;
+		}
+
+		// Four independent xorshift32 generators.
+		__m128i NextRandom( __m128i& state )
+		{
+			__m128i x = state;
+			x = _mm_xor_si128( x, _mm_slli_epi32( x, 13 ) );
+			x = _mm_xor_si128( x, _mm_srli_epi32( x, 17 ) );
+			x = _mm_xor_si128( x, _mm_slli_epi32( x, 5 ) );
+			state = x;
+			return x;
+		}
+
+		// Uniform in [ -1, 1 ).
+		__m128 NextSignedRandom( __m128i& state )
+		{
+			__m128i bits = _mm_or_si128( _mm_srli_epi32( NextRandom( state ), 9 ), _mm_set1_epi32( 0x40000000 ) );
+			return _mm_sub_ps( _mm_castsi128_ps( bits ), _mm_set1_ps( 3.0f ) );
+		}
+
+		__m128 Spread( __m128i& state, f32 value, f32 spread )
+		{
+			return _mm_add_ps( _mm_set1_ps( value ), _mm_mul_ps( _mm_set1_ps( spread ), NextSignedRandom( state ) ) );
+		}
+
+		// Stores the first count lanes of v to an unaligned address.
+		void StorePartial( f32* pTarget, __m128 v, s32 count )
+		{
+			if( count >= 4 )
+			{
+				_mm_storeu_ps( pTarget, v );
+				return;
+			}
+
+			__declspec( align( 16 ) ) f32 lanes[ 4 ];
+			_mm_store_ps( lanes, v );
+
+			for( s32 i = 0; i < count; ++i )
+			{
+				pTarget[ i ] = lanes[ i ];
+			}
+		}
+	}
+
+	ParticleSystem::EmitParameters::EmitParameters()
+		: Position()
+		, PositionSpread()
+		, Velocity()
+		, VelocitySpread()
+		, Color( 1.0f, 1.0f, 1.0f, 1.0f )
+		, Lifetime( 1.0f )
+		, LifetimeSpread( 0.0f )
+		, Size( 1.0f )
+		, SizeSpread( 0.0f )
+	{
+	}
+
+	ParticleSystem::UpdateParameters::UpdateParameters()
+		: ElapsedTime( 0.0f )
+		, Acceleration()
+		, Drag( 0.0f )
+	{
+	}
+
+	class ParticleSystem::UpdateBody
+	{
+	public:
+		UpdateBody( ParticleSystem& system, const UpdateParameters& parameters )
+			: m_system( system )
+			, m_parameters( parameters )
+		{
+		}
+
+		void operator () ( s32 begin, s32 end )
+		{
+			for( s32 i = begin; i < end; ++i )
+			{
+				m_system.UpdateChunk( i, m_parameters );
+			}
+		}
+
+	private:
+		UpdateBody& operator = ( const UpdateBody& );
+
+		ParticleSystem& m_system;
+		const UpdateParameters& m_parameters;
+	};
+
+	ParticleSystem::ParticleSystem( s32 capacity, u32 seed )
+		: m_capacity( RoundUp( capacity, 4 ) )
+		, m_count( 0 )
+		, m_pData( NULL )
+		, m_chunkCounts()
+		, m_sortKeys()
+		, m_sortScratch()
+	{
+		Assert( capacity > 0 );
+
+		size_t size = m_capacity * Attribute::Count * sizeof( f32 );
+		m_pData = static_cast<f32*>( _aligned_malloc( size, 16 ) );
+
+		// Padding lanes are processed too; keep them finite.
+		::ZeroMemory( m_pData, size );
+
+		m_chunkCounts.resize( ( m_capacity + ChunkSize - 1 ) / ChunkSize );
+
+		for( s32 i = 0; i < 4; ++i )
+		{
+			// xorshift must not start at zero.
+			m_randomState[ i ] = ( seed + i ) * 2654435761u;
+			if( m_randomState[ i ] == 0 )
+			{
+				m_randomState[ i ] = 0x9e3779b9u;
+			}
+		}
+	}
+
+	ParticleSystem::~ParticleSystem()
+	{
+		_aligned_free( m_pData );
+	}
+
+	void ParticleSystem::Clear()
+	{
+		m_count = 0;
+	}
+
+	s32 ParticleSystem::Emit( const EmitParameters& parameters, s32 count )
+	{
+		count = Math::Min( count, m_capacity - m_count );
+		if( count <= 0 )
+		{
+			return 0;
+		}
+
+		__m128i state = _mm_loadu_si128( reinterpret_cast<const __m128i*>( m_randomState ) );
+
+		s32 begin = m_count;
+		s32 end = m_count + count;
+
+		f32* pPositionX = GetAttribute( Attribute::PositionX );
+		f32* pPositionY = GetAttribute( Attribute::PositionY );
+		f32* pPositionZ = GetAttribute( Attribute::PositionZ );
+		f32* pVelocityX = GetAttribute( Attribute::VelocityX );
+		f32* pVelocityY = GetAttribute( Attribute::VelocityY );
+		f32* pVelocityZ = GetAttribute( Attribute::VelocityZ );
+		f32* pColorR = GetAttribute( Attribute::ColorR );
+		f32* pColorG = GetAttribute( Attribute::ColorG );
+		f32* pColorB = GetAttribute( Attribute::ColorB );
+		f32* pColorA = GetAttribute( Attribute::ColorA );
+		f32* pAge = GetAttribute( Attribute::Age );
+		f32* pLifetime = GetAttribute( Attribute::Lifetime );
+		f32* pSize = GetAttribute( Attribute::Size );
+
+		__m128 colorR = _mm_set1_ps( parameters.Color.X );
+		__m128 colorG = _mm_set1_ps( parameters.Color.Y );
+		__m128 colorB = _mm_set1_ps( parameters.Color.Z );
+		__m128 colorA = _mm_set1_ps( parameters.Color.W );
+		__m128 zero = _mm_setzero_ps();
+
+		for( s32 i = begin; i < end; i += 4 )
+		{
+			s32 lanes = end - i;
+
+			StorePartial( pPositionX + i, Spread( state, parameters.Position.X, parameters.PositionSpread.X ), lanes );
+			StorePartial( pPositionY + i, Spread( state, parameters.Position.Y, parameters.PositionSpread.Y ), lanes );
+			StorePartial( pPositionZ + i, Spread( state, parameters.Position.Z, parameters.PositionSpread.Z ), lanes );
+			StorePartial( pVelocityX + i, Spread( state, parameters.Velocity.X, parameters.VelocitySpread.X ), lanes );
+			StorePartial( pVelocityY + i, Spread( state, parameters.Velocity.Y, parameters.VelocitySpread.Y ), lanes );
+			StorePartial( pVelocityZ + i, Spread( state, parameters.Velocity.Z, parameters.VelocitySpread.Z ), lanes );
+			StorePartial( pColorR + i, colorR, lanes );
+			StorePartial( pColorG + i, colorG, lanes );
+			StorePartial( pColorB + i, colorB, lanes );
+			StorePartial( pColorA + i, colorA, lanes );
+			StorePartial( pAge + i, zero, lanes );
+			StorePartial( pLifetime + i, Spread( state, parameters.Lifetime, parameters.LifetimeSpread ), lanes );
+			StorePartial( pSize + i, Spread( state, parameters.Size, parameters.SizeSpread ), lanes );
+		}
+
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( m_randomState ), state );
+
+		m_count = end;
+		return count;
+	}
+
+	void ParticleSystem::Update( const UpdateParameters& parameters )
+	{
+		if( m_count == 0 )
+		{
+			return;
+		}
+
+		s32 chunkCount = ( m_count + ChunkSize - 1 ) / ChunkSize;
+
+		UpdateBody body( *this, parameters );
+		Parallel::For( 0, chunkCount, 1, body );
+
+		// Chunks are compacted in place; slide each one down behind its predecessors.
+		s32 count = 0;
+
+		for( s32 chunk = 0; chunk < chunkCount; ++chunk )
+		{
+			s32 first = chunk * ChunkSize;
+			s32 alive = m_chunkCounts[ chunk ];
+
+			if( count != first && alive > 0 )
+			{
+				for( s32 attribute = 0; attribute < Attribute::Count; ++attribute )
+				{
+					f32* pArray = m_pData + attribute * m_capacity;
+					::MoveMemory( pArray + count, pArray + first, alive * sizeof( f32 ) );
+				}
+			}
+
+			count += alive;
+		}
+
+		m_count = count;
+	}
+
+	void ParticleSystem::UpdateChunk( s32 chunk, const UpdateParameters& parameters )
+	{
+		s32 begin = chunk * ChunkSize;
+		s32 end = Math::Min( begin + ChunkSize, m_count );
+
+		f32* pPositionX = GetAttribute( Attribute::PositionX );
+		f32* pPositionY = GetAttribute( Attribute::PositionY );
+		f32* pPositionZ = GetAttribute( Attribute::PositionZ );
+		f32* pVelocityX = GetAttribute( Attribute::VelocityX );
+		f32* pVelocityY = GetAttribute( Attribute::VelocityY );
+		f32* pVelocityZ = GetAttribute( Attribute::VelocityZ );
+		f32* pAge = GetAttribute( Attribute::Age );
+		const f32* pLifetime = GetAttribute( Attribute::Lifetime );
+
+		f32 elapsedTime = parameters.ElapsedTime;
+
+		__m128 dt = _mm_set1_ps( elapsedTime );
+		__m128 damping = _mm_set1_ps( Math::Max( 1.0f - parameters.Drag * elapsedTime, 0.0f ) );
+		__m128 deltaVelocityX = _mm_set1_ps( parameters.Acceleration.X * elapsedTime );
+		__m128 deltaVelocityY = _mm_set1_ps( parameters.Acceleration.Y * elapsedTime );
+		__m128 deltaVelocityZ = _mm_set1_ps( parameters.Acceleration.Z * elapsedTime );
+
+		s32 deadMask = 0;
+
+		// Chunks start on a multiple of 4, so every group is aligned; lanes past end are padding.
+		for( s32 i = begin; i < end; i += 4 )
+		{
+			__m128 velocityX = _mm_add_ps( _mm_mul_ps( _mm_load_ps( pVelocityX + i ), damping ), deltaVelocityX );
+			__m128 velocityY = _mm_add_ps( _mm_mul_ps( _mm_load_ps( pVelocityY + i ), damping ), deltaVelocityY );
+			__m128 velocityZ = _mm_add_ps( _mm_mul_ps( _mm_load_ps( pVelocityZ + i ), damping ), deltaVelocityZ );
+
+			_mm_store_ps( pVelocityX + i, velocityX );
+			_mm_store_ps( pVelocityY + i, velocityY );
+			_mm_store_ps( pVelocityZ + i, velocityZ );
+
+			_mm_store_ps( pPositionX + i, _mm_add_ps( _mm_load_ps( pPositionX + i ), _mm_mul_ps( velocityX, dt ) ) );
+			_mm_store_ps( pPositionY + i, _mm_add_ps( _mm_load_ps( pPositionY + i ), _mm_mul_ps( velocityY, dt ) ) );
+			_mm_store_ps( pPositionZ + i, _mm_add_ps( _mm_load_ps( pPositionZ + i ), _mm_mul_ps( velocityZ, dt ) ) );
+
+			__m128 age = _mm_add_ps( _mm_load_ps( pAge + i ), dt );
+			_mm_store_ps( pAge + i, age );
+
+			s32 dead = _mm_movemask_ps( _mm_cmpge_ps( age, _mm_load_ps( pLifetime + i ) ) );
+			if( end - i < 4 )
+			{
+				dead &= ( 1 << ( end - i ) ) - 1;
+			}
+
+			deadMask |= dead;
+		}
+
+		if( deadMask == 0 )
+		{
+			m_chunkCounts[ chunk ] = end - begin;
+			return;
+		}
+
+		// Stable compaction of the chunk.
+		s32 write = begin;
+
+		for( s32 read = begin; read < end; ++read )
+		{
+			if( pAge[ read ] >= pLifetime[ read ] )
+			{
+				continue;
+			}
+
+			if( write != read )
+			{
+				for( s32 attribute = 0; attribute < Attribute::Count; ++attribute )
+				{
+					f32* pArray = m_pData + attribute * m_capacity;
+					pArray[ write ] = pArray[ read ];
+				}
+			}
+
+			++write;
+		}
+
+		m_chunkCounts[ chunk ] = write - begin;
+	}
+
+	void ParticleSystem::SortByDepth( const Vector3& viewPosition, const Vector3& viewDirection, u32* pOrder )
+	{
+		Assert( m_count == 0 || pOrder != NULL );
+
+		if( m_count == 0 )
+		{
+			return;
+		}
+
+		m_sortKeys.resize( m_capacity * 2 );
+		m_sortScratch.resize( m_count );
+
+		u32* pKeys = &m_sortKeys[ 0 ];
+		u32* pKeysScratch = pKeys + m_capacity;
+		u32* pIndices = pOrder;
+		u32* pIndicesScratch = &m_sortScratch[ 0 ];
+
+		const f32* pPositionX = GetAttribute( Attribute::PositionX );
+		const f32* pPositionY = GetAttribute( Attribute::PositionY );
+		const f32* pPositionZ = GetAttribute( Attribute::PositionZ );
+
+		__m128 directionX = _mm_set1_ps( viewDirection.X );
+		__m128 directionY = _mm_set1_ps( viewDirection.Y );
+		__m128 directionZ = _mm_set1_ps( viewDirection.Z );
+		__m128 offset = _mm_set1_ps( Vector3::Dot( viewPosition, viewDirection ) );
+		__m128i signBit = _mm_set1_epi32( 0x80000000 );
+		__m128i allBits = _mm_set1_epi32( -1 );
+
+		// Depth as an unsigned key that sorts farthest first: flip the float into unsigned order, then invert.
+		for( s32 i = 0; i < m_count; i += 4 )
+		{
+			__m128 depth = _mm_sub_ps(
+				_mm_add_ps( _mm_add_ps(
+					_mm_mul_ps( _mm_load_ps( pPositionX + i ), directionX ),
+					_mm_mul_ps( _mm_load_ps( pPositionY + i ), directionY ) ),
+					_mm_mul_ps( _mm_load_ps( pPositionZ + i ), directionZ ) ),
+				offset );
+
+			__m128i bits = _mm_castps_si128( depth );
+			__m128i flip = _mm_or_si128( _mm_srai_epi32( bits, 31 ), signBit );
+			__m128i key = _mm_xor_si128( _mm_xor_si128( bits, flip ), allBits );
+
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( pKeys + i ), key );
+		}
+
+		for( s32 i = 0; i < m_count; ++i )
+		{
+			pIndices[ i ] = i;
+		}
+
+		// LSD radix sort, 8 bits per pass; stable, and the even pass count leaves the result in pOrder.
+		for( s32 shift = 0; shift < 32; shift += 8 )
+		{
+			s32 histogram[ 256 ] = { 0 };
+
+			for( s32 i = 0; i < m_count; ++i )
+			{
+				++histogram[ ( pKeys[ i ] >> shift ) & 0xff ];
+			}
+
+			s32 sum = 0;
+			for( s32 i = 0; i < 256; ++i )
+			{
+				s32 bucket = histogram[ i ];
+				histogram[ i ] = sum;
+				sum += bucket;
+			}
+
+			for( s32 i = 0; i < m_count; ++i )
+			{
+				s32 target = histogram[ ( pKeys[ i ] >> shift ) & 0xff ]++;
+				pKeysScratch[ target ] = pKeys[ i ];
+				pIndicesScratch[ target ] = pIndices[ i ];
+			}
+
+			std::swap( pKeys, pKeysScratch );
+			std::swap( pIndices, pIndicesScratch );
+		}
+	}
+}
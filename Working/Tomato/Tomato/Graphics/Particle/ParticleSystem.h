@@ -0,0 +1,110 @@
+#pragma once
+
+namespace Tomato
+{
+	// Particle storage and simulation for large particle counts.
+	//
+	// Every attribute lives in its own 16 byte aligned array (structure of arrays) so the
+	// kernels process four particles per SSE instruction. Live particles are always packed
+	// at the front of the arrays in emission order: Update removes expired particles with a
+	// stable compaction, so particles never reorder between frames.
+	class TOMATO_API ParticleSystem
+	{
+	public:
+		struct Attribute
+		{
+			enum Type
+			{
+				PositionX,
+				PositionY,
+				PositionZ,
+				VelocityX,
+				VelocityY,
+				VelocityZ,
+				ColorR,
+				ColorG,
+				ColorB,
+				ColorA,
+				Age,
+				Lifetime,
+				Size,
+
+				Count
+			};
+		};
+
+		// Every emitted particle gets value + spread * random[ -1, 1 ] per component.
+		struct EmitParameters
+		{
+			EmitParameters();
+
+			Vector3 Position;
+			Vector3 PositionSpread;
+			Vector3 Velocity;
+			Vector3 VelocitySpread;
+			Vector4 Color;
+			f32 Lifetime;
+			f32 LifetimeSpread;
+			f32 Size;
+			f32 SizeSpread;
+		};
+
+		struct UpdateParameters
+		{
+			UpdateParameters();
+
+			f32 ElapsedTime;
+			Vector3 Acceleration;
+
+			// Fraction of velocity lost per second.
+			f32 Drag;
+		};
+
+		explicit ParticleSystem( s32 capacity, u32 seed = 1 );
+		~ParticleSystem();
+
+	public:
+		s32 GetCount() const { return m_count; }
+		s32 GetCapacity() const { return m_capacity; }
+
+		// Arrays hold GetCount() live particles and are readable up to the next multiple of 4.
+		f32* GetAttribute( Attribute::Type attribute ) { return m_pData + attribute * m_capacity; }
+		const f32* GetAttribute( Attribute::Type attribute ) const { return m_pData + attribute * m_capacity; }
+
+		void Clear();
+
+		// Returns the number of particles actually emitted, limited by the free capacity.
+		s32 Emit( const EmitParameters& parameters, s32 count );
+
+		// Integrates all particles on the worker threads and removes those that outlived their lifetime.
+		void Update( const UpdateParameters& parameters );
+
+		// Fills pOrder with GetCount() particle indices sorted back to front along viewDirection,
+		// for alpha blending. The particle arrays themselves are left in place.
+		void SortByDepth( const Vector3& viewPosition, const Vector3& viewDirection, u32* pOrder );
+
+	private:
+		ParticleSystem( const ParticleSystem& copy );
+		ParticleSystem& operator = ( const ParticleSystem& copy );
+
+		enum { ChunkSize = 8192 };
+
+		class UpdateBody;
+
+		void UpdateChunk( s32 chunk, const UpdateParameters& parameters );
+
+	private:
+		s32 m_capacity;
+		s32 m_count;
+
+		f32* m_pData;
+
+		// Live particles left at the front of each chunk after UpdateChunk.
+		std::vector<s32> m_chunkCounts;
+
+		u32 m_randomState[ 4 ];
+
+		std::vector<u32> m_sortKeys;
+		std::vector<u32> m_sortScratch;
+	};
+}
@@ -0,0 +1,302 @@
+#include "TomatoPCH.h"
+
+#include "TerrainQuadtree.h"
+
+namespace Tomato
+{
+	namespace
+	{
+		f32 DistanceSquared( const BoundingBox& box, const Vector3& point )
+		{
+			f32 distanceSquared = 0.0f;
+
+			for( s32 i = 0; i < 3; ++i )
+			{
+				f32 d = Math::Max( box.Min[ i ] - point[ i ], 0.0f ) + Math::Max( point[ i ] - box.Max[ i ], 0.0f );
+				distanceSquared += d * d;
+			}
+
+			return distanceSquared;
+		}
+	}
+
+	// Height bounds of the leaf level, a row of leaves per index.
+	class TerrainQuadtree::BuildBody
+	{
+	public:
+		BuildBody( const f32* pHeights, s32 width, s32 leafSize, s32 quadCountX, s32 quadCountZ, Level& level )
+			: m_pHeights( pHeights )
+			, m_width( width )
+			, m_leafSize( leafSize )
+			, m_quadCountX( quadCountX )
+			, m_quadCountZ( quadCountZ )
+			, m_level( level )
+		{
+		}
+
+		void operator () ( s32 begin, s32 end )
+		{
+			for( s32 nodeZ = begin; nodeZ < end; ++nodeZ )
+			{
+				s32 firstZ = nodeZ * m_leafSize;
+				s32 lastZ = Math::Min( firstZ + m_leafSize, m_quadCountZ );
+
+				for( s32 nodeX = 0; nodeX < m_level.NodeCountX; ++nodeX )
+				{
+					s32 firstX = nodeX * m_leafSize;
+					s32 lastX = Math::Min( firstX + m_leafSize, m_quadCountX );
+
+					f32 minHeight = Math::FloatPositiveMax;
+					f32 maxHeight = -Math::FloatPositiveMax;
+
+					// Samples on the node border are shared with the neighbours.
+					for( s32 z = firstZ; z <= lastZ; ++z )
+					{
+						const f32* pRow = m_pHeights + z * m_width;
+
+						for( s32 x = firstX; x <= lastX; ++x )
+						{
+							minHeight = Math::Min( minHeight, pRow[ x ] );
+							maxHeight = Math::Max( maxHeight, pRow[ x ] );
+						}
+					}
+
+					s32 index = nodeZ * m_level.NodeCountX + nodeX;
+					m_level.MinHeights[ index ] = minHeight;
+					m_level.MaxHeights[ index ] = maxHeight;
+				}
+			}
+		}
+
+	private:
+		BuildBody& operator = ( const BuildBody& );
+
+		const f32* m_pHeights;
+		s32 m_width;
+		s32 m_leafSize;
+		s32 m_quadCountX;
+		s32 m_quadCountZ;
+		Level& m_level;
+	};
+
+	TerrainQuadtree::CreateParameters::CreateParameters()
+		: Origin( 0.0f, 0.0f, 0.0f )
+		, Spacing( 1.0f )
+		, HeightScale( 1.0f )
+		, LeafSize( 32 )
+		, LodCount( 6 )
+		, FirstRange( 64.0f )
+		, RangeRatio( 2.0f )
+		, MorphStartRatio( 0.66f )
+	{
+	}
+
+	TerrainQuadtree::TerrainQuadtree()
+		: m_quadCountX( 0 )
+		, m_quadCountZ( 0 )
+	{
+	}
+
+	TerrainQuadtree::~TerrainQuadtree()
+	{
+	}
+
+	void TerrainQuadtree::Create( const f32* pHeights, s32 width, s32 height, const CreateParameters& parameters )
+	{
+		Assert( pHeights != NULL );
+		Assert( width > 1 && height > 1 );
+		Assert( parameters.LeafSize > 0 && ( parameters.LeafSize & ( parameters.LeafSize - 1 ) ) == 0 );
+		Assert( parameters.LodCount > 0 && parameters.LodCount < 16 );
+		Assert( parameters.Spacing > 0.0f );
+		Assert( parameters.FirstRange > 0.0f );
+		Assert( parameters.RangeRatio >= 2.0f );
+
+		m_parameters = parameters;
+		m_quadCountX = width - 1;
+		m_quadCountZ = height - 1;
+
+		m_levels.clear();
+		m_levels.resize( parameters.LodCount );
+
+		for( s32 lod = 0; lod < parameters.LodCount; ++lod )
+		{
+			s32 nodeSize = parameters.LeafSize << lod;
+
+			Level& level = m_levels[ lod ];
+			level.NodeCountX = ( m_quadCountX + nodeSize - 1 ) / nodeSize;
+			level.NodeCountZ = ( m_quadCountZ + nodeSize - 1 ) / nodeSize;
+			level.MinHeights.resize( level.NodeCountX * level.NodeCountZ );
+			level.MaxHeights.resize( level.NodeCountX * level.NodeCountZ );
+		}
+
+		BuildBody body( pHeights, width, parameters.LeafSize, m_quadCountX, m_quadCountZ, m_levels[ 0 ] );
+		Parallel::For( 0, m_levels[ 0 ].NodeCountZ, 4, body );
+
+		// Every parent merges the children that exist; nodes on the far edges may have fewer than four.
+		for( s32 lod = 1; lod < parameters.LodCount; ++lod )
+		{
+			const Level& children = m_levels[ lod - 1 ];
+			Level& level = m_levels[ lod ];
+
+			for( s32 z = 0; z < level.NodeCountZ; ++z )
+			{
+				for( s32 x = 0; x < level.NodeCountX; ++x )
+				{
+					f32 minHeight = Math::FloatPositiveMax;
+					f32 maxHeight = -Math::FloatPositiveMax;
+
+					for( s32 childZ = z * 2; childZ < Math::Min( z * 2 + 2, children.NodeCountZ ); ++childZ )
+					{
+						for( s32 childX = x * 2; childX < Math::Min( x * 2 + 2, children.NodeCountX ); ++childX )
+						{
+							s32 childIndex = childZ * children.NodeCountX + childX;
+							minHeight = Math::Min( minHeight, children.MinHeights[ childIndex ] );
+							maxHeight = Math::Max( maxHeight, children.MaxHeights[ childIndex ] );
+						}
+					}
+
+					level.MinHeights[ z * level.NodeCountX + x ] = minHeight;
+					level.MaxHeights[ z * level.NodeCountX + x ] = maxHeight;
+				}
+			}
+		}
+
+		m_ranges.resize( parameters.LodCount );
+		m_morphStarts.resize( parameters.LodCount );
+
+		f32 previousRange = 0.0f;
+		f32 range = parameters.FirstRange;
+
+		for( s32 lod = 0; lod < parameters.LodCount; ++lod )
+		{
+			m_ranges[ lod ] = range;
+			m_morphStarts[ lod ] = previousRange + ( range - previousRange ) * parameters.MorphStartRatio;
+
+			previousRange = range;
+			range *= parameters.RangeRatio;
+		}
+	}
+
+	f32 TerrainQuadtree::GetRange( s32 lod ) const
+	{
+		Assert( lod >= 0 && lod < static_cast<s32>( m_ranges.size() ) );
+
+		return m_ranges[ lod ];
+	}
+
+	BoundingBox TerrainQuadtree::GetBounds() const
+	{
+		Assert( !m_levels.empty() );
+
+		const Level& top = m_levels.back();
+
+		BoundingBox bounds = GetNodeBounds( m_parameters.LodCount - 1, 0, 0 );
+		for( s32 i = 1; i < top.NodeCountX * top.NodeCountZ; ++i )
+		{
+			bounds = BoundingBox::Merge( bounds, GetNodeBounds( m_parameters.LodCount - 1, i % top.NodeCountX, i / top.NodeCountX ) );
+		}
+
+		return bounds;
+	}
+
+	void TerrainQuadtree::Select( const Vector3& cameraPosition, const Matrix4& viewProjection, std::vector<TerrainPatch>& patches ) const
+	{
+		Assert( !m_levels.empty() );
+
+		SelectContext context;
+		context.CameraPosition = cameraPosition;
+		context.ViewFrustum.Set( viewProjection );
+		context.pPatches = &patches;
+
+		s32 topLod = m_parameters.LodCount - 1;
+		const Level& top = m_levels[ topLod ];
+
+		// Top level nodes beyond the coarsest range are still drawn at the coarsest level.
+		for( s32 z = 0; z < top.NodeCountZ; ++z )
+		{
+			for( s32 x = 0; x < top.NodeCountX; ++x )
+			{
+				if( SelectNode( context, topLod, x, z ) == Selection::OutOfRange )
+				{
+					AddPatch( context, topLod, x, z );
+				}
+			}
+		}
+	}
+
+	BoundingBox TerrainQuadtree::GetNodeBounds( s32 lod, s32 x, s32 z ) const
+	{
+		const Level& level = m_levels[ lod ];
+		s32 nodeSize = m_parameters.LeafSize << lod;
+		s32 index = z * level.NodeCountX + x;
+
+		// Clamped to the heightmap; nodes on the far edges may extend beyond it.
+		s32 firstX = x * nodeSize;
+		s32 firstZ = z * nodeSize;
+		s32 lastX = Math::Min( firstX + nodeSize, m_quadCountX );
+		s32 lastZ = Math::Min( firstZ + nodeSize, m_quadCountZ );
+
+		const Vector3& origin = m_parameters.Origin;
+		f32 spacing = m_parameters.Spacing;
+		f32 heightScale = m_parameters.HeightScale;
+
+		return BoundingBox(
+			Vector3( origin.X + firstX * spacing, origin.Y + level.MinHeights[ index ] * heightScale, origin.Z + firstZ * spacing ),
+			Vector3( origin.X + lastX * spacing, origin.Y + level.MaxHeights[ index ] * heightScale, origin.Z + lastZ * spacing ) );
+	}
+
+	TerrainQuadtree::Selection::Type TerrainQuadtree::SelectNode( SelectContext& context, s32 lod, s32 x, s32 z ) const
+	{
+		BoundingBox bounds = GetNodeBounds( lod, x, z );
+
+		if( !context.ViewFrustum.Intersects( bounds ) )
+		{
+			return Selection::Culled;
+		}
+
+		f32 distanceSquared = DistanceSquared( bounds, context.CameraPosition );
+
+		if( distanceSquared > m_ranges[ lod ] * m_ranges[ lod ] )
+		{
+			return Selection::OutOfRange;
+		}
+
+		if( lod == 0 || distanceSquared > m_ranges[ lod - 1 ] * m_ranges[ lod - 1 ] )
+		{
+			AddPatch( context, lod, x, z );
+			return Selection::Selected;
+		}
+
+		// Part of the node is close enough for the next level. Children that are not are drawn
+		// with the finer patch size but fully morphed, which is the resolution of this level.
+		const Level& children = m_levels[ lod - 1 ];
+
+		for( s32 childZ = z * 2; childZ < Math::Min( z * 2 + 2, children.NodeCountZ ); ++childZ )
+		{
+			for( s32 childX = x * 2; childX < Math::Min( x * 2 + 2, children.NodeCountX ); ++childX )
+			{
+				if( SelectNode( context, lod - 1, childX, childZ ) == Selection::OutOfRange )
+				{
+					AddPatch( context, lod - 1, childX, childZ );
+				}
+			}
+		}
+
+		return Selection::Selected;
+	}
+
+	void TerrainQuadtree::AddPatch( SelectContext& context, s32 lod, s32 x, s32 z ) const
+	{
+		s32 nodeSize = m_parameters.LeafSize << lod;
+
+		TerrainPatch patch;
+		patch.Size = nodeSize * m_parameters.Spacing;
+		patch.X = m_parameters.Origin.X + x * patch.Size;
+		patch.Z = m_parameters.Origin.Z + z * patch.Size;
+		patch.MorphStart = m_morphStarts[ lod ];
+		patch.MorphEnd = m_ranges[ lod ];
+		patch.Lod = lod;
+
+		context.pPatches->push_back( patch );
+	}
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+namespace Tomato
+{
+	// One instance of the terrain grid mesh.
+	//
+	// The grid mesh spans [ 0, 1 ] on X and Z; the vertex shader scales it by Size, offsets it
+	// by ( X, Z ), samples the heightmap and moves every odd vertex onto the coarser grid as
+	// the camera distance goes from MorphStart to MorphEnd.
+	struct TerrainPatch
+	{
+		f32 X;
+		f32 Z;
+		f32 Size;
+		f32 MorphStart;
+		f32 MorphEnd;
+
+		// 0 is the finest level.
+		s32 Lod;
+	};
+
+	// Continuous distance-dependent level of detail terrain (Strugar, "Continuous Distance-Dependent
+	// Level of Detail for Rendering Heightmaps", 2009).
+	//
+	// A quadtree holds the minimum and maximum height under every node. Each frame the nodes
+	// are selected by their distance to the camera, so every patch has the same screen
+	// density regardless of its size and the whole terrain is drawn with a single instanced
+	// grid mesh. Levels are separated by distance ranges that double from one level to the
+	// next, and vertices morph between levels near the end of each range, so there is neither
+	// popping nor cracks between patches of different levels.
+	class TOMATO_API TerrainQuadtree
+	{
+	public:
+		struct CreateParameters
+		{
+			CreateParameters();
+
+			// World position of height sample ( 0, 0 ) at height 0.
+			Vector3 Origin;
+
+			// Distance between samples on X and Z.
+			f32 Spacing;
+
+			// World height of a sample value of 1.
+			f32 HeightScale;
+
+			// Quads per edge of the finest patch; must be a power of two.
+			s32 LeafSize;
+			s32 LodCount;
+
+			// Camera distance covered by the finest level, and the ratio between the ranges of two levels.
+			f32 FirstRange;
+			f32 RangeRatio;
+
+			// Fraction of a range after which the vertices start morphing to the next level.
+			f32 MorphStartRatio;
+		};
+
+		TerrainQuadtree();
+		~TerrainQuadtree();
+
+	public:
+		// Builds the height bounds of every node. The heights are read but not kept.
+		void Create( const f32* pHeights, s32 width, s32 height, const CreateParameters& parameters );
+
+		s32 GetLodCount() const { return m_parameters.LodCount; }
+
+		// Distance from the camera within which a level is used.
+		f32 GetRange( s32 lod ) const;
+
+		BoundingBox GetBounds() const;
+
+		// Appends the patches that cover the visible terrain around the camera.
+		// Patches come out grouped by top level node, nearest detail first within each group.
+		void Select( const Vector3& cameraPosition, const Matrix4& viewProjection, std::vector<TerrainPatch>& patches ) const;
+
+	private:
+		TerrainQuadtree( const TerrainQuadtree& copy );
+		TerrainQuadtree& operator = ( const TerrainQuadtree& copy );
+
+		class BuildBody;
+
+		// Minimum and maximum height of the nodes of one level, row by row.
+		struct Level
+		{
+			s32 NodeCountX;
+			s32 NodeCountZ;
+			std::vector<f32> MinHeights;
+			std::vector<f32> MaxHeights;
+		};
+
+		struct SelectContext
+		{
+			Vector3 CameraPosition;
+			Frustum ViewFrustum;
+			std::vector<TerrainPatch>* pPatches;
+		};
+
+		// Outcome of selecting a node.
+		struct Selection
+		{
+			enum Type
+			{
+				Culled,
+				OutOfRange,
+				Selected,
+			};
+		};
+
+		BoundingBox GetNodeBounds( s32 lod, s32 x, s32 z ) const;
+		Selection::Type SelectNode( SelectContext& context, s32 lod, s32 x, s32 z ) const;
+		void AddPatch( SelectContext& context, s32 lod, s32 x, s32 z ) const;
+
+	private:
+		CreateParameters m_parameters;
+
+		// Quads covered by the heightmap.
+		s32 m_quadCountX;
+		s32 m_quadCountZ;
+
+		std::vector<Level> m_levels;
+		std::vector<f32> m_ranges;
+		std::vector<f32> m_morphStarts;
+	};
+}
@@ -0,0 +1,109 @@
+#include "TomatoPCH.h"
+
+#include "BoundingBox.h"
+
+namespace Tomato
+{
+	BoundingBox::BoundingBox()
+		: Min()
+		, Max()
+	{
+	}
+
+	BoundingBox::BoundingBox( const Vector3& min, const Vector3& max )
+		: Min( min )
+		, Max( max )
+	{
+	}
+
+	BoundingBox::~BoundingBox()
+	{
+	}
+
+	void BoundingBox::Set( const Vector3& min, const Vector3& max )
+	{
+		Min = min;
+		Max = max;
+	}
+
+	Vector3 BoundingBox::GetCenter() const
+	{
+		return ( Min + Max ) * 0.5f;
+	}
+
+	Vector3 BoundingBox::GetExtents() const
+	{
+		return ( Max - Min ) * 0.5f;
+	}
+
+	void BoundingBox::GetCorners( Vector3* pCorners ) const
+	{
+		Assert( pCorners != NULL );
+
+		for( s32 i = 0; i < 8; ++i )
+		{
+			pCorners[ i ].Set(
+				( i & 1 ) ? Max.X : Min.X,
+				( i & 2 ) ? Max.Y : Min.Y,
+				( i & 4 ) ? Max.Z : Min.Z );
+		}
+	}
+
+	bool BoundingBox::Contains( const Vector3& point ) const
+	{
+		return ( point.X >= Min.X && point.X <= Max.X )
+			&& ( point.Y >= Min.Y && point.Y <= Max.Y )
+			&& ( point.Z >= Min.Z && point.Z <= Max.Z );
+	}
+
+	bool BoundingBox::Intersects( const BoundingBox& box ) const
+	{
+		return ( Min.X <= box.Max.X && Max.X >= box.Min.X )
+			&& ( Min.Y <= box.Max.Y && Max.Y >= box.Min.Y )
+			&& ( Min.Z <= box.Max.Z && Max.Z >= box.Min.Z );
+	}
+
+	BoundingBox BoundingBox::Merge( const BoundingBox& box1, const BoundingBox& box2 )
+	{
+		return BoundingBox(
+			Vector3::Min( box1.Min, box2.Min ),
+			Vector3::Max( box1.Max, box2.Max ) );
+	}
+
+	BoundingBox BoundingBox::CreateFromPoints( const Vector3* pPoints, s32 count )
+	{
+		Assert( pPoints != NULL );
+		Assert( count > 0 );
+
+		BoundingBox box( pPoints[ 0 ], pPoints[ 0 ] );
+
+		for( s32 i = 1; i < count; ++i )
+		{
+			box.Min = Vector3::Min( box.Min, pPoints[ i ] );
+			box.Max = Vector3::Max( box.Max, pPoints[ i ] );
+		}
+
+		return box;
+	}
+
+	// Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems (1990)
+	BoundingBox BoundingBox::Transform( const Matrix4& m, const BoundingBox& box )
+	{
+		Vector3 min = m.GetTranslation();
+		Vector3 max = min;
+
+		for( s32 i = 0; i < 3; ++i )
+		{
+			for( s32 j = 0; j < 3; ++j )
+			{
+				f32 a = m.M[ j ][ i ] * box.Min[ j ];
+				f32 b = m.M[ j ][ i ] * box.Max[ j ];
+
+				min[ i ] += Math::Min( a, b );
+				max[ i ] += Math::Max( a, b );
+			}
+		}
+
+		return BoundingBox( min, max );
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+namespace Tomato
+{
+	// Axis-aligned bounding box.
+	class TOMATO_API BoundingBox
+	{
+	public:
+		BoundingBox();
+		BoundingBox( const Vector3& min, const Vector3& max );
+		~BoundingBox();
+
+		void Set( const Vector3& min, const Vector3& max );
+
+		Vector3 GetCenter() const;
+		Vector3 GetExtents() const;
+
+		// Bit 0, 1 and 2 of the corner index select Max over Min for X, Y and Z.
+		void GetCorners( Vector3* pCorners ) const;
+
+		bool Contains( const Vector3& point ) const;
+		bool Intersects( const BoundingBox& box ) const;
+
+		static BoundingBox Merge( const BoundingBox& box1, const BoundingBox& box2 );
+		static BoundingBox CreateFromPoints( const Vector3* pPoints, s32 count );
+		static BoundingBox Transform( const Matrix4& m, const BoundingBox& box );
+
+	public:
+		Vector3 Min;
+		Vector3 Max;
+	};
+}
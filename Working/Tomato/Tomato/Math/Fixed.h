@@ -0,0 +1,121 @@
+#pragma once
+
+namespace Tomato
+{
+	// Integer helpers behind Fixed. Every result is defined bit for bit by integer arithmetic,
+	// so it is the same with every compiler, CPU and floating point mode.
+	class TOMATO_API FixedMath
+	{
+	public:
+		// Sine and cosine of an angle in turns scaled to 2^32 per turn, in 2.30 fixed point.
+		static s32 Sin( u32 angle );
+		static s32 Cos( u32 angle );
+
+		// Largest integer whose square does not exceed the value.
+		static u32 Sqrt( u64 value );
+
+		// Square root of the 128 bit value ( high * 2^64 + low ).
+		static u64 Sqrt( u64 high, u64 low );
+
+		// ( a * b ) >> shift with a 128 bit intermediate, rounded towards negative infinity.
+		static s64 Multiply( s64 a, s64 b, s32 shift );
+
+		// ( a << shift ) / b with a 128 bit intermediate, rounded towards zero.
+		static s64 Divide( s64 a, s64 b, s32 shift );
+
+		// Batches of 16.16 values, four per SSE2 instruction, with the exact results of Fixed16.
+		static void Multiply( const s32* pA, const s32* pB, s32* pResults, s32 count );
+		static void MultiplyAdd( const s32* pA, const s32* pB, const s32* pC, s32* pResults, s32 count );
+	};
+
+	// 16.16 fixed point in 32 bits.
+	struct Fixed16Format
+	{
+		typedef s32 Storage;
+		enum { FractionBits = 16 };
+
+		static s32 Multiply( s32 a, s32 b ) { return static_cast<s32>( ( static_cast<s64>( a ) * b ) >> 16 ); }
+		static s32 Divide( s32 a, s32 b ) { return static_cast<s32>( ( static_cast<s64>( a ) << 16 ) / b ); }
+		static s32 Sqrt( s32 a ) { return ( a > 0 ) ? static_cast<s32>( FixedMath::Sqrt( static_cast<u64>( a ) << 16 ) ) : 0; }
+
+		// Angle in turns scaled to 2^32 per turn; 2^48 / ( 2 PI ) keeps the low 32 bits exact.
+		static u32 ToTurns( s32 radians ) { return static_cast<u32>( ( static_cast<u64>( static_cast<s64>( radians ) ) * 44798133900177ULL ) >> 32 ); }
+		static s32 FromSine( s32 sine ) { return sine >> 14; }
+	};
+
+	// 32.32 fixed point in 64 bits.
+	struct Fixed32Format
+	{
+		typedef s64 Storage;
+		enum { FractionBits = 32 };
+
+		static s64 Multiply( s64 a, s64 b ) { return FixedMath::Multiply( a, b, 32 ); }
+		static s64 Divide( s64 a, s64 b ) { return FixedMath::Divide( a, b, 32 ); }
+		static s64 Sqrt( s64 a ) { return ( a > 0 ) ? static_cast<s64>( FixedMath::Sqrt( static_cast<u64>( a ) >> 32, static_cast<u64>( a ) << 32 ) ) : 0; }
+
+		static u32 ToTurns( s64 radians ) { return static_cast<u32>( ( static_cast<u64>( radians ) * 683565276ULL ) >> 32 ); }
+		static s64 FromSine( s32 sine ) { return static_cast<s64>( sine ) << 2; }
+	};
+
+	// Deterministic fixed point scalar for lockstep simulation and replays.
+	//
+	// Format supplies the storage type and the rounding of multiplication, division and square
+	// root; see Fixed16Format and Fixed32Format. Overflow wraps around. Conversions from float
+	// are exact when the value is representable, but only integer arithmetic is used afterwards.
+	template<typename Format>
+	class Fixed
+	{
+	public:
+		typedef typename Format::Storage Storage;
+		enum { FractionBits = Format::FractionBits };
+
+		Fixed() : Raw( 0 ) {}
+
+		static Fixed FromRaw( Storage raw ) { Fixed result; result.Raw = raw; return result; }
+		static Fixed FromInt( s32 value ) { return FromRaw( static_cast<Storage>( value ) << FractionBits ); }
+		static Fixed FromFloat( f32 value ) { return FromRaw( static_cast<Storage>( static_cast<f64>( value ) * static_cast<f64>( One().Raw ) ) ); }
+
+		static Fixed Zero() { return FromRaw( 0 ); }
+		static Fixed One() { return FromRaw( static_cast<Storage>( 1 ) << FractionBits ); }
+
+		// Rounded towards negative infinity.
+		s32 ToInt() const { return static_cast<s32>( Raw >> FractionBits ); }
+		f32 ToFloat() const { return static_cast<f32>( static_cast<f64>( Raw ) / static_cast<f64>( One().Raw ) ); }
+
+		Fixed operator - () const { return FromRaw( -Raw ); }
+
+		Fixed operator + ( const Fixed& v ) const { return FromRaw( Raw + v.Raw ); }
+		Fixed operator - ( const Fixed& v ) const { return FromRaw( Raw - v.Raw ); }
+		Fixed operator * ( const Fixed& v ) const { return FromRaw( Format::Multiply( Raw, v.Raw ) ); }
+		Fixed operator / ( const Fixed& v ) const { return FromRaw( Format::Divide( Raw, v.Raw ) ); }
+
+		Fixed& operator += ( const Fixed& v ) { Raw += v.Raw; return *this; }
+		Fixed& operator -= ( const Fixed& v ) { Raw -= v.Raw; return *this; }
+		Fixed& operator *= ( const Fixed& v ) { Raw = Format::Multiply( Raw, v.Raw ); return *this; }
+		Fixed& operator /= ( const Fixed& v ) { Raw = Format::Divide( Raw, v.Raw ); return *this; }
+
+		bool operator == ( const Fixed& v ) const { return Raw == v.Raw; }
+		bool operator != ( const Fixed& v ) const { return Raw != v.Raw; }
+		bool operator < ( const Fixed& v ) const { return Raw < v.Raw; }
+		bool operator <= ( const Fixed& v ) const { return Raw <= v.Raw; }
+		bool operator > ( const Fixed& v ) const { return Raw > v.Raw; }
+		bool operator >= ( const Fixed& v ) const { return Raw >= v.Raw; }
+
+		static Fixed Abs( const Fixed& v ) { return ( v.Raw < 0 ) ? -v : v; }
+		static Fixed Min( const Fixed& a, const Fixed& b ) { return ( a.Raw < b.Raw ) ? a : b; }
+		static Fixed Max( const Fixed& a, const Fixed& b ) { return ( a.Raw > b.Raw ) ? a : b; }
+
+		// 0 for negative values.
+		static Fixed Sqrt( const Fixed& v ) { return FromRaw( Format::Sqrt( v.Raw ) ); }
+
+		// Angles in radians, through a quarter wave table with linear interpolation.
+		static Fixed Sin( const Fixed& radians ) { return FromRaw( Format::FromSine( FixedMath::Sin( Format::ToTurns( radians.Raw ) ) ) ); }
+		static Fixed Cos( const Fixed& radians ) { return FromRaw( Format::FromSine( FixedMath::Cos( Format::ToTurns( radians.Raw ) ) ) ); }
+
+	public:
+		Storage Raw;
+	};
+
+	typedef Fixed<Fixed16Format> Fixed16;
+	typedef Fixed<Fixed32Format> Fixed32;
+}
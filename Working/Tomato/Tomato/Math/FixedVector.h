@@ -0,0 +1,232 @@
+#pragma once
+
+namespace Tomato
+{
+	// Vector, quaternion and matrix algorithms of Vector2, Vector3, Quaternion and Matrix4 over
+	// a Fixed scalar, for deterministic simulation. Matrices use the same row-vector convention
+	// as Matrix4: points are transformed as p * M and translation lives in M[ 3 ].
+	template<typename Scalar>
+	class FixedVector2
+	{
+	public:
+		FixedVector2() {}
+		FixedVector2( const Scalar& x, const Scalar& y ) : X( x ), Y( y ) {}
+
+		FixedVector2 operator + ( const FixedVector2& v ) const { return FixedVector2( X + v.X, Y + v.Y ); }
+		FixedVector2 operator - ( const FixedVector2& v ) const { return FixedVector2( X - v.X, Y - v.Y ); }
+		FixedVector2 operator * ( const Scalar& s ) const { return FixedVector2( X * s, Y * s ); }
+		FixedVector2 operator - () const { return FixedVector2( -X, -Y ); }
+
+		bool operator == ( const FixedVector2& v ) const { return X == v.X && Y == v.Y; }
+		bool operator != ( const FixedVector2& v ) const { return !( *this == v ); }
+
+		Scalar GetLengthSquared() const { return Dot( *this, *this ); }
+		Scalar GetLength() const { return Scalar::Sqrt( GetLengthSquared() ); }
+
+		static Scalar Dot( const FixedVector2& v1, const FixedVector2& v2 ) { return v1.X * v2.X + v1.Y * v2.Y; }
+
+		// Zero vectors stay zero.
+		static FixedVector2 Normalize( const FixedVector2& v )
+		{
+			Scalar length = v.GetLength();
+			return ( length == Scalar::Zero() ) ? v : FixedVector2( v.X / length, v.Y / length );
+		}
+
+	public:
+		Scalar X;
+		Scalar Y;
+	};
+
+	template<typename Scalar>
+	class FixedVector3
+	{
+	public:
+		FixedVector3() {}
+		FixedVector3( const Scalar& x, const Scalar& y, const Scalar& z ) : X( x ), Y( y ), Z( z ) {}
+
+		FixedVector3 operator + ( const FixedVector3& v ) const { return FixedVector3( X + v.X, Y + v.Y, Z + v.Z ); }
+		FixedVector3 operator - ( const FixedVector3& v ) const { return FixedVector3( X - v.X, Y - v.Y, Z - v.Z ); }
+		FixedVector3 operator * ( const Scalar& s ) const { return FixedVector3( X * s, Y * s, Z * s ); }
+		FixedVector3 operator - () const { return FixedVector3( -X, -Y, -Z ); }
+
+		FixedVector3& operator += ( const FixedVector3& v ) { X += v.X; Y += v.Y; Z += v.Z; return *this; }
+		FixedVector3& operator -= ( const FixedVector3& v ) { X -= v.X; Y -= v.Y; Z -= v.Z; return *this; }
+
+		bool operator == ( const FixedVector3& v ) const { return X == v.X && Y == v.Y && Z == v.Z; }
+		bool operator != ( const FixedVector3& v ) const { return !( *this == v ); }
+
+		Scalar GetLengthSquared() const { return Dot( *this, *this ); }
+		Scalar GetLength() const { return Scalar::Sqrt( GetLengthSquared() ); }
+
+		static Scalar Dot( const FixedVector3& v1, const FixedVector3& v2 ) { return v1.X * v2.X + v1.Y * v2.Y + v1.Z * v2.Z; }
+
+		static FixedVector3 Cross( const FixedVector3& v1, const FixedVector3& v2 )
+		{
+			return FixedVector3(
+				v1.Y * v2.Z - v1.Z * v2.Y,
+				v1.Z * v2.X - v1.X * v2.Z,
+				v1.X * v2.Y - v1.Y * v2.X );
+		}
+
+		// Zero vectors stay zero.
+		static FixedVector3 Normalize( const FixedVector3& v )
+		{
+			Scalar length = v.GetLength();
+			return ( length == Scalar::Zero() ) ? v : FixedVector3( v.X / length, v.Y / length, v.Z / length );
+		}
+
+		static FixedVector3 Lerp( const FixedVector3& v1, const FixedVector3& v2, const Scalar& amount ) { return v1 + ( v2 - v1 ) * amount; }
+
+	public:
+		Scalar X;
+		Scalar Y;
+		Scalar Z;
+	};
+
+	template<typename Scalar>
+	class FixedQuaternion
+	{
+	public:
+		FixedQuaternion() {}
+		FixedQuaternion( const Scalar& x, const Scalar& y, const Scalar& z, const Scalar& w ) : X( x ), Y( y ), Z( z ), W( w ) {}
+
+		static FixedQuaternion Identity() { return FixedQuaternion( Scalar::Zero(), Scalar::Zero(), Scalar::Zero(), Scalar::One() ); }
+
+		// The axis must be unit length.
+		static FixedQuaternion CreateFromAxisAngle( const FixedVector3<Scalar>& axis, const Scalar& angle )
+		{
+			Scalar half = angle / Scalar::FromInt( 2 );
+			Scalar s = Scalar::Sin( half );
+			return FixedQuaternion( axis.X * s, axis.Y * s, axis.Z * s, Scalar::Cos( half ) );
+		}
+
+		// Hamilton product: applies q first, then this rotation.
+		FixedQuaternion operator * ( const FixedQuaternion& q ) const
+		{
+			return FixedQuaternion(
+				W * q.X + X * q.W + Y * q.Z - Z * q.Y,
+				W * q.Y + Y * q.W + Z * q.X - X * q.Z,
+				W * q.Z + Z * q.W + X * q.Y - Y * q.X,
+				W * q.W - X * q.X - Y * q.Y - Z * q.Z );
+		}
+
+		bool operator == ( const FixedQuaternion& q ) const { return X == q.X && Y == q.Y && Z == q.Z && W == q.W; }
+		bool operator != ( const FixedQuaternion& q ) const { return !( *this == q ); }
+
+		static FixedQuaternion Conjugate( const FixedQuaternion& q ) { return FixedQuaternion( -q.X, -q.Y, -q.Z, q.W ); }
+
+		static FixedQuaternion Normalize( const FixedQuaternion& q )
+		{
+			Scalar length = Scalar::Sqrt( q.X * q.X + q.Y * q.Y + q.Z * q.Z + q.W * q.W );
+			return ( length == Scalar::Zero() ) ? q : FixedQuaternion( q.X / length, q.Y / length, q.Z / length, q.W / length );
+		}
+
+		// v * CreateFromQuaternion( q ) for a unit quaternion ( u, w ): v + 2 w ( u x v ) + 2 u x ( u x v ).
+		FixedVector3<Scalar> Rotate( const FixedVector3<Scalar>& v ) const
+		{
+			FixedVector3<Scalar> u( X, Y, Z );
+			FixedVector3<Scalar> t = FixedVector3<Scalar>::Cross( u, v ) * Scalar::FromInt( 2 );
+			return v + t * W + FixedVector3<Scalar>::Cross( u, t );
+		}
+
+	public:
+		Scalar X;
+		Scalar Y;
+		Scalar Z;
+		Scalar W;
+	};
+
+	template<typename Scalar>
+	class FixedMatrix4
+	{
+	public:
+		FixedMatrix4() {}
+
+		static FixedMatrix4 CreateIdentity()
+		{
+			FixedMatrix4 m;
+			for( s32 i = 0; i < 4; ++i )
+			{
+				for( s32 j = 0; j < 4; ++j )
+				{
+					m.M[ i ][ j ] = ( i == j ) ? Scalar::One() : Scalar::Zero();
+				}
+			}
+
+			return m;
+		}
+
+		static FixedMatrix4 CreateTranslation( const FixedVector3<Scalar>& v )
+		{
+			FixedMatrix4 m = CreateIdentity();
+			m.M[ 3 ][ 0 ] = v.X;
+			m.M[ 3 ][ 1 ] = v.Y;
+			m.M[ 3 ][ 2 ] = v.Z;
+			return m;
+		}
+
+		// Same matrix as Matrix4::SetFromQuaternion for a unit quaternion.
+		static FixedMatrix4 CreateFromQuaternion( const FixedQuaternion<Scalar>& q )
+		{
+			Scalar one = Scalar::One();
+			Scalar two = Scalar::FromInt( 2 );
+
+			FixedMatrix4 m = CreateIdentity();
+			m.M[ 0 ][ 0 ] = one - two * ( q.Y * q.Y + q.Z * q.Z );
+			m.M[ 0 ][ 1 ] = two * ( q.X * q.Y + q.Z * q.W );
+			m.M[ 0 ][ 2 ] = two * ( q.X * q.Z - q.Y * q.W );
+			m.M[ 1 ][ 0 ] = two * ( q.X * q.Y - q.Z * q.W );
+			m.M[ 1 ][ 1 ] = one - two * ( q.X * q.X + q.Z * q.Z );
+			m.M[ 1 ][ 2 ] = two * ( q.Y * q.Z + q.X * q.W );
+			m.M[ 2 ][ 0 ] = two * ( q.X * q.Z + q.Y * q.W );
+			m.M[ 2 ][ 1 ] = two * ( q.Y * q.Z - q.X * q.W );
+			m.M[ 2 ][ 2 ] = one - two * ( q.X * q.X + q.Y * q.Y );
+			return m;
+		}
+
+		FixedMatrix4 operator * ( const FixedMatrix4& m ) const
+		{
+			FixedMatrix4 result;
+			for( s32 i = 0; i < 4; ++i )
+			{
+				for( s32 j = 0; j < 4; ++j )
+				{
+					result.M[ i ][ j ] = M[ i ][ 0 ] * m.M[ 0 ][ j ] + M[ i ][ 1 ] * m.M[ 1 ][ j ] + M[ i ][ 2 ] * m.M[ 2 ][ j ] + M[ i ][ 3 ] * m.M[ 3 ][ j ];
+				}
+			}
+
+			return result;
+		}
+
+		// p * M for a point with w = 1, ignoring the projective column.
+		FixedVector3<Scalar> TransformPoint( const FixedVector3<Scalar>& p ) const
+		{
+			return FixedVector3<Scalar>(
+				p.X * M[ 0 ][ 0 ] + p.Y * M[ 1 ][ 0 ] + p.Z * M[ 2 ][ 0 ] + M[ 3 ][ 0 ],
+				p.X * M[ 0 ][ 1 ] + p.Y * M[ 1 ][ 1 ] + p.Z * M[ 2 ][ 1 ] + M[ 3 ][ 1 ],
+				p.X * M[ 0 ][ 2 ] + p.Y * M[ 1 ][ 2 ] + p.Z * M[ 2 ][ 2 ] + M[ 3 ][ 2 ] );
+		}
+
+		// v * M for a direction with w = 0.
+		FixedVector3<Scalar> TransformVector( const FixedVector3<Scalar>& v ) const
+		{
+			return FixedVector3<Scalar>(
+				v.X * M[ 0 ][ 0 ] + v.Y * M[ 1 ][ 0 ] + v.Z * M[ 2 ][ 0 ],
+				v.X * M[ 0 ][ 1 ] + v.Y * M[ 1 ][ 1 ] + v.Z * M[ 2 ][ 1 ],
+				v.X * M[ 0 ][ 2 ] + v.Y * M[ 1 ][ 2 ] + v.Z * M[ 2 ][ 2 ] );
+		}
+
+	public:
+		Scalar M[ 4 ][ 4 ];
+	};
+
+	typedef FixedVector2<Fixed16> FixedVector2_16;
+	typedef FixedVector3<Fixed16> FixedVector3_16;
+	typedef FixedQuaternion<Fixed16> FixedQuaternion16;
+	typedef FixedMatrix4<Fixed16> FixedMatrix4_16;
+
+	typedef FixedVector2<Fixed32> FixedVector2_32;
+	typedef FixedVector3<Fixed32> FixedVector3_32;
+	typedef FixedQuaternion<Fixed32> FixedQuaternion32;
+	typedef FixedMatrix4<Fixed32> FixedMatrix4_32;
+}
@@ -0,0 +1,97 @@
+#include "TomatoPCH.h"
+
+#include "Frustum.h"
+
+#include <cmath>
+
+namespace Tomato
+{
+	namespace
+	{
+		Vector4 NormalizePlane( f32 x, f32 y, f32 z, f32 w )
+		{
+			f32 length = sqrtf( x * x + y * y + z * z );
+			f32 invLength = ( length != 0 ) ? 1 / length : 0;
+
+			return Vector4( x * invLength, y * invLength, z * invLength, w * invLength );
+		}
+	}
+
+	Frustum::Frustum()
+	{
+	}
+
+	Frustum::Frustum( const Matrix4& viewProjection )
+	{
+		Set( viewProjection );
+	}
+
+	Frustum::~Frustum()
+	{
+	}
+
+	// Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix" (2001)
+	void Frustum::Set( const Matrix4& viewProjection )
+	{
+		const f32 (*m)[4] = viewProjection.M;
+
+		m_planes[ Side::Left ] = NormalizePlane( m[0][3] + m[0][0], m[1][3] + m[1][0], m[2][3] + m[2][0], m[3][3] + m[3][0] );
+		m_planes[ Side::Right ] = NormalizePlane( m[0][3] - m[0][0], m[1][3] - m[1][0], m[2][3] - m[2][0], m[3][3] - m[3][0] );
+		m_planes[ Side::Bottom ] = NormalizePlane( m[0][3] + m[0][1], m[1][3] + m[1][1], m[2][3] + m[2][1], m[3][3] + m[3][1] );
+		m_planes[ Side::Top ] = NormalizePlane( m[0][3] - m[0][1], m[1][3] - m[1][1], m[2][3] - m[2][1], m[3][3] - m[3][1] );
+		m_planes[ Side::Near ] = NormalizePlane( m[0][2], m[1][2], m[2][2], m[3][2] );
+		m_planes[ Side::Far ] = NormalizePlane( m[0][3] - m[0][2], m[1][3] - m[1][2], m[2][3] - m[2][2], m[3][3] - m[3][2] );
+	}
+
+	bool Frustum::Contains( const Vector3& point ) const
+	{
+		for( s32 i = 0; i < Side::Count; ++i )
+		{
+			const Vector4& plane = m_planes[ i ];
+
+			if( plane.X * point.X + plane.Y * point.Y + plane.Z * point.Z + plane.W < 0 )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Conservative: boxes near a frustum corner may be reported as intersecting.
+	bool Frustum::Intersects( const BoundingBox& box ) const
+	{
+		Vector3 center = box.GetCenter();
+		Vector3 extents = box.GetExtents();
+
+		for( s32 i = 0; i < Side::Count; ++i )
+		{
+			const Vector4& plane = m_planes[ i ];
+
+			f32 distance = plane.X * center.X + plane.Y * center.Y + plane.Z * center.Z + plane.W;
+			f32 radius = Math::Abs( plane.X ) * extents.X + Math::Abs( plane.Y ) * extents.Y + Math::Abs( plane.Z ) * extents.Z;
+
+			if( distance + radius < 0 )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool Frustum::Intersects( const Vector3& center, f32 radius ) const
+	{
+		for( s32 i = 0; i < Side::Count; ++i )
+		{
+			const Vector4& plane = m_planes[ i ];
+
+			if( plane.X * center.X + plane.Y * center.Y + plane.Z * center.Z + plane.W < -radius )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
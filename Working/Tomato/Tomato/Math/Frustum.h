@@ -0,0 +1,41 @@
+#pragma once
+
+namespace Tomato
+{
+	// View frustum as six inward facing planes ( normal, distance ) in a Vector4 each.
+	// A point p is inside a plane when Dot( normal, p ) + distance >= 0.
+	class TOMATO_API Frustum
+	{
+	public:
+		struct Side
+		{
+			enum Type
+			{
+				Left,
+				Right,
+				Bottom,
+				Top,
+				Near,
+				Far,
+
+				Count
+			};
+		};
+
+		Frustum();
+		explicit Frustum( const Matrix4& viewProjection );
+		~Frustum();
+
+		// Extracts the planes of a row-vector view-projection matrix with D3D clip depth ( 0 <= z <= w ).
+		void Set( const Matrix4& viewProjection );
+
+		const Vector4& GetPlane( Side::Type side ) const { return m_planes[ side ]; }
+
+		bool Contains( const Vector3& point ) const;
+		bool Intersects( const BoundingBox& box ) const;
+		bool Intersects( const Vector3& center, f32 radius ) const;
+
+	private:
+		Vector4 m_planes[ Side::Count ];
+	};
+}
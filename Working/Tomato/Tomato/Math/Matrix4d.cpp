@@ -0,0 +1,262 @@
+#include "TomatoPCH.h"
+
+#include "Matrix4d.h"
+
+#include <emmintrin.h>
+
+namespace Tomato
+{
+	namespace
+	{
+		// Rows 1-3 are narrowed as they are; row 4 has origin subtracted in f64 first.
+		void ConvertCameraRelative( const Matrix4d& m, __m128d origin01, __m128d origin23, Matrix4& result )
+		{
+			const f64* pSource = m.E;
+			f32* pTarget = result.E;
+
+			for( s32 row = 0; row < 3; ++row )
+			{
+				__m128 low = _mm_cvtpd_ps( _mm_loadu_pd( pSource + row * 4 ) );
+				__m128 high = _mm_cvtpd_ps( _mm_loadu_pd( pSource + row * 4 + 2 ) );
+
+				_mm_storeu_ps( pTarget + row * 4, _mm_movelh_ps( low, high ) );
+			}
+
+			__m128 low = _mm_cvtpd_ps( _mm_sub_pd( _mm_loadu_pd( pSource + 12 ), origin01 ) );
+			__m128 high = _mm_cvtpd_ps( _mm_sub_pd( _mm_loadu_pd( pSource + 14 ), origin23 ) );
+
+			_mm_storeu_ps( pTarget + 12, _mm_movelh_ps( low, high ) );
+		}
+	}
+
+	Matrix4d::Matrix4d()
+	{
+		Set( 0, 0, 0, 0,
+			0, 0, 0, 0,
+			0, 0, 0, 0,
+			0, 0, 0, 0 );
+	}
+
+	Matrix4d::Matrix4d( const Matrix4& m )
+	{
+		for( s32 i = 0; i < 16; ++i )
+		{
+			E[ i ] = m.E[ i ];
+		}
+	}
+
+	Matrix4d::Matrix4d(
+		f64 m00, f64 m01, f64 m02, f64 m03,
+		f64 m10, f64 m11, f64 m12, f64 m13,
+		f64 m20, f64 m21, f64 m22, f64 m23,
+		f64 m30, f64 m31, f64 m32, f64 m33 )
+	{
+		Set( m00, m01, m02, m03,
+			m10, m11, m12, m13,
+			m20, m21, m22, m23,
+			m30, m31, m32, m33 );
+	}
+
+	Matrix4d::~Matrix4d()
+	{
+	}
+
+	void Matrix4d::Set( 
+		f64 m00, f64 m01, f64 m02, f64 m03,
+		f64 m10, f64 m11, f64 m12, f64 m13,
+		f64 m20, f64 m21, f64 m22, f64 m23,
+		f64 m30, f64 m31, f64 m32, f64 m33 )
+	{
+		M[0][0] = m00;  M[0][1] = m01;  M[0][2] = m02;  M[0][3] = m03;
+		M[1][0] = m10;  M[1][1] = m11;  M[1][2] = m12;  M[1][3] = m13;
+		M[2][0] = m20;  M[2][1] = m21;  M[2][2] = m22;  M[2][3] = m23;
+		M[3][0] = m30;  M[3][1] = m31;  M[3][2] = m32;  M[3][3] = m33;
+	}
+
+	void Matrix4d::Set( const Matrix4d& m )
+	{
+		for( s32 i = 0; i < 16; ++i )
+		{
+			E[ i ] = m.E[ i ];
+		}
+	}
+
+	void Matrix4d::SetIdentity()
+	{
+		Set( 1, 0, 0, 0,
+			0, 1, 0, 0,
+			0, 0, 1, 0,
+			0, 0, 0, 1 );
+	}
+
+	Matrix4d Matrix4d::CreateIdentity()
+	{
+		return Matrix4d(
+			1, 0, 0, 0,
+			0, 1, 0, 0,
+			0, 0, 1, 0,
+			0, 0, 0, 1 );
+	}
+
+	void Matrix4d::SetTranslation( const Vector3d& v )
+	{
+		M[3][0] = v.X;
+		M[3][1] = v.Y;
+		M[3][2] = v.Z;
+	}
+
+	Matrix4d Matrix4d::CreateTranslation( const Vector3d& v )
+	{
+		return Matrix4d(
+			1, 0, 0, 0,
+			0, 1, 0, 0,
+			0, 0, 1, 0,
+			v.X, v.Y, v.Z, 1 );
+	}
+
+	Vector3d Matrix4d::GetTranslation() const
+	{
+		return Vector3d( M[3][0], M[3][1], M[3][2] );
+	}
+
+	Matrix4d Matrix4d::CreateWorld( const Vector3d& position, const Quaternion& rotation, const Vector3& scale )
+	{
+		Matrix4 r = Matrix4::CreateFromQuaternion( rotation );
+
+		return Matrix4d(
+			r.M[0][0] * scale.X, r.M[0][1] * scale.X, r.M[0][2] * scale.X, 0,
+			r.M[1][0] * scale.Y, r.M[1][1] * scale.Y, r.M[1][2] * scale.Y, 0,
+			r.M[2][0] * scale.Z, r.M[2][1] * scale.Z, r.M[2][2] * scale.Z, 0,
+			position.X, position.Y, position.Z, 1 );
+	}
+
+	void Matrix4d::SetLookAtLH( const Vector3d& cameraPosition, const Vector3d& cameraTarget, const Vector3d& cameraUpVector )
+	{
+		Vector3d zAxis = Vector3d::Normalize( cameraTarget - cameraPosition );
+		Vector3d xAxis = Vector3d::Normalize( Vector3d::Cross( cameraUpVector, zAxis ) );
+		Vector3d yAxis = Vector3d::Cross( zAxis, xAxis );
+
+		Set( 
+			xAxis.X, yAxis.X, zAxis.X, 0,
+			xAxis.Y, yAxis.Y, zAxis.Y, 0,
+			xAxis.Z, yAxis.Z, zAxis.Z, 0,
+			-Vector3d::Dot( xAxis, cameraPosition ), -Vector3d::Dot( yAxis, cameraPosition ), -Vector3d::Dot( zAxis, cameraPosition ), 1 );
+	}
+
+	Matrix4d Matrix4d::CreateLookAtLH( const Vector3d& cameraPosition, const Vector3d& cameraTarget, const Vector3d& cameraUpVector )
+	{
+		Matrix4d m;
+		m.SetLookAtLH( cameraPosition, cameraTarget, cameraUpVector );
+		return m;
+	}
+
+	Vector3d Matrix4d::Transform( const Matrix4d& m, const Vector3d& v )
+	{
+		return Vector3d(
+			( ( ( v.X * m.M[0][0] ) + ( v.Y * m.M[1][0] ) ) + ( v.Z * m.M[2][0] ) ) + m.M[3][0],
+			( ( ( v.X * m.M[0][1] ) + ( v.Y * m.M[1][1] ) ) + ( v.Z * m.M[2][1] ) ) + m.M[3][1],
+			( ( ( v.X * m.M[0][2] ) + ( v.Y * m.M[1][2] ) ) + ( v.Z * m.M[2][2] ) ) + m.M[3][2] );
+	}
+
+	Vector3d Matrix4d::TransformNormal( const Matrix4d& m, const Vector3d& v )
+	{
+		return Vector3d(
+			( ( v.X * m.M[0][0] ) + ( v.Y * m.M[1][0] ) ) + ( v.Z * m.M[2][0] ),
+			( ( v.X * m.M[0][1] ) + ( v.Y * m.M[1][1] ) ) + ( v.Z * m.M[2][1] ),
+			( ( v.X * m.M[0][2] ) + ( v.Y * m.M[1][2] ) ) + ( v.Z * m.M[2][2] ) );
+	}
+
+	Matrix4 Matrix4d::ToMatrix4() const
+	{
+		return ToCameraRelative( Vector3d::Zero() );
+	}
+
+	Matrix4 Matrix4d::ToCameraRelative( const Vector3d& origin ) const
+	{
+		Matrix4 result;
+		ConvertCameraRelative( *this, _mm_setr_pd( origin.X, origin.Y ), _mm_setr_pd( origin.Z, 0.0 ), result );
+		return result;
+	}
+
+	void Matrix4d::ToCameraRelative( const Matrix4d* pMatrices, s32 count, const Vector3d& origin, Matrix4* pResults )
+	{
+		Assert( count == 0 || pMatrices != NULL );
+		Assert( count == 0 || pResults != NULL );
+
+		__m128d origin01 = _mm_setr_pd( origin.X, origin.Y );
+		__m128d origin23 = _mm_setr_pd( origin.Z, 0.0 );
+
+		for( s32 i = 0; i < count; ++i )
+		{
+			ConvertCameraRelative( pMatrices[ i ], origin01, origin23, pResults[ i ] );
+		}
+	}
+
+	void Matrix4d::ToCameraRelative( const Matrix4d* pMatrices, const u32* pIndices, s32 count, const Vector3d& origin, Matrix4* pResults )
+	{
+		Assert( count == 0 || pMatrices != NULL );
+		Assert( count == 0 || pIndices != NULL );
+		Assert( count == 0 || pResults != NULL );
+
+		__m128d origin01 = _mm_setr_pd( origin.X, origin.Y );
+		__m128d origin23 = _mm_setr_pd( origin.Z, 0.0 );
+
+		for( s32 i = 0; i < count; ++i )
+		{
+			ConvertCameraRelative( pMatrices[ pIndices[ i ] ], origin01, origin23, pResults[ i ] );
+		}
+	}
+
+	Matrix4 Matrix4d::CreateCameraRelativeView( const Matrix4d& view )
+	{
+		Matrix4 result = view.ToMatrix4();
+		result.M[3][0] = 0.f;
+		result.M[3][1] = 0.f;
+		result.M[3][2] = 0.f;
+		return result;
+	}
+
+	const Matrix4d& Matrix4d::operator = ( const Matrix4d& m )
+	{
+		Set( m );
+		return *this;
+	}
+
+	Matrix4d Matrix4d::operator * ( const Matrix4d& m ) const
+	{
+		Matrix4d result;
+
+		for( s32 i = 0; i < 4; ++i )
+		{
+			for( s32 j = 0; j < 4; ++j )
+			{
+				result.M[i][j] = M[i][0] * m.M[0][j] + M[i][1] * m.M[1][j] + M[i][2] * m.M[2][j] + M[i][3] * m.M[3][j];
+			}
+		}
+
+		return result;
+	}
+
+	void Matrix4d::operator *= ( const Matrix4d& m )
+	{
+		Set( (*this) * m );
+	}
+
+	bool Matrix4d::operator == ( const Matrix4d& m ) const
+	{
+		for( s32 i = 0; i < 16; ++i )
+		{
+			if( E[ i ] != m.E[ i ] )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool Matrix4d::operator != ( const Matrix4d& m ) const
+	{
+		return !( (*this) == m );
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+namespace Tomato
+{
+	class Quaternion;
+
+	// Double precision Matrix4 for world transforms of large maps.
+	//
+	// Same row-vector, row-major convention as Matrix4. Rendering never consumes a Matrix4d
+	// directly: world and view are converted to f32 relative to the camera position, so the
+	// translation that reaches the GPU stays small and f32 keeps sub-millimetre precision.
+	//
+	//		Matrix4d view = Matrix4d::CreateLookAtLH( eye, target, up );
+	//		Matrix4 cameraView = Matrix4d::CreateCameraRelativeView( view );
+	//		Matrix4d::ToCameraRelative( pWorlds, count, eye, pRenderWorlds );
+	class TOMATO_API Matrix4d
+	{
+	public:
+		Matrix4d();
+		explicit Matrix4d( const Matrix4& m );
+		Matrix4d(
+			f64 m00, f64 m01, f64 m02, f64 m03,
+			f64 m10, f64 m11, f64 m12, f64 m13,
+			f64 m20, f64 m21, f64 m22, f64 m23,
+			f64 m30, f64 m31, f64 m32, f64 m33 );
+
+		~Matrix4d();
+
+	public:
+		// Set
+		void Set( 
+			f64 m00, f64 m01, f64 m02, f64 m03,
+			f64 m10, f64 m11, f64 m12, f64 m13,
+			f64 m20, f64 m21, f64 m22, f64 m23,
+			f64 m30, f64 m31, f64 m32, f64 m33 );
+		void Set( const Matrix4d& m );
+
+		// Identity
+		void SetIdentity();
+		static Matrix4d CreateIdentity();
+
+		// Translation
+		void SetTranslation( const Vector3d& v );
+		static Matrix4d CreateTranslation( const Vector3d& v );
+		Vector3d GetTranslation() const;
+
+		// Rotation, scale and translation in one go; the typical world transform of an object.
+		static Matrix4d CreateWorld( const Vector3d& position, const Quaternion& rotation, const Vector3& scale );
+
+		// LookAt
+		void SetLookAtLH( const Vector3d& cameraPosition, const Vector3d& cameraTarget, const Vector3d& cameraUpVector );
+		static Matrix4d CreateLookAtLH( const Vector3d& cameraPosition, const Vector3d& cameraTarget, const Vector3d& cameraUpVector );
+
+		// Transformation
+		static Vector3d Transform( const Matrix4d& m, const Vector3d& v );
+		static Vector3d TransformNormal( const Matrix4d& m, const Vector3d& v );
+
+		// Conversion
+		Matrix4 ToMatrix4() const;
+
+		// The matrix with origin moved to the world origin; translation is subtracted in f64 before narrowing.
+		Matrix4 ToCameraRelative( const Vector3d& origin ) const;
+
+		// ToCameraRelative for count matrices in one pass.
+		static void ToCameraRelative( const Matrix4d* pMatrices, s32 count, const Vector3d& origin, Matrix4* pResults );
+
+		// ToCameraRelative for the matrices pMatrices[ pIndices[ i ] ], e.g. the visible instances of a scene.
+		static void ToCameraRelative( const Matrix4d* pMatrices, const u32* pIndices, s32 count, const Vector3d& origin, Matrix4* pResults );
+
+		// A view matrix looking from the origin along the same axes as view.
+		// Pair with world matrices converted by ToCameraRelative against the camera position.
+		static Matrix4 CreateCameraRelativeView( const Matrix4d& view );
+
+		// Operators
+		const Matrix4d& operator = ( const Matrix4d& m );
+		Matrix4d operator * ( const Matrix4d& m ) const;
+		void operator *= ( const Matrix4d& m );
+		bool operator == ( const Matrix4d& m ) const;
+		bool operator != ( const Matrix4d& m ) const;
+
+	public:
+#pragma warning( disable:4201 )
+
+		union
+		{
+			f64 E[16];
+			f64 M[4][4];
+		};
+	};
+
+#pragma warning( default: 4201 )
+
+}
@@ -0,0 +1,165 @@
+#include "TomatoPCH.h"
+
+#include "MatrixLayout.h"
+
+#include <xmmintrin.h>
+
+namespace Tomato
+{
+	namespace
+	{
+		// Rows of ( m1 * m2 ): each is a row of m1 times the rows of m2.
+		inline void MultiplyRows( const Matrix4& m1, const Matrix4& m2, __m128* pRows )
+		{
+			__m128 row1 = _mm_loadu_ps( m2.E + 0 );
+			__m128 row2 = _mm_loadu_ps( m2.E + 4 );
+			__m128 row3 = _mm_loadu_ps( m2.E + 8 );
+			__m128 row4 = _mm_loadu_ps( m2.E + 12 );
+
+			for( s32 i = 0; i < 4; ++i )
+			{
+				const f32* pRow = m1.M[ i ];
+
+				__m128 result = _mm_mul_ps( _mm_set1_ps( pRow[ 0 ] ), row1 );
+				result = _mm_add_ps( result, _mm_mul_ps( _mm_set1_ps( pRow[ 1 ] ), row2 ) );
+				result = _mm_add_ps( result, _mm_mul_ps( _mm_set1_ps( pRow[ 2 ] ), row3 ) );
+				result = _mm_add_ps( result, _mm_mul_ps( _mm_set1_ps( pRow[ 3 ] ), row4 ) );
+
+				pRows[ i ] = result;
+			}
+		}
+
+		inline void TransposeOne( const f32* pSource, f32* pTarget )
+		{
+			__m128 row1 = _mm_loadu_ps( pSource + 0 );
+			__m128 row2 = _mm_loadu_ps( pSource + 4 );
+			__m128 row3 = _mm_loadu_ps( pSource + 8 );
+			__m128 row4 = _mm_loadu_ps( pSource + 12 );
+
+			_MM_TRANSPOSE4_PS( row1, row2, row3, row4 );
+
+			_mm_storeu_ps( pTarget + 0, row1 );
+			_mm_storeu_ps( pTarget + 4, row2 );
+			_mm_storeu_ps( pTarget + 8, row3 );
+			_mm_storeu_ps( pTarget + 12, row4 );
+		}
+	}
+
+	void MatrixRowMajor::StoreProduct( const Matrix4& m1, const Matrix4& m2, f32* pTarget )
+	{
+		__m128 rows[ 4 ];
+		MultiplyRows( m1, m2, rows );
+
+		_mm_storeu_ps( pTarget + 0, rows[ 0 ] );
+		_mm_storeu_ps( pTarget + 4, rows[ 1 ] );
+		_mm_storeu_ps( pTarget + 8, rows[ 2 ] );
+		_mm_storeu_ps( pTarget + 12, rows[ 3 ] );
+	}
+
+	void MatrixColumnMajor::Store( const Matrix4& m, f32* pTarget )
+	{
+		TransposeOne( m.E, pTarget );
+	}
+
+	void MatrixColumnMajor::Load( const f32* pSource, Matrix4& m )
+	{
+		TransposeOne( pSource, m.E );
+	}
+
+	void MatrixColumnMajor::StoreProduct( const Matrix4& m1, const Matrix4& m2, f32* pTarget )
+	{
+		__m128 rows[ 4 ];
+		MultiplyRows( m1, m2, rows );
+
+		_MM_TRANSPOSE4_PS( rows[ 0 ], rows[ 1 ], rows[ 2 ], rows[ 3 ] );
+
+		_mm_storeu_ps( pTarget + 0, rows[ 0 ] );
+		_mm_storeu_ps( pTarget + 4, rows[ 1 ] );
+		_mm_storeu_ps( pTarget + 8, rows[ 2 ] );
+		_mm_storeu_ps( pTarget + 12, rows[ 3 ] );
+	}
+
+	void MatrixLayout::Transpose( const f32* pSource, f32* pTarget, s32 count )
+	{
+		Assert( count >= 0 );
+		Assert( count == 0 || ( pSource != NULL && pTarget != NULL ) );
+
+		for( s32 i = 0; i < count; ++i )
+		{
+			TransposeOne( pSource + i * 16, pTarget + i * 16 );
+		}
+	}
+
+	void MatrixLayout::Transpose( const Matrix4* pSource, f32* pTarget, s32 count )
+	{
+		Assert( count >= 0 );
+		Assert( count == 0 || ( pSource != NULL && pTarget != NULL ) );
+
+		for( s32 i = 0; i < count; ++i )
+		{
+			TransposeOne( pSource[ i ].E, pTarget + i * 16 );
+		}
+	}
+
+	void MatrixLayout::TransposeAffine( const Matrix4* pSource, f32* pTarget, s32 count )
+	{
+		Assert( count >= 0 );
+		Assert( count == 0 || ( pSource != NULL && pTarget != NULL ) );
+
+		for( s32 i = 0; i < count; ++i )
+		{
+			const f32* pMatrix = pSource[ i ].E;
+
+			__m128 row1 = _mm_loadu_ps( pMatrix + 0 );
+			__m128 row2 = _mm_loadu_ps( pMatrix + 4 );
+			__m128 row3 = _mm_loadu_ps( pMatrix + 8 );
+			__m128 row4 = _mm_loadu_ps( pMatrix + 12 );
+
+			_MM_TRANSPOSE4_PS( row1, row2, row3, row4 );
+
+			f32* pOut = pTarget + i * 12;
+			_mm_storeu_ps( pOut + 0, row1 );
+			_mm_storeu_ps( pOut + 4, row2 );
+			_mm_storeu_ps( pOut + 8, row3 );
+		}
+	}
+
+	// S * m * S with S = diag( 1, 1, -1, 1 ): row 2 and column 2 change sign, M[ 2 ][ 2 ] twice.
+	Matrix4 MatrixLayout::FlipHandedness( const Matrix4& m )
+	{
+		Matrix4 result( m );
+
+		for( s32 i = 0; i < 4; ++i )
+		{
+			result.M[ 2 ][ i ] = -result.M[ 2 ][ i ];
+			result.M[ i ][ 2 ] = -result.M[ i ][ 2 ];
+		}
+
+		return result;
+	}
+
+	void MatrixLayout::FlipHandedness( const Matrix4* pSource, Matrix4* pTarget, s32 count )
+	{
+		Assert( count >= 0 );
+		Assert( count == 0 || ( pSource != NULL && pTarget != NULL ) );
+
+		const __m128 signRow = _mm_set1_ps( -0.0f );
+		const __m128 signColumn = _mm_setr_ps( 0.0f, 0.0f, -0.0f, 0.0f );
+
+		for( s32 i = 0; i < count; ++i )
+		{
+			const f32* pMatrix = pSource[ i ].E;
+			f32* pOut = pTarget[ i ].E;
+
+			__m128 row1 = _mm_xor_ps( _mm_loadu_ps( pMatrix + 0 ), signColumn );
+			__m128 row2 = _mm_xor_ps( _mm_loadu_ps( pMatrix + 4 ), signColumn );
+			__m128 row3 = _mm_xor_ps( _mm_loadu_ps( pMatrix + 8 ), _mm_xor_ps( signRow, signColumn ) );
+			__m128 row4 = _mm_xor_ps( _mm_loadu_ps( pMatrix + 12 ), signColumn );
+
+			_mm_storeu_ps( pOut + 0, row1 );
+			_mm_storeu_ps( pOut + 4, row2 );
+			_mm_storeu_ps( pOut + 8, row3 );
+			_mm_storeu_ps( pOut + 12, row4 );
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+namespace Tomato
+{
+	// Storage layouts for handing a Matrix4 to shaders and other APIs.
+	//
+	// Matrix4 transforms row vectors ( p * M ) and is stored row by row, with the translation
+	// in M[ 3 ]. MatrixRowMajor keeps those 16 floats as they are, which is also what column
+	// major GLSL expects for the column vector matrix ( M * p ). MatrixColumnMajor stores the
+	// transpose, which default HLSL packing expects for mul( p, M ) and which register based
+	// shaders expect for dp4 with the matrix columns.
+	struct TOMATO_API MatrixRowMajor
+	{
+		static void Store( const Matrix4& m, f32* pTarget ) { ::CopyMemory( pTarget, m.E, sizeof( m.E ) ); }
+		static void Load( const f32* pSource, Matrix4& m ) { ::CopyMemory( m.E, pSource, sizeof( m.E ) ); }
+
+		// Stores ( m1 * m2 ) without a Matrix4 temporary.
+		static void StoreProduct( const Matrix4& m1, const Matrix4& m2, f32* pTarget );
+
+		static f32 Get( const f32* pData, s32 row, s32 column ) { return pData[ row * 4 + column ]; }
+	};
+
+	struct TOMATO_API MatrixColumnMajor
+	{
+		static void Store( const Matrix4& m, f32* pTarget );
+		static void Load( const f32* pSource, Matrix4& m );
+
+		// Stores ( m1 * m2 ) without a Matrix4 temporary.
+		static void StoreProduct( const Matrix4& m1, const Matrix4& m2, f32* pTarget );
+
+		static f32 Get( const f32* pData, s32 row, s32 column ) { return pData[ column * 4 + row ]; }
+	};
+
+	// Matrix4 kept in the layout of its consumer, so uploading it is a plain copy of E.
+	// Row and column indices of Get always refer to the Matrix4 being represented.
+	template<typename Layout>
+	class LayoutMatrix4
+	{
+	public:
+		LayoutMatrix4() { ::ZeroMemory( E, sizeof( E ) ); }
+		explicit LayoutMatrix4( const Matrix4& m ) { Layout::Store( m, E ); }
+
+		LayoutMatrix4& operator = ( const Matrix4& m ) { Layout::Store( m, E ); return *this; }
+
+		void Set( const Matrix4& m ) { Layout::Store( m, E ); }
+		void SetProduct( const Matrix4& m1, const Matrix4& m2 ) { Layout::StoreProduct( m1, m2, E ); }
+
+		Matrix4 ToMatrix4() const { Matrix4 m; Layout::Load( E, m ); return m; }
+
+		f32 Get( s32 row, s32 column ) const { return Layout::Get( E, row, column ); }
+
+		const f32* GetData() const { return E; }
+
+	public:
+		f32 E[ 16 ];
+	};
+
+	typedef LayoutMatrix4<MatrixRowMajor> RowMajorMatrix4;
+	typedef LayoutMatrix4<MatrixColumnMajor> ColumnMajorMatrix4;
+
+	// Batched conversions for data that is already laid out in memory.
+	class TOMATO_API MatrixLayout
+	{
+	public:
+		// Converts 4x4 matrices between MatrixRowMajor and MatrixColumnMajor in either direction.
+		// The source and the target may be the same array.
+		static void Transpose( const f32* pSource, f32* pTarget, s32 count );
+		static void Transpose( const Matrix4* pSource, f32* pTarget, s32 count );
+
+		// Keeps the first three columns of each Matrix4 in MatrixColumnMajor order, 12 floats
+		// per matrix, for affine transforms uploaded as float3x4.
+		static void TransposeAffine( const Matrix4* pSource, f32* pTarget, s32 count );
+
+		// Mirrors Z on both sides of a transform, converting it between left-handed and
+		// right-handed coordinates. Projections have separate LH and RH creators on Matrix4.
+		static Matrix4 FlipHandedness( const Matrix4& m );
+		static void FlipHandedness( const Matrix4* pSource, Matrix4* pTarget, s32 count );
+	};
+}
@@ -0,0 +1,753 @@
+#include "TomatoPCH.h"
+
+#include "Noise.h"
+
+#include <emmintrin.h>
+
+namespace Tomato
+{
+	namespace
+	{
+		// SSE2 has no 32 bit multiply; combine two 64 bit products.
+		__m128i Multiply( __m128i a, __m128i b )
+		{
+			__m128i even = _mm_mul_epu32( a, b );
+			__m128i odd = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+
+			return _mm_unpacklo_epi32(
+				_mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ),
+				_mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+		}
+
+		__m128i Hash( __m128i x, __m128i y, __m128i z, __m128i w, __m128i seed )
+		{
+			__m128i h = seed;
+			h = _mm_xor_si128( h, Multiply( x, _mm_set1_epi32( 0x27d4eb2d ) ) );
+			h = _mm_xor_si128( h, Multiply( y, _mm_set1_epi32( 0x165667b1 ) ) );
+			h = _mm_xor_si128( h, Multiply( z, _mm_set1_epi32( static_cast<s32>( 0x9e3779b1 ) ) ) );
+			h = _mm_xor_si128( h, Multiply( w, _mm_set1_epi32( static_cast<s32>( 0x85ebca77 ) ) ) );
+
+			h = Multiply( _mm_xor_si128( h, _mm_srli_epi32( h, 15 ) ), _mm_set1_epi32( 0x2c1b3c6d ) );
+			h = Multiply( _mm_xor_si128( h, _mm_srli_epi32( h, 12 ) ), _mm_set1_epi32( 0x297a2d39 ) );
+
+			return _mm_xor_si128( h, _mm_srli_epi32( h, 15 ) );
+		}
+
+		__m128i Floor( __m128 x, __m128& floor )
+		{
+			__m128i truncated = _mm_cvttps_epi32( x );
+			__m128 truncatedValue = _mm_cvtepi32_ps( truncated );
+
+			// Truncation rounds negative values up; step back by one where it did.
+			__m128i result = _mm_add_epi32( truncated, _mm_castps_si128( _mm_cmplt_ps( x, truncatedValue ) ) );
+			floor = _mm_cvtepi32_ps( result );
+			return result;
+		}
+
+		__m128 Select( __m128 mask, __m128 a, __m128 b )
+		{
+			return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+		}
+
+		__m128 Lerp( __m128 a, __m128 b, __m128 t )
+		{
+			return _mm_add_ps( a, _mm_mul_ps( _mm_sub_ps( b, a ), t ) );
+		}
+
+		// 6t^5 - 15t^4 + 10t^3
+		__m128 Fade( __m128 t )
+		{
+			__m128 inner = _mm_add_ps( _mm_mul_ps( t, _mm_sub_ps( _mm_mul_ps( t, _mm_set1_ps( 6.0f ) ), _mm_set1_ps( 15.0f ) ) ), _mm_set1_ps( 10.0f ) );
+			return _mm_mul_ps( _mm_mul_ps( _mm_mul_ps( t, t ), t ), inner );
+		}
+
+		// Flips the sign of v where the given bit of h is set.
+		__m128 FlipSign( __m128i h, s32 bit, __m128 v )
+		{
+			__m128i sign = _mm_slli_epi32( _mm_and_si128( h, _mm_set1_epi32( 1 << bit ) ), 31 - bit );
+			return _mm_xor_ps( v, _mm_castsi128_ps( sign ) );
+		}
+
+		// Uniform in [ -1, 1 ).
+		__m128 HashToValue( __m128i h )
+		{
+			return _mm_sub_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_srli_epi32( h, 8 ) ), _mm_set1_ps( 1.0f / 8388608.0f ) ), _mm_set1_ps( 1.0f ) );
+		}
+
+		// Dot product with one of the 12 cube edge gradients (Perlin, "Improving Noise", 2002).
+		__m128 Gradient3( __m128i h, __m128 x, __m128 y, __m128 z )
+		{
+			__m128i low = _mm_and_si128( h, _mm_set1_epi32( 15 ) );
+
+			__m128 lessThan8 = _mm_castsi128_ps( _mm_cmplt_epi32( low, _mm_set1_epi32( 8 ) ) );
+			__m128 lessThan4 = _mm_castsi128_ps( _mm_cmplt_epi32( low, _mm_set1_epi32( 4 ) ) );
+			__m128 is12or14 = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_or_si128( low, _mm_set1_epi32( 2 ) ), _mm_set1_epi32( 14 ) ) );
+
+			__m128 u = Select( lessThan8, x, y );
+			__m128 v = Select( lessThan4, y, Select( is12or14, x, z ) );
+
+			return _mm_add_ps( FlipSign( h, 0, u ), FlipSign( h, 1, v ) );
+		}
+
+		// Dot product with one of the 32 gradients ( 0, +-1, +-1, +-1 ) and permutations.
+		__m128 Gradient4( __m128i h, __m128 x, __m128 y, __m128 z, __m128 w )
+		{
+			__m128i axis = _mm_and_si128( _mm_srli_epi32( h, 3 ), _mm_set1_epi32( 3 ) );
+
+			__m128 isAxis0 = _mm_castsi128_ps( _mm_cmpeq_epi32( axis, _mm_setzero_si128() ) );
+			__m128 isAxis3 = _mm_castsi128_ps( _mm_cmpeq_epi32( axis, _mm_set1_epi32( 3 ) ) );
+			__m128 belowAxis2 = _mm_castsi128_ps( _mm_cmplt_epi32( axis, _mm_set1_epi32( 2 ) ) );
+
+			__m128 a = Select( isAxis0, y, x );
+			__m128 b = Select( belowAxis2, z, y );
+			__m128 c = Select( isAxis3, z, w );
+
+			return _mm_add_ps( _mm_add_ps( FlipSign( h, 0, a ), FlipSign( h, 1, b ) ), FlipSign( h, 2, c ) );
+		}
+
+		__m128i Offset( __m128i v, s32 offset )
+		{
+			return _mm_add_epi32( v, _mm_set1_epi32( offset ) );
+		}
+
+		__m128 Value2( __m128 x, __m128 y, __m128i seed )
+		{
+			__m128 floorX, floorY;
+			__m128i ix = Floor( x, floorX );
+			__m128i iy = Floor( y, floorY );
+			__m128i zero = _mm_setzero_si128();
+
+			__m128 u = Fade( _mm_sub_ps( x, floorX ) );
+			__m128 v = Fade( _mm_sub_ps( y, floorY ) );
+
+			__m128 v00 = HashToValue( Hash( ix, iy, zero, zero, seed ) );
+			__m128 v10 = HashToValue( Hash( Offset( ix, 1 ), iy, zero, zero, seed ) );
+			__m128 v01 = HashToValue( Hash( ix, Offset( iy, 1 ), zero, zero, seed ) );
+			__m128 v11 = HashToValue( Hash( Offset( ix, 1 ), Offset( iy, 1 ), zero, zero, seed ) );
+
+			return Lerp( Lerp( v00, v10, u ), Lerp( v01, v11, u ), v );
+		}
+
+		__m128 Value3( __m128 x, __m128 y, __m128 z, __m128i seed )
+		{
+			__m128 floorX, floorY, floorZ;
+			__m128i ix = Floor( x, floorX );
+			__m128i iy = Floor( y, floorY );
+			__m128i iz = Floor( z, floorZ );
+			__m128i zero = _mm_setzero_si128();
+
+			__m128 u = Fade( _mm_sub_ps( x, floorX ) );
+			__m128 v = Fade( _mm_sub_ps( y, floorY ) );
+			__m128 t = Fade( _mm_sub_ps( z, floorZ ) );
+
+			__m128 layers[ 2 ];
+			for( s32 k = 0; k < 2; ++k )
+			{
+				__m128i cz = Offset( iz, k );
+
+				__m128 v00 = HashToValue( Hash( ix, iy, cz, zero, seed ) );
+				__m128 v10 = HashToValue( Hash( Offset( ix, 1 ), iy, cz, zero, seed ) );
+				__m128 v01 = HashToValue( Hash( ix, Offset( iy, 1 ), cz, zero, seed ) );
+				__m128 v11 = HashToValue( Hash( Offset( ix, 1 ), Offset( iy, 1 ), cz, zero, seed ) );
+
+				layers[ k ] = Lerp( Lerp( v00, v10, u ), Lerp( v01, v11, u ), v );
+			}
+
+			return Lerp( layers[ 0 ], layers[ 1 ], t );
+		}
+
+		__m128 Value4( __m128 x, __m128 y, __m128 z, __m128 w, __m128i seed )
+		{
+			__m128 floorX, floorY, floorZ, floorW;
+			__m128i ix = Floor( x, floorX );
+			__m128i iy = Floor( y, floorY );
+			__m128i iz = Floor( z, floorZ );
+			__m128i iw = Floor( w, floorW );
+
+			__m128 u = Fade( _mm_sub_ps( x, floorX ) );
+			__m128 v = Fade( _mm_sub_ps( y, floorY ) );
+			__m128 t = Fade( _mm_sub_ps( z, floorZ ) );
+			__m128 s = Fade( _mm_sub_ps( w, floorW ) );
+
+			__m128 volumes[ 2 ];
+			for( s32 l = 0; l < 2; ++l )
+			{
+				__m128i cw = Offset( iw, l );
+
+				__m128 layers[ 2 ];
+				for( s32 k = 0; k < 2; ++k )
+				{
+					__m128i cz = Offset( iz, k );
+
+					__m128 v00 = HashToValue( Hash( ix, iy, cz, cw, seed ) );
+					__m128 v10 = HashToValue( Hash( Offset( ix, 1 ), iy, cz, cw, seed ) );
+					__m128 v01 = HashToValue( Hash( ix, Offset( iy, 1 ), cz, cw, seed ) );
+					__m128 v11 = HashToValue( Hash( Offset( ix, 1 ), Offset( iy, 1 ), cz, cw, seed ) );
+
+					layers[ k ] = Lerp( Lerp( v00, v10, u ), Lerp( v01, v11, u ), v );
+				}
+
+				volumes[ l ] = Lerp( layers[ 0 ], layers[ 1 ], t );
+			}
+
+			return Lerp( volumes[ 0 ], volumes[ 1 ], s );
+		}
+
+		__m128 Perlin2( __m128 x, __m128 y, __m128i seed )
+		{
+			__m128 floorX, floorY;
+			__m128i ix = Floor( x, floorX );
+			__m128i iy = Floor( y, floorY );
+			__m128i zero = _mm_setzero_si128();
+			__m128 one = _mm_set1_ps( 1.0f );
+			__m128 z = _mm_setzero_ps();
+
+			__m128 fx = _mm_sub_ps( x, floorX );
+			__m128 fy = _mm_sub_ps( y, floorY );
+			__m128 u = Fade( fx );
+			__m128 v = Fade( fy );
+
+			__m128 g00 = Gradient3( Hash( ix, iy, zero, zero, seed ), fx, fy, z );
+			__m128 g10 = Gradient3( Hash( Offset( ix, 1 ), iy, zero, zero, seed ), _mm_sub_ps( fx, one ), fy, z );
+			__m128 g01 = Gradient3( Hash( ix, Offset( iy, 1 ), zero, zero, seed ), fx, _mm_sub_ps( fy, one ), z );
+			__m128 g11 = Gradient3( Hash( Offset( ix, 1 ), Offset( iy, 1 ), zero, zero, seed ), _mm_sub_ps( fx, one ), _mm_sub_ps( fy, one ), z );
+
+			return Lerp( Lerp( g00, g10, u ), Lerp( g01, g11, u ), v );
+		}
+
+		__m128 Perlin3( __m128 x, __m128 y, __m128 z, __m128i seed )
+		{
+			__m128 floorX, floorY, floorZ;
+			__m128i ix = Floor( x, floorX );
+			__m128i iy = Floor( y, floorY );
+			__m128i iz = Floor( z, floorZ );
+			__m128i zero = _mm_setzero_si128();
+			__m128 one = _mm_set1_ps( 1.0f );
+
+			__m128 fx = _mm_sub_ps( x, floorX );
+			__m128 fy = _mm_sub_ps( y, floorY );
+			__m128 fz = _mm_sub_ps( z, floorZ );
+			__m128 u = Fade( fx );
+			__m128 v = Fade( fy );
+			__m128 t = Fade( fz );
+
+			__m128 layers[ 2 ];
+			for( s32 k = 0; k < 2; ++k )
+			{
+				__m128i cz = Offset( iz, k );
+				__m128 dz = k ? _mm_sub_ps( fz, one ) : fz;
+
+				__m128 g00 = Gradient3( Hash( ix, iy, cz, zero, seed ), fx, fy, dz );
+				__m128 g10 = Gradient3( Hash( Offset( ix, 1 ), iy, cz, zero, seed ), _mm_sub_ps( fx, one ), fy, dz );
+				__m128 g01 = Gradient3( Hash( ix, Offset( iy, 1 ), cz, zero, seed ), fx, _mm_sub_ps( fy, one ), dz );
+				__m128 g11 = Gradient3( Hash( Offset( ix, 1 ), Offset( iy, 1 ), cz, zero, seed ), _mm_sub_ps( fx, one ), _mm_sub_ps( fy, one ), dz );
+
+				layers[ k ] = Lerp( Lerp( g00, g10, u ), Lerp( g01, g11, u ), v );
+			}
+
+			return Lerp( layers[ 0 ], layers[ 1 ], t );
+		}
+
+		__m128 Perlin4( __m128 x, __m128 y, __m128 z, __m128 w, __m128i seed )
+		{
+			__m128 floorX, floorY, floorZ, floorW;
+			__m128i ix = Floor( x, floorX );
+			__m128i iy = Floor( y, floorY );
+			__m128i iz = Floor( z, floorZ );
+			__m128i iw = Floor( w, floorW );
+			__m128 one = _mm_set1_ps( 1.0f );
+
+			__m128 fx = _mm_sub_ps( x, floorX );
+			__m128 fy = _mm_sub_ps( y, floorY );
+			__m128 fz = _mm_sub_ps( z, floorZ );
+			__m128 fw = _mm_sub_ps( w, floorW );
+			__m128 u = Fade( fx );
+			__m128 v = Fade( fy );
+			__m128 t = Fade( fz );
+			__m128 s = Fade( fw );
+
+			__m128 volumes[ 2 ];
+			for( s32 l = 0; l < 2; ++l )
+			{
+				__m128i cw = Offset( iw, l );
+				__m128 dw = l ? _mm_sub_ps( fw, one ) : fw;
+
+				__m128 layers[ 2 ];
+				for( s32 k = 0; k < 2; ++k )
+				{
+					__m128i cz = Offset( iz, k );
+					__m128 dz = k ? _mm_sub_ps( fz, one ) : fz;
+
+					__m128 g00 = Gradient4( Hash( ix, iy, cz, cw, seed ), fx, fy, dz, dw );
+					__m128 g10 = Gradient4( Hash( Offset( ix, 1 ), iy, cz, cw, seed ), _mm_sub_ps( fx, one ), fy, dz, dw );
+					__m128 g01 = Gradient4( Hash( ix, Offset( iy, 1 ), cz, cw, seed ), fx, _mm_sub_ps( fy, one ), dz, dw );
+					__m128 g11 = Gradient4( Hash( Offset( ix, 1 ), Offset( iy, 1 ), cz, cw, seed ), _mm_sub_ps( fx, one ), _mm_sub_ps( fy, one ), dz, dw );
+
+					layers[ k ] = Lerp( Lerp( g00, g10, u ), Lerp( g01, g11, u ), v );
+				}
+
+				volumes[ l ] = Lerp( layers[ 0 ], layers[ 1 ], t );
+			}
+
+			return Lerp( volumes[ 0 ], volumes[ 1 ], s );
+		}
+
+		// max( 0, falloff - r^2 )^4
+		__m128 SimplexWeight( __m128 falloff, __m128 x, __m128 y, __m128 z, __m128 w )
+		{
+			__m128 r2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_add_ps( _mm_mul_ps( z, z ), _mm_mul_ps( w, w ) ) );
+			__m128 t = _mm_max_ps( _mm_sub_ps( falloff, r2 ), _mm_setzero_ps() );
+			t = _mm_mul_ps( t, t );
+			return _mm_mul_ps( t, t );
+		}
+
+		// Mask lanes to 1.0f / 1 where set.
+		__m128 MaskToFloat( __m128 mask )
+		{
+			return _mm_and_ps( mask, _mm_set1_ps( 1.0f ) );
+		}
+
+		__m128i MaskToInt( __m128 mask )
+		{
+			return _mm_and_si128( _mm_castps_si128( mask ), _mm_set1_epi32( 1 ) );
+		}
+
+		// Gustavson, "Simplex noise demystified" (2005)
+		__m128 Simplex2( __m128 x, __m128 y, __m128i seed )
+		{
+			const f32 F2 = 0.366025403f;
+			const f32 G2 = 0.211324865f;
+
+			__m128 skew = _mm_mul_ps( _mm_add_ps( x, y ), _mm_set1_ps( F2 ) );
+
+			__m128 floorI, floorJ;
+			__m128i i = Floor( _mm_add_ps( x, skew ), floorI );
+			__m128i j = Floor( _mm_add_ps( y, skew ), floorJ );
+
+			__m128 unskew = _mm_mul_ps( _mm_add_ps( floorI, floorJ ), _mm_set1_ps( G2 ) );
+			__m128 x0 = _mm_sub_ps( x, _mm_sub_ps( floorI, unskew ) );
+			__m128 y0 = _mm_sub_ps( y, _mm_sub_ps( floorJ, unskew ) );
+
+			__m128 xGreater = _mm_cmpgt_ps( x0, y0 );
+			__m128 i1 = MaskToFloat( xGreater );
+			__m128 j1 = _mm_sub_ps( _mm_set1_ps( 1.0f ), i1 );
+
+			__m128 g2 = _mm_set1_ps( G2 );
+			__m128 x1 = _mm_add_ps( _mm_sub_ps( x0, i1 ), g2 );
+			__m128 y1 = _mm_add_ps( _mm_sub_ps( y0, j1 ), g2 );
+			__m128 x2 = _mm_add_ps( x0, _mm_set1_ps( 2.0f * G2 - 1.0f ) );
+			__m128 y2 = _mm_add_ps( y0, _mm_set1_ps( 2.0f * G2 - 1.0f ) );
+
+			__m128i zero = _mm_setzero_si128();
+			__m128i i1i = MaskToInt( xGreater );
+			__m128i j1i = _mm_sub_epi32( _mm_set1_epi32( 1 ), i1i );
+
+			__m128 falloff = _mm_set1_ps( 0.5f );
+			__m128 z = _mm_setzero_ps();
+
+			__m128 n0 = _mm_mul_ps( SimplexWeight( falloff, x0, y0, z, z ), Gradient3( Hash( i, j, zero, zero, seed ), x0, y0, z ) );
+			__m128 n1 = _mm_mul_ps( SimplexWeight( falloff, x1, y1, z, z ), Gradient3( Hash( _mm_add_epi32( i, i1i ), _mm_add_epi32( j, j1i ), zero, zero, seed ), x1, y1, z ) );
+			__m128 n2 = _mm_mul_ps( SimplexWeight( falloff, x2, y2, z, z ), Gradient3( Hash( Offset( i, 1 ), Offset( j, 1 ), zero, zero, seed ), x2, y2, z ) );
+
+			return _mm_mul_ps( _mm_add_ps( _mm_add_ps( n0, n1 ), n2 ), _mm_set1_ps( 70.0f ) );
+		}
+
+		__m128 Simplex3( __m128 x, __m128 y, __m128 z, __m128i seed )
+		{
+			const f32 F3 = 1.0f / 3.0f;
+			const f32 G3 = 1.0f / 6.0f;
+
+			__m128 skew = _mm_mul_ps( _mm_add_ps( _mm_add_ps( x, y ), z ), _mm_set1_ps( F3 ) );
+
+			__m128 floorI, floorJ, floorK;
+			__m128i i = Floor( _mm_add_ps( x, skew ), floorI );
+			__m128i j = Floor( _mm_add_ps( y, skew ), floorJ );
+			__m128i k = Floor( _mm_add_ps( z, skew ), floorK );
+
+			__m128 unskew = _mm_mul_ps( _mm_add_ps( _mm_add_ps( floorI, floorJ ), floorK ), _mm_set1_ps( G3 ) );
+			__m128 x0 = _mm_sub_ps( x, _mm_sub_ps( floorI, unskew ) );
+			__m128 y0 = _mm_sub_ps( y, _mm_sub_ps( floorJ, unskew ) );
+			__m128 z0 = _mm_sub_ps( z, _mm_sub_ps( floorK, unskew ) );
+
+			// Which of the six simplices of the skewed cube contains the point.
+			__m128 xy = _mm_cmpge_ps( x0, y0 );
+			__m128 yz = _mm_cmpge_ps( y0, z0 );
+			__m128 xz = _mm_cmpge_ps( x0, z0 );
+
+			__m128 i1 = _mm_and_ps( xy, xz );
+			__m128 j1 = _mm_andnot_ps( xy, yz );
+			__m128 k1 = _mm_andnot_ps( _mm_or_ps( xz, yz ), _mm_castsi128_ps( _mm_set1_epi32( -1 ) ) );
+			__m128 i2 = _mm_or_ps( xy, xz );
+			__m128 j2 = _mm_or_ps( _mm_andnot_ps( xy, _mm_castsi128_ps( _mm_set1_epi32( -1 ) ) ), yz );
+			__m128 k2 = _mm_andnot_ps( _mm_and_ps( xz, yz ), _mm_castsi128_ps( _mm_set1_epi32( -1 ) ) );
+
+			__m128 g3 = _mm_set1_ps( G3 );
+			__m128 g3x2 = _mm_set1_ps( 2.0f * G3 );
+			__m128 g3x3 = _mm_set1_ps( 3.0f * G3 - 1.0f );
+
+			__m128 x1 = _mm_add_ps( _mm_sub_ps( x0, MaskToFloat( i1 ) ), g3 );
+			__m128 y1 = _mm_add_ps( _mm_sub_ps( y0, MaskToFloat( j1 ) ), g3 );
+			__m128 z1 = _mm_add_ps( _mm_sub_ps( z0, MaskToFloat( k1 ) ), g3 );
+			__m128 x2 = _mm_add_ps( _mm_sub_ps( x0, MaskToFloat( i2 ) ), g3x2 );
+			__m128 y2 = _mm_add_ps( _mm_sub_ps( y0, MaskToFloat( j2 ) ), g3x2 );
+			__m128 z2 = _mm_add_ps( _mm_sub_ps( z0, MaskToFloat( k2 ) ), g3x2 );
+			__m128 x3 = _mm_add_ps( x0, g3x3 );
+			__m128 y3 = _mm_add_ps( y0, g3x3 );
+			__m128 z3 = _mm_add_ps( z0, g3x3 );
+
+			__m128i zero = _mm_setzero_si128();
+			__m128 falloff = _mm_set1_ps( 0.6f );
+			__m128 w = _mm_setzero_ps();
+
+			__m128 n0 = _mm_mul_ps( SimplexWeight( falloff, x0, y0, z0, w ), Gradient3( Hash( i, j, k, zero, seed ), x0, y0, z0 ) );
+			__m128 n1 = _mm_mul_ps( SimplexWeight( falloff, x1, y1, z1, w ), Gradient3( Hash( _mm_add_epi32( i, MaskToInt( i1 ) ), _mm_add_epi32( j, MaskToInt( j1 ) ), _mm_add_epi32( k, MaskToInt( k1 ) ), zero, seed ), x1, y1, z1 ) );
+			__m128 n2 = _mm_mul_ps( SimplexWeight( falloff, x2, y2, z2, w ), Gradient3( Hash( _mm_add_epi32( i, MaskToInt( i2 ) ), _mm_add_epi32( j, MaskToInt( j2 ) ), _mm_add_epi32( k, MaskToInt( k2 ) ), zero, seed ), x2, y2, z2 ) );
+			__m128 n3 = _mm_mul_ps( SimplexWeight( falloff, x3, y3, z3, w ), Gradient3( Hash( Offset( i, 1 ), Offset( j, 1 ), Offset( k, 1 ), zero, seed ), x3, y3, z3 ) );
+
+			return _mm_mul_ps( _mm_add_ps( _mm_add_ps( n0, n1 ), _mm_add_ps( n2, n3 ) ), _mm_set1_ps( 32.0f ) );
+		}
+
+		// Adds 1 to the rank of a where a > b, otherwise to the rank of b.
+		void Rank( __m128 a, __m128 b, __m128i& rankA, __m128i& rankB )
+		{
+			__m128i greater = _mm_castps_si128( _mm_cmpgt_ps( a, b ) );
+			rankA = _mm_sub_epi32( rankA, greater );
+			rankB = _mm_add_epi32( rankB, _mm_add_epi32( greater, _mm_set1_epi32( 1 ) ) );
+		}
+
+		__m128 Simplex4( __m128 x, __m128 y, __m128 z, __m128 w, __m128i seed )
+		{
+			const f32 F4 = 0.309016994f;
+			const f32 G4 = 0.138196601f;
+
+			__m128 skew = _mm_mul_ps( _mm_add_ps( _mm_add_ps( x, y ), _mm_add_ps( z, w ) ), _mm_set1_ps( F4 ) );
+
+			__m128 floorI, floorJ, floorK, floorL;
+			__m128i i = Floor( _mm_add_ps( x, skew ), floorI );
+			__m128i j = Floor( _mm_add_ps( y, skew ), floorJ );
+			__m128i k = Floor( _mm_add_ps( z, skew ), floorK );
+			__m128i l = Floor( _mm_add_ps( w, skew ), floorL );
+
+			__m128 unskew = _mm_mul_ps( _mm_add_ps( _mm_add_ps( floorI, floorJ ), _mm_add_ps( floorK, floorL ) ), _mm_set1_ps( G4 ) );
+
+			__m128 p0[ 4 ] =
+			{
+				_mm_sub_ps( x, _mm_sub_ps( floorI, unskew ) ),
+				_mm_sub_ps( y, _mm_sub_ps( floorJ, unskew ) ),
+				_mm_sub_ps( z, _mm_sub_ps( floorK, unskew ) ),
+				_mm_sub_ps( w, _mm_sub_ps( floorL, unskew ) ),
+			};
+
+			// Rank of every axis by magnitude decides the traversal order of the simplex corners.
+			__m128i rank[ 4 ] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+			Rank( p0[ 0 ], p0[ 1 ], rank[ 0 ], rank[ 1 ] );
+			Rank( p0[ 0 ], p0[ 2 ], rank[ 0 ], rank[ 2 ] );
+			Rank( p0[ 0 ], p0[ 3 ], rank[ 0 ], rank[ 3 ] );
+			Rank( p0[ 1 ], p0[ 2 ], rank[ 1 ], rank[ 2 ] );
+			Rank( p0[ 1 ], p0[ 3 ], rank[ 1 ], rank[ 3 ] );
+			Rank( p0[ 2 ], p0[ 3 ], rank[ 2 ], rank[ 3 ] );
+
+			__m128i cell[ 4 ] = { i, j, k, l };
+			__m128 falloff = _mm_set1_ps( 0.6f );
+
+			__m128 sum = _mm_mul_ps(
+				SimplexWeight( falloff, p0[ 0 ], p0[ 1 ], p0[ 2 ], p0[ 3 ] ),
+				Gradient4( Hash( i, j, k, l, seed ), p0[ 0 ], p0[ 1 ], p0[ 2 ], p0[ 3 ] ) );
+
+			// Corners 1 to 3 step along the axes of rank >= 3, >= 2 and >= 1; corner 4 is ( 1, 1, 1, 1 ).
+			for( s32 corner = 1; corner <= 4; ++corner )
+			{
+				__m128 offset = _mm_set1_ps( corner * G4 );
+				__m128 p[ 4 ];
+				__m128i c[ 4 ];
+
+				for( s32 axis = 0; axis < 4; ++axis )
+				{
+					__m128i step = ( corner == 4 )
+						? _mm_set1_epi32( 1 )
+						: _mm_and_si128( _mm_cmpgt_epi32( rank[ axis ], _mm_set1_epi32( 3 - corner ) ), _mm_set1_epi32( 1 ) );
+
+					c[ axis ] = _mm_add_epi32( cell[ axis ], step );
+					p[ axis ] = _mm_add_ps( _mm_sub_ps( p0[ axis ], _mm_cvtepi32_ps( step ) ), offset );
+				}
+
+				sum = _mm_add_ps( sum, _mm_mul_ps(
+					SimplexWeight( falloff, p[ 0 ], p[ 1 ], p[ 2 ], p[ 3 ] ),
+					Gradient4( Hash( c[ 0 ], c[ 1 ], c[ 2 ], c[ 3 ], seed ), p[ 0 ], p[ 1 ], p[ 2 ], p[ 3 ] ) ) );
+			}
+
+			return _mm_mul_ps( sum, _mm_set1_ps( 27.0f ) );
+		}
+
+		__m128 Kernel( NoiseType::Type type, s32 dimension, __m128 x, __m128 y, __m128 z, __m128 w, __m128i seed )
+		{
+			switch( dimension )
+			{
+			case 2:
+				switch( type )
+				{
+				case NoiseType::Value: return Value2( x, y, seed );
+				case NoiseType::Perlin: return Perlin2( x, y, seed );
+				default: return Simplex2( x, y, seed );
+				}
+
+			case 3:
+				switch( type )
+				{
+				case NoiseType::Value: return Value3( x, y, z, seed );
+				case NoiseType::Perlin: return Perlin3( x, y, z, seed );
+				default: return Simplex3( x, y, z, seed );
+				}
+
+			default:
+				switch( type )
+				{
+				case NoiseType::Value: return Value4( x, y, z, w, seed );
+				case NoiseType::Perlin: return Perlin4( x, y, z, w, seed );
+				default: return Simplex4( x, y, z, w, seed );
+				}
+			}
+		}
+
+		__m128 FractalKernel( const Noise::FractalParameters& parameters, s32 dimension, __m128 x, __m128 y, __m128 z, __m128 w )
+		{
+			__m128 sum = _mm_setzero_ps();
+			__m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+			__m128 one = _mm_set1_ps( 1.0f );
+
+			f32 frequency = parameters.Frequency;
+			f32 amplitude = 1.0f;
+			f32 totalAmplitude = 0.0f;
+
+			for( s32 octave = 0; octave < parameters.Octaves; ++octave )
+			{
+				__m128 scale = _mm_set1_ps( frequency );
+				__m128i seed = _mm_set1_epi32( static_cast<s32>( parameters.Seed + octave ) );
+
+				__m128 n = Kernel( parameters.Type, dimension,
+					_mm_mul_ps( x, scale ), _mm_mul_ps( y, scale ), _mm_mul_ps( z, scale ), _mm_mul_ps( w, scale ), seed );
+
+				if( parameters.Fractal == Noise::FractalType::Ridged )
+				{
+					n = _mm_sub_ps( one, _mm_and_ps( n, absMask ) );
+					n = _mm_mul_ps( n, n );
+				}
+
+				sum = _mm_add_ps( sum, _mm_mul_ps( n, _mm_set1_ps( amplitude ) ) );
+
+				totalAmplitude += amplitude;
+				frequency *= parameters.Lacunarity;
+				amplitude *= parameters.Gain;
+			}
+
+			return ( totalAmplitude > 0.0f ) ? _mm_mul_ps( sum, _mm_set1_ps( 1.0f / totalAmplitude ) ) : sum;
+		}
+
+		// Loads up to four points into SoA registers; missing lanes repeat the last point.
+		template<typename Point>
+		void Gather( const Point* pPoints, s32 count, s32 dimension, __m128* pCoordinates )
+		{
+			__declspec( align( 16 ) ) f32 lanes[ 4 ][ 4 ];
+
+			for( s32 lane = 0; lane < 4; ++lane )
+			{
+				const Point& point = pPoints[ Math::Min( lane, count - 1 ) ];
+
+				for( s32 axis = 0; axis < 4; ++axis )
+				{
+					lanes[ axis ][ lane ] = ( axis < dimension ) ? point[ axis ] : 0.0f;
+				}
+			}
+
+			for( s32 axis = 0; axis < 4; ++axis )
+			{
+				pCoordinates[ axis ] = _mm_load_ps( lanes[ axis ] );
+			}
+		}
+
+		void Scatter( __m128 v, s32 count, f32* pResults )
+		{
+			__declspec( align( 16 ) ) f32 lanes[ 4 ];
+			_mm_store_ps( lanes, v );
+
+			for( s32 i = 0; i < Math::Min( count, 4 ); ++i )
+			{
+				pResults[ i ] = lanes[ i ];
+			}
+		}
+
+		template<typename Point>
+		void EvaluatePoints( NoiseType::Type type, s32 dimension, const Point* pPoints, s32 count, f32* pResults, u32 seed )
+		{
+			Assert( count == 0 || pPoints != NULL );
+			Assert( count == 0 || pResults != NULL );
+
+			__m128i seedVector = _mm_set1_epi32( static_cast<s32>( seed ) );
+
+			for( s32 i = 0; i < count; i += 4 )
+			{
+				__m128 p[ 4 ];
+				Gather( pPoints + i, count - i, dimension, p );
+				Scatter( Kernel( type, dimension, p[ 0 ], p[ 1 ], p[ 2 ], p[ 3 ], seedVector ), count - i, pResults + i );
+			}
+		}
+
+		template<typename Point>
+		void FractalPoints( const Noise::FractalParameters& parameters, s32 dimension, const Point* pPoints, s32 count, f32* pResults )
+		{
+			Assert( count == 0 || pPoints != NULL );
+			Assert( count == 0 || pResults != NULL );
+
+			for( s32 i = 0; i < count; i += 4 )
+			{
+				__m128 p[ 4 ];
+				Gather( pPoints + i, count - i, dimension, p );
+				Scatter( FractalKernel( parameters, dimension, p[ 0 ], p[ 1 ], p[ 2 ], p[ 3 ] ), count - i, pResults + i );
+			}
+		}
+
+		f32 FirstLane( __m128 v )
+		{
+			return _mm_cvtss_f32( v );
+		}
+	}
+
+	// One row of a heightfield or volume, 4 samples per step along X.
+	class Noise::FillBody
+	{
+	public:
+		FillBody( const Noise::FractalParameters& parameters, s32 dimension, const Vector3& origin, const Vector3& spacing, s32 width, s32 height, f32* pResults )
+			: m_parameters( parameters )
+			, m_dimension( dimension )
+			, m_origin( origin )
+			, m_spacing( spacing )
+			, m_width( width )
+			, m_height( height )
+			, m_pResults( pResults )
+		{
+		}
+
+		void operator () ( s32 begin, s32 end )
+		{
+			__m128 offsets = _mm_mul_ps( _mm_setr_ps( 0.0f, 1.0f, 2.0f, 3.0f ), _mm_set1_ps( m_spacing.X ) );
+			__m128 zero = _mm_setzero_ps();
+
+			for( s32 row = begin; row < end; ++row )
+			{
+				__m128 y = _mm_set1_ps( m_origin.Y + m_spacing.Y * ( row % m_height ) );
+				__m128 z = _mm_set1_ps( m_origin.Z + m_spacing.Z * ( row / m_height ) );
+
+				f32* pRow = m_pResults + row * m_width;
+
+				for( s32 column = 0; column < m_width; column += 4 )
+				{
+					__m128 x = _mm_add_ps( _mm_set1_ps( m_origin.X + m_spacing.X * column ), offsets );
+					Scatter( FractalKernel( m_parameters, m_dimension, x, y, z, zero ), m_width - column, pRow + column );
+				}
+			}
+		}
+
+	private:
+		FillBody& operator = ( const FillBody& );
+
+		const Noise::FractalParameters& m_parameters;
+		s32 m_dimension;
+		Vector3 m_origin;
+		Vector3 m_spacing;
+		s32 m_width;
+		s32 m_height;
+		f32* m_pResults;
+	};
+
+	Noise::FractalParameters::FractalParameters()
+		: Type( NoiseType::Simplex )
+		, Fractal( FractalType::Fbm )
+		, Octaves( 4 )
+		, Frequency( 1.0f )
+		, Lacunarity( 2.0f )
+		, Gain( 0.5f )
+		, Seed( 0 )
+	{
+	}
+
+	f32 Noise::Evaluate( NoiseType::Type type, const Vector2& point, u32 seed )
+	{
+		return FirstLane( Kernel( type, 2, _mm_set1_ps( point.X ), _mm_set1_ps( point.Y ), _mm_setzero_ps(), _mm_setzero_ps(), _mm_set1_epi32( static_cast<s32>( seed ) ) ) );
+	}
+
+	f32 Noise::Evaluate( NoiseType::Type type, const Vector3& point, u32 seed )
+	{
+		return FirstLane( Kernel( type, 3, _mm_set1_ps( point.X ), _mm_set1_ps( point.Y ), _mm_set1_ps( point.Z ), _mm_setzero_ps(), _mm_set1_epi32( static_cast<s32>( seed ) ) ) );
+	}
+
+	f32 Noise::Evaluate( NoiseType::Type type, const Vector4& point, u32 seed )
+	{
+		return FirstLane( Kernel( type, 4, _mm_set1_ps( point.X ), _mm_set1_ps( point.Y ), _mm_set1_ps( point.Z ), _mm_set1_ps( point.W ), _mm_set1_epi32( static_cast<s32>( seed ) ) ) );
+	}
+
+	void Noise::Evaluate( NoiseType::Type type, const Vector2* pPoints, s32 count, f32* pResults, u32 seed )
+	{
+		EvaluatePoints( type, 2, pPoints, count, pResults, seed );
+	}
+
+	void Noise::Evaluate( NoiseType::Type type, const Vector3* pPoints, s32 count, f32* pResults, u32 seed )
+	{
+		EvaluatePoints( type, 3, pPoints, count, pResults, seed );
+	}
+
+	void Noise::Evaluate( NoiseType::Type type, const Vector4* pPoints, s32 count, f32* pResults, u32 seed )
+	{
+		EvaluatePoints( type, 4, pPoints, count, pResults, seed );
+	}
+
+	f32 Noise::Fractal( const FractalParameters& parameters, const Vector2& point )
+	{
+		return FirstLane( FractalKernel( parameters, 2, _mm_set1_ps( point.X ), _mm_set1_ps( point.Y ), _mm_setzero_ps(), _mm_setzero_ps() ) );
+	}
+
+	f32 Noise::Fractal( const FractalParameters& parameters, const Vector3& point )
+	{
+		return FirstLane( FractalKernel( parameters, 3, _mm_set1_ps( point.X ), _mm_set1_ps( point.Y ), _mm_set1_ps( point.Z ), _mm_setzero_ps() ) );
+	}
+
+	f32 Noise::Fractal( const FractalParameters& parameters, const Vector4& point )
+	{
+		return FirstLane( FractalKernel( parameters, 4, _mm_set1_ps( point.X ), _mm_set1_ps( point.Y ), _mm_set1_ps( point.Z ), _mm_set1_ps( point.W ) ) );
+	}
+
+	void Noise::Fractal( const FractalParameters& parameters, const Vector2* pPoints, s32 count, f32* pResults )
+	{
+		FractalPoints( parameters, 2, pPoints, count, pResults );
+	}
+
+	void Noise::Fractal( const FractalParameters& parameters, const Vector3* pPoints, s32 count, f32* pResults )
+	{
+		FractalPoints( parameters, 3, pPoints, count, pResults );
+	}
+
+	void Noise::Fractal( const FractalParameters& parameters, const Vector4* pPoints, s32 count, f32* pResults )
+	{
+		FractalPoints( parameters, 4, pPoints, count, pResults );
+	}
+
+	void Noise::FillHeightfield( const FractalParameters& parameters, const Vector2& origin, const Vector2& spacing, s32 width, s32 height, f32* pResults )
+	{
+		Assert( width > 0 );
+		Assert( height > 0 );
+		Assert( pResults != NULL );
+
+		FillBody body( parameters, 2, Vector3( origin ), Vector3( spacing ), width, height, pResults );
+		Parallel::For( 0, height, 8, body );
+	}
+
+	void Noise::FillVolume( const FractalParameters& parameters, const Vector3& origin, const Vector3& spacing, s32 width, s32 height, s32 depth, f32* pResults )
+	{
+		Assert( width > 0 );
+		Assert( height > 0 );
+		Assert( depth > 0 );
+		Assert( pResults != NULL );
+
+		FillBody body( parameters, 3, origin, spacing, width, height, pResults );
+		Parallel::For( 0, height * depth, 8, body );
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+namespace Tomato
+{
+	struct NoiseType
+	{
+		enum Type
+		{
+			Value,
+			Perlin,
+			Simplex,
+		};
+	};
+
+	// Coherent noise for procedural content.
+	//
+	// Every function runs the same SSE kernels that evaluate four points at once; single point
+	// calls just use one lane, so batch and single point results are identical. Lattice
+	// hashing is arithmetic rather than table based, which keeps the kernels free of gathers
+	// and makes the output depend on nothing but the coordinates and the seed.
+	// Results lie roughly in [ -1, 1 ]; ridged fractals lie in [ 0, 1 ].
+	class TOMATO_API Noise
+	{
+	public:
+		struct FractalType
+		{
+			enum Type
+			{
+				Fbm,
+				Ridged,
+			};
+		};
+
+		struct FractalParameters
+		{
+			FractalParameters();
+
+			NoiseType::Type Type;
+			FractalType::Type Fractal;
+			s32 Octaves;
+			f32 Frequency;
+
+			// Frequency multiplier and amplitude multiplier from one octave to the next.
+			f32 Lacunarity;
+			f32 Gain;
+
+			u32 Seed;
+		};
+
+	public:
+		static f32 Evaluate( NoiseType::Type type, const Vector2& point, u32 seed = 0 );
+		static f32 Evaluate( NoiseType::Type type, const Vector3& point, u32 seed = 0 );
+		static f32 Evaluate( NoiseType::Type type, const Vector4& point, u32 seed = 0 );
+
+		static void Evaluate( NoiseType::Type type, const Vector2* pPoints, s32 count, f32* pResults, u32 seed = 0 );
+		static void Evaluate( NoiseType::Type type, const Vector3* pPoints, s32 count, f32* pResults, u32 seed = 0 );
+		static void Evaluate( NoiseType::Type type, const Vector4* pPoints, s32 count, f32* pResults, u32 seed = 0 );
+
+		static f32 Fractal( const FractalParameters& parameters, const Vector2& point );
+		static f32 Fractal( const FractalParameters& parameters, const Vector3& point );
+		static f32 Fractal( const FractalParameters& parameters, const Vector4& point );
+
+		static void Fractal( const FractalParameters& parameters, const Vector2* pPoints, s32 count, f32* pResults );
+		static void Fractal( const FractalParameters& parameters, const Vector3* pPoints, s32 count, f32* pResults );
+		static void Fractal( const FractalParameters& parameters, const Vector4* pPoints, s32 count, f32* pResults );
+
+		// pResults[ y * width + x ] = Fractal( origin + spacing * ( x, y ) ), rows filled on the worker threads.
+		static void FillHeightfield( const FractalParameters& parameters, const Vector2& origin, const Vector2& spacing, s32 width, s32 height, f32* pResults );
+
+		// pResults[ ( z * height + y ) * width + x ] = Fractal( origin + spacing * ( x, y, z ) ), rows filled on the worker threads.
+		static void FillVolume( const FractalParameters& parameters, const Vector3& origin, const Vector3& spacing, s32 width, s32 height, s32 depth, f32* pResults );
+
+	private:
+		class FillBody;
+	};
+}
@@ -0,0 +1,621 @@
+#include "TomatoPCH.h"
+
+#include "Predicates.h"
+
+#include <float.h>
+
+namespace Tomato
+{
+	namespace
+	{
+		// Half an ulp of 1.0 and the constant that splits a double into two 26 bit halves.
+		const f64 Epsilon = 1.1102230246251565e-16;
+		const f64 Splitter = 134217729.0;
+
+		const f64 Orient2DBound = ( 3.0 + 16.0 * Epsilon ) * Epsilon;
+		const f64 Orient3DBound = ( 7.0 + 56.0 * Epsilon ) * Epsilon;
+		const f64 InCircleBound = ( 10.0 + 96.0 * Epsilon ) * Epsilon;
+		const f64 InSphereBound = ( 16.0 + 224.0 * Epsilon ) * Epsilon;
+
+		// The exact stage relies on every double operation being rounded to 53 bits,
+		// which the x87 unit does not do by default.
+		class DoublePrecisionScope
+		{
+		public:
+			DoublePrecisionScope()
+			{
+#if defined( _M_IX86 )
+				_controlfp_s( &m_control, 0, 0 );
+				unsigned int ignored;
+				_controlfp_s( &ignored, _PC_53, _MCW_PC );
+#endif
+			}
+
+			~DoublePrecisionScope()
+			{
+#if defined( _M_IX86 )
+				unsigned int ignored;
+				_controlfp_s( &ignored, m_control, _MCW_PC );
+#endif
+			}
+
+		private:
+			DoublePrecisionScope( const DoublePrecisionScope& copy );
+			DoublePrecisionScope& operator = ( const DoublePrecisionScope& copy );
+
+#if defined( _M_IX86 )
+			unsigned int m_control;
+#endif
+		};
+
+		// A value stored as a sum of non-overlapping doubles in increasing magnitude, with zero
+		// components removed. The last component carries the sign of the whole sum.
+		typedef std::vector<f64> Expansion;
+
+		inline void FastTwoSum( f64 a, f64 b, f64& x, f64& y )
+		{
+			x = a + b;
+			f64 bVirtual = x - a;
+			y = b - bVirtual;
+		}
+
+		inline void TwoSum( f64 a, f64 b, f64& x, f64& y )
+		{
+			x = a + b;
+			f64 bVirtual = x - a;
+			f64 aVirtual = x - bVirtual;
+			y = ( a - aVirtual ) + ( b - bVirtual );
+		}
+
+		inline void TwoDiff( f64 a, f64 b, f64& x, f64& y )
+		{
+			x = a - b;
+			f64 bVirtual = a - x;
+			f64 aVirtual = x + bVirtual;
+			y = ( a - aVirtual ) + ( bVirtual - b );
+		}
+
+		inline void Split( f64 a, f64& high, f64& low )
+		{
+			f64 c = Splitter * a;
+			f64 big = c - a;
+			high = c - big;
+			low = a - high;
+		}
+
+		inline void TwoProduct( f64 a, f64 b, f64& x, f64& y )
+		{
+			x = a * b;
+
+			f64 aHigh, aLow, bHigh, bLow;
+			Split( a, aHigh, aLow );
+			Split( b, bHigh, bLow );
+
+			f64 error1 = x - ( aHigh * bHigh );
+			f64 error2 = error1 - ( aLow * bHigh );
+			f64 error3 = error2 - ( aHigh * bLow );
+			y = ( aLow * bLow ) - error3;
+		}
+
+		void Finish( f64 q, Expansion& h )
+		{
+			if( q != 0.0 || h.empty() )
+			{
+				h.push_back( q );
+			}
+		}
+
+		Expansion Difference( f64 a, f64 b )
+		{
+			f64 x, y;
+			TwoDiff( a, b, x, y );
+
+			Expansion h;
+			if( y != 0.0 )
+			{
+				h.push_back( y );
+			}
+			Finish( x, h );
+			return h;
+		}
+
+		// Takes the next component of smaller magnitude from either expansion.
+		inline f64 TakeSmaller( const Expansion& e, size_t& eIndex, const Expansion& f, size_t& fIndex )
+		{
+			if( fIndex == f.size() || ( eIndex < e.size() && ( ( f[ fIndex ] > e[ eIndex ] ) == ( f[ fIndex ] > -e[ eIndex ] ) ) ) )
+			{
+				return e[ eIndex++ ];
+			}
+
+			return f[ fIndex++ ];
+		}
+
+		// Shewchuk's FAST-EXPANSION-SUM with zero elimination.
+		Expansion Add( const Expansion& e, const Expansion& f )
+		{
+			Expansion h;
+			h.reserve( e.size() + f.size() );
+
+			size_t eIndex = 0;
+			size_t fIndex = 0;
+
+			f64 q = TakeSmaller( e, eIndex, f, fIndex );
+
+			if( eIndex < e.size() || fIndex < f.size() )
+			{
+				f64 next = TakeSmaller( e, eIndex, f, fIndex );
+
+				f64 sum, error;
+				FastTwoSum( next, q, sum, error );
+				q = sum;
+				if( error != 0.0 )
+				{
+					h.push_back( error );
+				}
+
+				while( eIndex < e.size() || fIndex < f.size() )
+				{
+					next = TakeSmaller( e, eIndex, f, fIndex );
+
+					TwoSum( q, next, sum, error );
+					q = sum;
+					if( error != 0.0 )
+					{
+						h.push_back( error );
+					}
+				}
+			}
+
+			Finish( q, h );
+			return h;
+		}
+
+		Expansion Negate( const Expansion& e )
+		{
+			Expansion h( e );
+			for( size_t i = 0; i < h.size(); ++i )
+			{
+				h[ i ] = -h[ i ];
+			}
+			return h;
+		}
+
+		Expansion Subtract( const Expansion& e, const Expansion& f )
+		{
+			return Add( e, Negate( f ) );
+		}
+
+		// Shewchuk's SCALE-EXPANSION with zero elimination.
+		Expansion Scale( const Expansion& e, f64 b )
+		{
+			Expansion h;
+			h.reserve( e.size() * 2 );
+
+			f64 q, error;
+			TwoProduct( e[ 0 ], b, q, error );
+			if( error != 0.0 )
+			{
+				h.push_back( error );
+			}
+
+			for( size_t i = 1; i < e.size(); ++i )
+			{
+				f64 product1, product0;
+				TwoProduct( e[ i ], b, product1, product0 );
+
+				f64 sum;
+				TwoSum( q, product0, sum, error );
+				if( error != 0.0 )
+				{
+					h.push_back( error );
+				}
+
+				FastTwoSum( product1, sum, q, error );
+				if( error != 0.0 )
+				{
+					h.push_back( error );
+				}
+			}
+
+			Finish( q, h );
+			return h;
+		}
+
+		Expansion Multiply( const Expansion& e, const Expansion& f )
+		{
+			Expansion h = Scale( e, f[ 0 ] );
+			for( size_t i = 1; i < f.size(); ++i )
+			{
+				h = Add( h, Scale( e, f[ i ] ) );
+			}
+			return h;
+		}
+
+		// e1 * f1 - e2 * f2
+		Expansion Minor( const Expansion& e1, const Expansion& f1, const Expansion& e2, const Expansion& f2 )
+		{
+			return Subtract( Multiply( e1, f1 ), Multiply( e2, f2 ) );
+		}
+
+		Expansion Lift( const Expansion& x, const Expansion& y )
+		{
+			return Add( Multiply( x, x ), Multiply( y, y ) );
+		}
+
+		Expansion Lift( const Expansion& x, const Expansion& y, const Expansion& z )
+		{
+			return Add( Lift( x, y ), Multiply( z, z ) );
+		}
+	}
+
+	f64 Predicates::Orient2D( const Vector2& a, const Vector2& b, const Vector2& c )
+	{
+		return Orient2D( a.X, a.Y, b.X, b.Y, c.X, c.Y );
+	}
+
+	f64 Predicates::Orient2DFast( const Vector2& a, const Vector2& b, const Vector2& c )
+	{
+		f64 acx = static_cast<f64>( a.X ) - c.X;
+		f64 bcx = static_cast<f64>( b.X ) - c.X;
+		f64 acy = static_cast<f64>( a.Y ) - c.Y;
+		f64 bcy = static_cast<f64>( b.Y ) - c.Y;
+
+		return acx * bcy - acy * bcx;
+	}
+
+	f64 Predicates::Orient3D( const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d )
+	{
+		f64 points[ 4 ][ 3 ] =
+		{
+			{ a.X, a.Y, a.Z },
+			{ b.X, b.Y, b.Z },
+			{ c.X, c.Y, c.Z },
+			{ d.X, d.Y, d.Z },
+		};
+
+		return Orient3D( points[ 0 ], points[ 1 ], points[ 2 ], points[ 3 ] );
+	}
+
+	f64 Predicates::Orient3D( const Vector3d& a, const Vector3d& b, const Vector3d& c, const Vector3d& d )
+	{
+		f64 points[ 4 ][ 3 ] =
+		{
+			{ a.X, a.Y, a.Z },
+			{ b.X, b.Y, b.Z },
+			{ c.X, c.Y, c.Z },
+			{ d.X, d.Y, d.Z },
+		};
+
+		return Orient3D( points[ 0 ], points[ 1 ], points[ 2 ], points[ 3 ] );
+	}
+
+	f64 Predicates::Orient3DFast( const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d )
+	{
+		f64 adx = static_cast<f64>( a.X ) - d.X;
+		f64 bdx = static_cast<f64>( b.X ) - d.X;
+		f64 cdx = static_cast<f64>( c.X ) - d.X;
+		f64 ady = static_cast<f64>( a.Y ) - d.Y;
+		f64 bdy = static_cast<f64>( b.Y ) - d.Y;
+		f64 cdy = static_cast<f64>( c.Y ) - d.Y;
+		f64 adz = static_cast<f64>( a.Z ) - d.Z;
+		f64 bdz = static_cast<f64>( b.Z ) - d.Z;
+		f64 cdz = static_cast<f64>( c.Z ) - d.Z;
+
+		return adz * ( bdx * cdy - cdx * bdy )
+			+ bdz * ( cdx * ady - adx * cdy )
+			+ cdz * ( adx * bdy - bdx * ady );
+	}
+
+	f64 Predicates::InCircle( const Vector2& a, const Vector2& b, const Vector2& c, const Vector2& d )
+	{
+		return InCircle( a.X, a.Y, b.X, b.Y, c.X, c.Y, d.X, d.Y );
+	}
+
+	f64 Predicates::InCircleFast( const Vector2& a, const Vector2& b, const Vector2& c, const Vector2& d )
+	{
+		f64 adx = static_cast<f64>( a.X ) - d.X;
+		f64 bdx = static_cast<f64>( b.X ) - d.X;
+		f64 cdx = static_cast<f64>( c.X ) - d.X;
+		f64 ady = static_cast<f64>( a.Y ) - d.Y;
+		f64 bdy = static_cast<f64>( b.Y ) - d.Y;
+		f64 cdy = static_cast<f64>( c.Y ) - d.Y;
+
+		return ( adx * adx + ady * ady ) * ( bdx * cdy - cdx * bdy )
+			+ ( bdx * bdx + bdy * bdy ) * ( cdx * ady - adx * cdy )
+			+ ( cdx * cdx + cdy * cdy ) * ( adx * bdy - bdx * ady );
+	}
+
+	f64 Predicates::InSphere( const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d, const Vector3& e )
+	{
+		f64 points[ 5 ][ 3 ] =
+		{
+			{ a.X, a.Y, a.Z },
+			{ b.X, b.Y, b.Z },
+			{ c.X, c.Y, c.Z },
+			{ d.X, d.Y, d.Z },
+			{ e.X, e.Y, e.Z },
+		};
+
+		return InSphere( points[ 0 ], points[ 1 ], points[ 2 ], points[ 3 ], points[ 4 ] );
+	}
+
+	f64 Predicates::InSphere( const Vector3d& a, const Vector3d& b, const Vector3d& c, const Vector3d& d, const Vector3d& e )
+	{
+		f64 points[ 5 ][ 3 ] =
+		{
+			{ a.X, a.Y, a.Z },
+			{ b.X, b.Y, b.Z },
+			{ c.X, c.Y, c.Z },
+			{ d.X, d.Y, d.Z },
+			{ e.X, e.Y, e.Z },
+		};
+
+		return InSphere( points[ 0 ], points[ 1 ], points[ 2 ], points[ 3 ], points[ 4 ] );
+	}
+
+	f64 Predicates::InSphereFast( const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d, const Vector3& e )
+	{
+		f64 aex = static_cast<f64>( a.X ) - e.X;
+		f64 bex = static_cast<f64>( b.X ) - e.X;
+		f64 cex = static_cast<f64>( c.X ) - e.X;
+		f64 dex = static_cast<f64>( d.X ) - e.X;
+		f64 aey = static_cast<f64>( a.Y ) - e.Y;
+		f64 bey = static_cast<f64>( b.Y ) - e.Y;
+		f64 cey = static_cast<f64>( c.Y ) - e.Y;
+		f64 dey = static_cast<f64>( d.Y ) - e.Y;
+		f64 aez = static_cast<f64>( a.Z ) - e.Z;
+		f64 bez = static_cast<f64>( b.Z ) - e.Z;
+		f64 cez = static_cast<f64>( c.Z ) - e.Z;
+		f64 dez = static_cast<f64>( d.Z ) - e.Z;
+
+		f64 ab = aex * bey - bex * aey;
+		f64 bc = bex * cey - cex * bey;
+		f64 cd = cex * dey - dex * cey;
+		f64 da = dex * aey - aex * dey;
+		f64 ac = aex * cey - cex * aey;
+		f64 bd = bex * dey - dex * bey;
+
+		f64 abc = aez * bc - bez * ac + cez * ab;
+		f64 bcd = bez * cd - cez * bd + dez * bc;
+		f64 cda = cez * da + dez * ac + aez * cd;
+		f64 dab = dez * ab + aez * bd + bez * da;
+
+		f64 aLift = aex * aex + aey * aey + aez * aez;
+		f64 bLift = bex * bex + bey * bey + bez * bez;
+		f64 cLift = cex * cex + cey * cey + cez * cez;
+		f64 dLift = dex * dex + dey * dey + dez * dez;
+
+		return ( dLift * abc - cLift * dab ) + ( bLift * cda - aLift * bcd );
+	}
+
+	f64 Predicates::Orient2D( f64 ax, f64 ay, f64 bx, f64 by, f64 cx, f64 cy )
+	{
+		f64 left = ( ax - cx ) * ( by - cy );
+		f64 right = ( ay - cy ) * ( bx - cx );
+		f64 determinant = left - right;
+
+		f64 bound = Orient2DBound * ( Math::Abs( left ) + Math::Abs( right ) );
+		if( determinant > bound || -determinant > bound )
+		{
+			return determinant;
+		}
+
+		DoublePrecisionScope precision;
+
+		Expansion acx = Difference( ax, cx );
+		Expansion bcx = Difference( bx, cx );
+		Expansion acy = Difference( ay, cy );
+		Expansion bcy = Difference( by, cy );
+
+		return Minor( acx, bcy, acy, bcx ).back();
+	}
+
+	f64 Predicates::Orient3D( const f64* pA, const f64* pB, const f64* pC, const f64* pD )
+	{
+		f64 adx = pA[ 0 ] - pD[ 0 ];
+		f64 bdx = pB[ 0 ] - pD[ 0 ];
+		f64 cdx = pC[ 0 ] - pD[ 0 ];
+		f64 ady = pA[ 1 ] - pD[ 1 ];
+		f64 bdy = pB[ 1 ] - pD[ 1 ];
+		f64 cdy = pC[ 1 ] - pD[ 1 ];
+		f64 adz = pA[ 2 ] - pD[ 2 ];
+		f64 bdz = pB[ 2 ] - pD[ 2 ];
+		f64 cdz = pC[ 2 ] - pD[ 2 ];
+
+		f64 bdxcdy = bdx * cdy;
+		f64 cdxbdy = cdx * bdy;
+		f64 cdxady = cdx * ady;
+		f64 adxcdy = adx * cdy;
+		f64 adxbdy = adx * bdy;
+		f64 bdxady = bdx * ady;
+
+		f64 determinant = adz * ( bdxcdy - cdxbdy ) + bdz * ( cdxady - adxcdy ) + cdz * ( adxbdy - bdxady );
+
+		f64 permanent =
+			( Math::Abs( bdxcdy ) + Math::Abs( cdxbdy ) ) * Math::Abs( adz ) +
+			( Math::Abs( cdxady ) + Math::Abs( adxcdy ) ) * Math::Abs( bdz ) +
+			( Math::Abs( adxbdy ) + Math::Abs( bdxady ) ) * Math::Abs( cdz );
+
+		f64 bound = Orient3DBound * permanent;
+		if( determinant > bound || -determinant > bound )
+		{
+			return determinant;
+		}
+
+		DoublePrecisionScope precision;
+
+		Expansion eAdx = Difference( pA[ 0 ], pD[ 0 ] );
+		Expansion eBdx = Difference( pB[ 0 ], pD[ 0 ] );
+		Expansion eCdx = Difference( pC[ 0 ], pD[ 0 ] );
+		Expansion eAdy = Difference( pA[ 1 ], pD[ 1 ] );
+		Expansion eBdy = Difference( pB[ 1 ], pD[ 1 ] );
+		Expansion eCdy = Difference( pC[ 1 ], pD[ 1 ] );
+		Expansion eAdz = Difference( pA[ 2 ], pD[ 2 ] );
+		Expansion eBdz = Difference( pB[ 2 ], pD[ 2 ] );
+		Expansion eCdz = Difference( pC[ 2 ], pD[ 2 ] );
+
+		Expansion exact = Add(
+			Add(
+				Multiply( eAdz, Minor( eBdx, eCdy, eCdx, eBdy ) ),
+				Multiply( eBdz, Minor( eCdx, eAdy, eAdx, eCdy ) ) ),
+			Multiply( eCdz, Minor( eAdx, eBdy, eBdx, eAdy ) ) );
+
+		return exact.back();
+	}
+
+	f64 Predicates::InCircle( f64 ax, f64 ay, f64 bx, f64 by, f64 cx, f64 cy, f64 dx, f64 dy )
+	{
+		f64 adx = ax - dx;
+		f64 bdx = bx - dx;
+		f64 cdx = cx - dx;
+		f64 ady = ay - dy;
+		f64 bdy = by - dy;
+		f64 cdy = cy - dy;
+
+		f64 bdxcdy = bdx * cdy;
+		f64 cdxbdy = cdx * bdy;
+		f64 cdxady = cdx * ady;
+		f64 adxcdy = adx * cdy;
+		f64 adxbdy = adx * bdy;
+		f64 bdxady = bdx * ady;
+
+		f64 aLift = adx * adx + ady * ady;
+		f64 bLift = bdx * bdx + bdy * bdy;
+		f64 cLift = cdx * cdx + cdy * cdy;
+
+		f64 determinant = aLift * ( bdxcdy - cdxbdy ) + bLift * ( cdxady - adxcdy ) + cLift * ( adxbdy - bdxady );
+
+		f64 permanent =
+			( Math::Abs( bdxcdy ) + Math::Abs( cdxbdy ) ) * aLift +
+			( Math::Abs( cdxady ) + Math::Abs( adxcdy ) ) * bLift +
+			( Math::Abs( adxbdy ) + Math::Abs( bdxady ) ) * cLift;
+
+		f64 bound = InCircleBound * permanent;
+		if( determinant > bound || -determinant > bound )
+		{
+			return determinant;
+		}
+
+		DoublePrecisionScope precision;
+
+		Expansion eAdx = Difference( ax, dx );
+		Expansion eBdx = Difference( bx, dx );
+		Expansion eCdx = Difference( cx, dx );
+		Expansion eAdy = Difference( ay, dy );
+		Expansion eBdy = Difference( by, dy );
+		Expansion eCdy = Difference( cy, dy );
+
+		Expansion exact = Add(
+			Add(
+				Multiply( Lift( eAdx, eAdy ), Minor( eBdx, eCdy, eCdx, eBdy ) ),
+				Multiply( Lift( eBdx, eBdy ), Minor( eCdx, eAdy, eAdx, eCdy ) ) ),
+			Multiply( Lift( eCdx, eCdy ), Minor( eAdx, eBdy, eBdx, eAdy ) ) );
+
+		return exact.back();
+	}
+
+	f64 Predicates::InSphere( const f64* pA, const f64* pB, const f64* pC, const f64* pD, const f64* pE )
+	{
+		f64 aex = pA[ 0 ] - pE[ 0 ];
+		f64 bex = pB[ 0 ] - pE[ 0 ];
+		f64 cex = pC[ 0 ] - pE[ 0 ];
+		f64 dex = pD[ 0 ] - pE[ 0 ];
+		f64 aey = pA[ 1 ] - pE[ 1 ];
+		f64 bey = pB[ 1 ] - pE[ 1 ];
+		f64 cey = pC[ 1 ] - pE[ 1 ];
+		f64 dey = pD[ 1 ] - pE[ 1 ];
+		f64 aez = pA[ 2 ] - pE[ 2 ];
+		f64 bez = pB[ 2 ] - pE[ 2 ];
+		f64 cez = pC[ 2 ] - pE[ 2 ];
+		f64 dez = pD[ 2 ] - pE[ 2 ];
+
+		f64 aexbey = aex * bey;
+		f64 bexaey = bex * aey;
+		f64 bexcey = bex * cey;
+		f64 cexbey = cex * bey;
+		f64 cexdey = cex * dey;
+		f64 dexcey = dex * cey;
+		f64 dexaey = dex * aey;
+		f64 aexdey = aex * dey;
+		f64 aexcey = aex * cey;
+		f64 cexaey = cex * aey;
+		f64 bexdey = bex * dey;
+		f64 dexbey = dex * bey;
+
+		f64 ab = aexbey - bexaey;
+		f64 bc = bexcey - cexbey;
+		f64 cd = cexdey - dexcey;
+		f64 da = dexaey - aexdey;
+		f64 ac = aexcey - cexaey;
+		f64 bd = bexdey - dexbey;
+
+		f64 abc = aez * bc - bez * ac + cez * ab;
+		f64 bcd = bez * cd - cez * bd + dez * bc;
+		f64 cda = cez * da + dez * ac + aez * cd;
+		f64 dab = dez * ab + aez * bd + bez * da;
+
+		f64 aLift = aex * aex + aey * aey + aez * aez;
+		f64 bLift = bex * bex + bey * bey + bez * bez;
+		f64 cLift = cex * cex + cey * cey + cez * cez;
+		f64 dLift = dex * dex + dey * dey + dez * dez;
+
+		f64 determinant = ( dLift * abc - cLift * dab ) + ( bLift * cda - aLift * bcd );
+
+		f64 aezPlus = Math::Abs( aez );
+		f64 bezPlus = Math::Abs( bez );
+		f64 cezPlus = Math::Abs( cez );
+		f64 dezPlus = Math::Abs( dez );
+
+		f64 abPlus = Math::Abs( aexbey ) + Math::Abs( bexaey );
+		f64 bcPlus = Math::Abs( bexcey ) + Math::Abs( cexbey );
+		f64 cdPlus = Math::Abs( cexdey ) + Math::Abs( dexcey );
+		f64 daPlus = Math::Abs( dexaey ) + Math::Abs( aexdey );
+		f64 acPlus = Math::Abs( aexcey ) + Math::Abs( cexaey );
+		f64 bdPlus = Math::Abs( bexdey ) + Math::Abs( dexbey );
+
+		f64 permanent =
+			( cdPlus * bezPlus + bdPlus * cezPlus + bcPlus * dezPlus ) * aLift +
+			( daPlus * cezPlus + acPlus * dezPlus + cdPlus * aezPlus ) * bLift +
+			( abPlus * dezPlus + bdPlus * aezPlus + daPlus * bezPlus ) * cLift +
+			( bcPlus * aezPlus + acPlus * bezPlus + abPlus * cezPlus ) * dLift;
+
+		f64 bound = InSphereBound * permanent;
+		if( determinant > bound || -determinant > bound )
+		{
+			return determinant;
+		}
+
+		DoublePrecisionScope precision;
+
+		Expansion eAex = Difference( pA[ 0 ], pE[ 0 ] );
+		Expansion eBex = Difference( pB[ 0 ], pE[ 0 ] );
+		Expansion eCex = Difference( pC[ 0 ], pE[ 0 ] );
+		Expansion eDex = Difference( pD[ 0 ], pE[ 0 ] );
+		Expansion eAey = Difference( pA[ 1 ], pE[ 1 ] );
+		Expansion eBey = Difference( pB[ 1 ], pE[ 1 ] );
+		Expansion eCey = Difference( pC[ 1 ], pE[ 1 ] );
+		Expansion eDey = Difference( pD[ 1 ], pE[ 1 ] );
+		Expansion eAez = Difference( pA[ 2 ], pE[ 2 ] );
+		Expansion eBez = Difference( pB[ 2 ], pE[ 2 ] );
+		Expansion eCez = Difference( pC[ 2 ], pE[ 2 ] );
+		Expansion eDez = Difference( pD[ 2 ], pE[ 2 ] );
+
+		Expansion eAb = Minor( eAex, eBey, eBex, eAey );
+		Expansion eBc = Minor( eBex, eCey, eCex, eBey );
+		Expansion eCd = Minor( eCex, eDey, eDex, eCey );
+		Expansion eDa = Minor( eDex, eAey, eAex, eDey );
+		Expansion eAc = Minor( eAex, eCey, eCex, eAey );
+		Expansion eBd = Minor( eBex, eDey, eDex, eBey );
+
+		Expansion eAbc = Add( Minor( eAez, eBc, eBez, eAc ), Multiply( eCez, eAb ) );
+		Expansion eBcd = Add( Minor( eBez, eCd, eCez, eBd ), Multiply( eDez, eBc ) );
+		Expansion eCda = Add( Add( Multiply( eCez, eDa ), Multiply( eDez, eAc ) ), Multiply( eAez, eCd ) );
+		Expansion eDab = Add( Add( Multiply( eDez, eAb ), Multiply( eAez, eBd ) ), Multiply( eBez, eDa ) );
+
+		Expansion exact = Add(
+			Minor( Lift( eDex, eDey, eDez ), eAbc, Lift( eCex, eCey, eCez ), eDab ),
+			Minor( Lift( eBex, eBey, eBez ), eCda, Lift( eAex, eAey, eAez ), eBcd ) );
+
+		return exact.back();
+	}
+}
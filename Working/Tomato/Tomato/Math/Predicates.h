@@ -0,0 +1,45 @@
+#pragma once
+
+namespace Tomato
+{
+	// Orientation and in-circle / in-sphere tests with exact signs.
+	//
+	// Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates" (1997)
+	//
+	// Each robust predicate first evaluates the determinant in double precision together with an
+	// error bound. Only when the bound cannot decide the sign is the determinant recomputed with
+	// exact floating point expansions, so nearly every call costs no more than the plain formula.
+	// The returned value approximates the determinant; its sign is always correct, and zero means
+	// the points are exactly degenerate. The Fast variants skip the error bound and can return
+	// the wrong sign for nearly degenerate input.
+	class TOMATO_API Predicates
+	{
+	public:
+		// Positive if a, b and c are in counterclockwise order with Y up, negative if clockwise.
+		static f64 Orient2D( const Vector2& a, const Vector2& b, const Vector2& c );
+		static f64 Orient2DFast( const Vector2& a, const Vector2& b, const Vector2& c );
+
+		// Positive if d lies on the side of the plane through a, b and c that
+		// Cross( b - a, c - a ) points away from, negative on the side it points to.
+		static f64 Orient3D( const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d );
+		static f64 Orient3D( const Vector3d& a, const Vector3d& b, const Vector3d& c, const Vector3d& d );
+		static f64 Orient3DFast( const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d );
+
+		// Positive if d lies inside the circle through a, b and c, which must be in
+		// counterclockwise order; negative outside.
+		static f64 InCircle( const Vector2& a, const Vector2& b, const Vector2& c, const Vector2& d );
+		static f64 InCircleFast( const Vector2& a, const Vector2& b, const Vector2& c, const Vector2& d );
+
+		// Positive if e lies inside the sphere through a, b, c and d, which must have
+		// Orient3D( a, b, c, d ) > 0; negative outside.
+		static f64 InSphere( const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d, const Vector3& e );
+		static f64 InSphere( const Vector3d& a, const Vector3d& b, const Vector3d& c, const Vector3d& d, const Vector3d& e );
+		static f64 InSphereFast( const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d, const Vector3& e );
+
+	private:
+		static f64 Orient2D( f64 ax, f64 ay, f64 bx, f64 by, f64 cx, f64 cy );
+		static f64 Orient3D( const f64* pA, const f64* pB, const f64* pC, const f64* pD );
+		static f64 InCircle( f64 ax, f64 ay, f64 bx, f64 by, f64 cx, f64 cy, f64 dx, f64 dy );
+		static f64 InSphere( const f64* pA, const f64* pB, const f64* pC, const f64* pD, const f64* pE );
+	};
+}
@@ -0,0 +1,140 @@
+#include "TomatoPCH.h"
+
+#include "Quantization.h"
+
+namespace Tomato
+{
+	namespace
+	{
+		inline f64 GetMaxStep( u32 bits )
+		{
+			Assert( 1 <= bits && bits <= 32 );
+
+			return static_cast<f64>( 0xFFFFFFFF >> ( 32 - bits ) );
+		}
+
+		inline f32 SignNotZero( f32 value )
+		{
+			return ( value >= 0.0f ) ? 1.0f : -1.0f;
+		}
+
+		const f32 SmallestThreeRange = 0.70710678f;
+	}
+
+	u32 Quantization::Quantize( f32 value, f32 min, f32 max, u32 bits )
+	{
+		Assert( min < max );
+
+		f64 t = ( static_cast<f64>( value ) - min ) / ( static_cast<f64>( max ) - min );
+		if( !( t > 0.0 ) )
+		{
+			// Also catches NaN.
+			return 0;
+		}
+		if( t > 1.0 )
+		{
+			t = 1.0;
+		}
+
+		return static_cast<u32>( t * GetMaxStep( bits ) + 0.5 );
+	}
+
+	f32 Quantization::Dequantize( u32 quantized, f32 min, f32 max, u32 bits )
+	{
+		f64 t = quantized / GetMaxStep( bits );
+
+		return static_cast<f32>( min + ( static_cast<f64>( max ) - min ) * t );
+	}
+
+	void Quantization::QuantizeNormal( const Vector3& normal, u32 bits, u32& u, u32& v )
+	{
+		f32 l1 = Math::Abs( normal.X ) + Math::Abs( normal.Y ) + Math::Abs( normal.Z );
+		if( l1 <= 0.0f )
+		{
+			l1 = 1.0f;
+		}
+
+		f32 x = normal.X / l1;
+		f32 y = normal.Y / l1;
+
+		// Fold the lower half of the octahedron over the diagonals of the square.
+		if( normal.Z < 0.0f )
+		{
+			f32 foldedX = ( 1.0f - Math::Abs( y ) ) * SignNotZero( x );
+			f32 foldedY = ( 1.0f - Math::Abs( x ) ) * SignNotZero( y );
+
+			x = foldedX;
+			y = foldedY;
+		}
+
+		u = Quantize( x, -1.0f, 1.0f, bits );
+		v = Quantize( y, -1.0f, 1.0f, bits );
+	}
+
+	Vector3 Quantization::DequantizeNormal( u32 u, u32 v, u32 bits )
+	{
+		f32 x = Dequantize( u, -1.0f, 1.0f, bits );
+		f32 y = Dequantize( v, -1.0f, 1.0f, bits );
+		f32 z = 1.0f - Math::Abs( x ) - Math::Abs( y );
+
+		if( z < 0.0f )
+		{
+			f32 unfoldedX = ( 1.0f - Math::Abs( y ) ) * SignNotZero( x );
+			f32 unfoldedY = ( 1.0f - Math::Abs( x ) ) * SignNotZero( y );
+
+			x = unfoldedX;
+			y = unfoldedY;
+		}
+
+		return Vector3::Normalize( Vector3( x, y, z ) );
+	}
+
+	void Quantization::QuantizeQuaternion( const Quaternion& rotation, u32 bits, u32& largestIndex, u32* pComponents )
+	{
+		Assert( pComponents != NULL );
+
+		largestIndex = 0;
+		for( u32 i = 1; i < 4; ++i )
+		{
+			if( Math::Abs( rotation.V[ i ] ) > Math::Abs( rotation.V[ largestIndex ] ) )
+			{
+				largestIndex = i;
+			}
+		}
+
+		f32 sign = SignNotZero( rotation.V[ largestIndex ] );
+
+		for( u32 i = 0, j = 0; i < 4; ++i )
+		{
+			if( i != largestIndex )
+			{
+				pComponents[ j++ ] = Quantize( rotation.V[ i ] * sign, -SmallestThreeRange, SmallestThreeRange, bits );
+			}
+		}
+	}
+
+	Quaternion Quantization::DequantizeQuaternion( u32 largestIndex, const u32* pComponents, u32 bits )
+	{
+		Assert( largestIndex < 4 );
+		Assert( pComponents != NULL );
+
+		Quaternion rotation;
+
+		f32 sumSquared = 0.0f;
+		for( u32 i = 0, j = 0; i < 4; ++i )
+		{
+			if( i != largestIndex )
+			{
+				f32 component = Dequantize( pComponents[ j++ ], -SmallestThreeRange, SmallestThreeRange, bits );
+
+				rotation.V[ i ] = component;
+				sumSquared += component * component;
+			}
+		}
+
+		rotation.V[ largestIndex ] = ::sqrtf( Math::Max( 1.0f - sumSquared, 0.0f ) );
+		rotation.Normalize();
+
+		return rotation;
+	}
+}
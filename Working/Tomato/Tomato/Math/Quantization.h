@@ -0,0 +1,28 @@
+#pragma once
+
+namespace Tomato
+{
+	// Lossy packing of floats into a few bits for network and replay streams.
+	class TOMATO_API Quantization
+	{
+	public:
+		// Maps [min, max] onto the integers 0 .. 2^bits - 1, rounding to the nearest step.
+		// Values outside the range are clamped. bits is 1 to 32.
+		static u32 Quantize( f32 value, f32 min, f32 max, u32 bits );
+		static f32 Dequantize( u32 quantized, f32 min, f32 max, u32 bits );
+
+		// Unit vector as two bits-wide components of its octahedral projection: the sphere is mapped
+		// onto an octahedron and unfolded into a square, which spreads the error evenly over directions.
+		static void QuantizeNormal( const Vector3& normal, u32 bits, u32& u, u32& v );
+		static Vector3 DequantizeNormal( u32 u, u32 v, u32 bits );
+
+		// Unit quaternion as "smallest three": the index of the component with the largest magnitude
+		// and the other three, which lie within +-1/sqrt(2), at bits each. The sign is chosen so that
+		// the dropped component is positive; q and -q are the same rotation.
+		static void QuantizeQuaternion( const Quaternion& rotation, u32 bits, u32& largestIndex, u32* pComponents );
+		static Quaternion DequantizeQuaternion( u32 largestIndex, const u32* pComponents, u32 bits );
+
+	private:
+		Quantization();
+	};
+}
@@ -0,0 +1,450 @@
+#include "TomatoPCH.h"
+
+#include "SphericalHarmonics.h"
+
+#include <emmintrin.h>
+
+namespace Tomato
+{
+	namespace
+	{
+		const f32 Band0 = 0.282094792f;
+		const f32 Band1 = 0.488602512f;
+		const f32 Band2XY = 1.092548431f;
+		const f32 Band2Z = 0.315391565f;
+		const f32 Band2XX = 0.546274215f;
+
+		void EvaluateBasis( s32 order, f32 x, f32 y, f32 z, f32* pBasis )
+		{
+			pBasis[ 0 ] = Band0;
+
+			if( order > 1 )
+			{
+				pBasis[ 1 ] = Band1 * y;
+				pBasis[ 2 ] = Band1 * z;
+				pBasis[ 3 ] = Band1 * x;
+			}
+
+			if( order > 2 )
+			{
+				pBasis[ 4 ] = Band2XY * x * y;
+				pBasis[ 5 ] = Band2XY * y * z;
+				pBasis[ 6 ] = Band2Z * ( 3.0f * z * z - 1.0f );
+				pBasis[ 7 ] = Band2XY * x * z;
+				pBasis[ 8 ] = Band2XX * ( x * x - y * y );
+			}
+		}
+
+		// EvaluateBasis for four directions, one per lane.
+		void EvaluateBasis( s32 order, __m128 x, __m128 y, __m128 z, __m128* pBasis )
+		{
+			pBasis[ 0 ] = _mm_set1_ps( Band0 );
+
+			if( order > 1 )
+			{
+				__m128 band1 = _mm_set1_ps( Band1 );
+				pBasis[ 1 ] = _mm_mul_ps( band1, y );
+				pBasis[ 2 ] = _mm_mul_ps( band1, z );
+				pBasis[ 3 ] = _mm_mul_ps( band1, x );
+			}
+
+			if( order > 2 )
+			{
+				__m128 band2XY = _mm_set1_ps( Band2XY );
+				__m128 zz = _mm_mul_ps( z, z );
+
+				pBasis[ 4 ] = _mm_mul_ps( band2XY, _mm_mul_ps( x, y ) );
+				pBasis[ 5 ] = _mm_mul_ps( band2XY, _mm_mul_ps( y, z ) );
+				pBasis[ 6 ] = _mm_mul_ps( _mm_set1_ps( Band2Z ), _mm_sub_ps( _mm_add_ps( zz, _mm_add_ps( zz, zz ) ), _mm_set1_ps( 1.0f ) ) );
+				pBasis[ 7 ] = _mm_mul_ps( band2XY, _mm_mul_ps( x, z ) );
+				pBasis[ 8 ] = _mm_mul_ps( _mm_set1_ps( Band2XX ), _mm_sub_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ) );
+			}
+		}
+
+		f32 HorizontalSum( __m128 v )
+		{
+			__m128 pairs = _mm_add_ps( v, _mm_movehl_ps( v, v ) );
+			return _mm_cvtss_f32( _mm_add_ss( pairs, _mm_shuffle_ps( pairs, pairs, _MM_SHUFFLE( 1, 1, 1, 1 ) ) ) );
+		}
+
+		// Weighted sum of the basis over up to four directions per call, one accumulator per coefficient and channel.
+		class Projector
+		{
+		public:
+			explicit Projector( s32 order )
+				: m_order( order )
+			{
+				for( s32 i = 0; i < order * order; ++i )
+				{
+					m_red[ i ] = _mm_setzero_ps();
+					m_green[ i ] = _mm_setzero_ps();
+					m_blue[ i ] = _mm_setzero_ps();
+				}
+			}
+
+			// Lanes with a weight of 0 add nothing.
+			void Add( __m128 x, __m128 y, __m128 z, __m128 red, __m128 green, __m128 blue, __m128 weight )
+			{
+				__m128 basis[ SphericalHarmonics::MaxCoefficientCount ];
+				EvaluateBasis( m_order, x, y, z, basis );
+
+				red = _mm_mul_ps( red, weight );
+				green = _mm_mul_ps( green, weight );
+				blue = _mm_mul_ps( blue, weight );
+
+				for( s32 i = 0; i < m_order * m_order; ++i )
+				{
+					m_red[ i ] = _mm_add_ps( m_red[ i ], _mm_mul_ps( basis[ i ], red ) );
+					m_green[ i ] = _mm_add_ps( m_green[ i ], _mm_mul_ps( basis[ i ], green ) );
+					m_blue[ i ] = _mm_add_ps( m_blue[ i ], _mm_mul_ps( basis[ i ], blue ) );
+				}
+			}
+
+			void Accumulate( SphericalHarmonics& sh, f32 scale ) const
+			{
+				for( s32 i = 0; i < m_order * m_order; ++i )
+				{
+					sh.Coefficients[ i ] += Vector3( HorizontalSum( m_red[ i ] ), HorizontalSum( m_green[ i ] ), HorizontalSum( m_blue[ i ] ) ) * scale;
+				}
+			}
+
+		private:
+			s32 m_order;
+
+			__m128 m_red[ SphericalHarmonics::MaxCoefficientCount ];
+			__m128 m_green[ SphericalHarmonics::MaxCoefficientCount ];
+			__m128 m_blue[ SphericalHarmonics::MaxCoefficientCount ];
+		};
+
+		// Direction of texel coordinates ( u, v ) in [ -1, 1 ] on a D3D cube map face.
+		void GetCubeDirection( s32 face, __m128 u, __m128 v, __m128& x, __m128& y, __m128& z )
+		{
+			__m128 one = _mm_set1_ps( 1.0f );
+			__m128 negativeU = _mm_sub_ps( _mm_setzero_ps(), u );
+			__m128 negativeV = _mm_sub_ps( _mm_setzero_ps(), v );
+
+			switch( face )
+			{
+			case 0: x = one; y = negativeV; z = negativeU; break;
+			case 1: x = _mm_sub_ps( _mm_setzero_ps(), one ); y = negativeV; z = u; break;
+			case 2: x = u; y = one; z = v; break;
+			case 3: x = u; y = _mm_sub_ps( _mm_setzero_ps(), one ); z = negativeV; break;
+			case 4: x = u; y = negativeV; z = one; break;
+			default: x = negativeU; y = negativeV; z = _mm_sub_ps( _mm_setzero_ps(), one ); break;
+			}
+		}
+	}
+
+	SphericalHarmonics::SphericalHarmonics( s32 order )
+		: m_order( order )
+	{
+		Assert( order == 2 || order == 3 );
+
+		SetZero();
+	}
+
+	SphericalHarmonics::~SphericalHarmonics()
+	{
+	}
+
+	void SphericalHarmonics::SetZero()
+	{
+		for( s32 i = 0; i < MaxCoefficientCount; ++i )
+		{
+			Coefficients[ i ].Set( 0.0f, 0.0f, 0.0f );
+		}
+	}
+
+	SphericalHarmonics& SphericalHarmonics::operator += ( const SphericalHarmonics& sh )
+	{
+		Assert( sh.m_order == m_order );
+
+		for( s32 i = 0; i < GetCoefficientCount(); ++i )
+		{
+			Coefficients[ i ] += sh.Coefficients[ i ];
+		}
+
+		return *this;
+	}
+
+	SphericalHarmonics& SphericalHarmonics::operator *= ( f32 scalar )
+	{
+		for( s32 i = 0; i < GetCoefficientCount(); ++i )
+		{
+			Coefficients[ i ] *= scalar;
+		}
+
+		return *this;
+	}
+
+	SphericalHarmonics SphericalHarmonics::Lerp( const SphericalHarmonics& sh1, const SphericalHarmonics& sh2, f32 amount )
+	{
+		Assert( sh1.m_order == sh2.m_order );
+
+		SphericalHarmonics result( sh1.m_order );
+
+		for( s32 i = 0; i < result.GetCoefficientCount(); ++i )
+		{
+			result.Coefficients[ i ] = sh1.Coefficients[ i ] + ( sh2.Coefficients[ i ] - sh1.Coefficients[ i ] ) * amount;
+		}
+
+		return result;
+	}
+
+	void SphericalHarmonics::AddDirectionalLight( const Vector3& direction, const Vector3& color )
+	{
+		Vector3 unit = Vector3::Normalize( direction );
+
+		f32 basis[ MaxCoefficientCount ];
+		EvaluateBasis( m_order, unit.X, unit.Y, unit.Z, basis );
+
+		for( s32 i = 0; i < GetCoefficientCount(); ++i )
+		{
+			Coefficients[ i ] += color * basis[ i ];
+		}
+	}
+
+	void SphericalHarmonics::AddSamples( const Vector3* pDirections, const Vector3* pColors, const f32* pWeights, s32 count )
+	{
+		Assert( count == 0 || ( pDirections != NULL && pColors != NULL ) );
+
+		Projector projector( m_order );
+
+		for( s32 i = 0; i < count; i += 4 )
+		{
+			__declspec( align( 16 ) ) f32 lanes[ 7 ][ 4 ];
+
+			for( s32 lane = 0; lane < 4; ++lane )
+			{
+				bool bValid = ( i + lane < count );
+				s32 index = bValid ? i + lane : i;
+
+				lanes[ 0 ][ lane ] = pDirections[ index ].X;
+				lanes[ 1 ][ lane ] = pDirections[ index ].Y;
+				lanes[ 2 ][ lane ] = pDirections[ index ].Z;
+				lanes[ 3 ][ lane ] = pColors[ index ].X;
+				lanes[ 4 ][ lane ] = pColors[ index ].Y;
+				lanes[ 5 ][ lane ] = pColors[ index ].Z;
+				lanes[ 6 ][ lane ] = bValid ? ( ( pWeights != NULL ) ? pWeights[ index ] : 1.0f ) : 0.0f;
+			}
+
+			projector.Add(
+				_mm_load_ps( lanes[ 0 ] ), _mm_load_ps( lanes[ 1 ] ), _mm_load_ps( lanes[ 2 ] ),
+				_mm_load_ps( lanes[ 3 ] ), _mm_load_ps( lanes[ 4 ] ), _mm_load_ps( lanes[ 5 ] ),
+				_mm_load_ps( lanes[ 6 ] ) );
+		}
+
+		projector.Accumulate( *this, 1.0f );
+	}
+
+	void SphericalHarmonics::ProjectCubeMap( const Vector3* const* ppFaces, s32 size )
+	{
+		Assert( ppFaces != NULL );
+		Assert( size > 0 );
+
+		SetZero();
+
+		Projector projector( m_order );
+
+		f32 texelSize = 2.0f / size;
+		f32 totalWeight = 0.0f;
+
+		__m128 one = _mm_set1_ps( 1.0f );
+
+		for( s32 face = 0; face < 6; ++face )
+		{
+			const Vector3* pFace = ppFaces[ face ];
+			Assert( pFace != NULL );
+
+			for( s32 row = 0; row < size; ++row )
+			{
+				__m128 v = _mm_set1_ps( ( row + 0.5f ) * texelSize - 1.0f );
+
+				for( s32 column = 0; column < size; column += 4 )
+				{
+					__declspec( align( 16 ) ) f32 lanes[ 3 ][ 4 ];
+					__declspec( align( 16 ) ) f32 valid[ 4 ];
+
+					for( s32 lane = 0; lane < 4; ++lane )
+					{
+						const Vector3& texel = pFace[ row * size + Math::Min( column + lane, size - 1 ) ];
+
+						lanes[ 0 ][ lane ] = texel.X;
+						lanes[ 1 ][ lane ] = texel.Y;
+						lanes[ 2 ][ lane ] = texel.Z;
+						valid[ lane ] = ( column + lane < size ) ? 1.0f : 0.0f;
+					}
+
+					__m128 u = _mm_sub_ps( _mm_mul_ps( _mm_add_ps( _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f ), _mm_set1_ps( static_cast<f32>( column ) ) ), _mm_set1_ps( texelSize ) ), one );
+
+					__m128 x, y, z;
+					GetCubeDirection( face, u, v, x, y, z );
+
+					// Solid angle of the texel is proportional to ( 1 + u^2 + v^2 )^( -3 / 2 ).
+					__m128 lengthSquared = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) );
+					__m128 inverseLength = _mm_div_ps( one, _mm_sqrt_ps( lengthSquared ) );
+					__m128 weight = _mm_mul_ps( _mm_mul_ps( inverseLength, _mm_mul_ps( inverseLength, inverseLength ) ), _mm_load_ps( valid ) );
+
+					projector.Add(
+						_mm_mul_ps( x, inverseLength ), _mm_mul_ps( y, inverseLength ), _mm_mul_ps( z, inverseLength ),
+						_mm_load_ps( lanes[ 0 ] ), _mm_load_ps( lanes[ 1 ] ), _mm_load_ps( lanes[ 2 ] ),
+						weight );
+
+					totalWeight += HorizontalSum( weight );
+				}
+			}
+		}
+
+		// The weights sum to the area of the sphere.
+		projector.Accumulate( *this, 4.0f * Math::PI / totalWeight );
+	}
+
+	void SphericalHarmonics::Convolve( const f32* pBandWeights )
+	{
+		Assert( pBandWeights != NULL );
+
+		for( s32 band = 0; band < m_order; ++band )
+		{
+			for( s32 i = band * band; i < ( band + 1 ) * ( band + 1 ); ++i )
+			{
+				Coefficients[ i ] *= pBandWeights[ band ];
+			}
+		}
+	}
+
+	// Ramamoorthi and Hanrahan, "An Efficient Representation for Irradiance Environment Maps" (2001)
+	void SphericalHarmonics::ConvolveCosine()
+	{
+		const f32 bandWeights[ MaxOrder ] = { Math::PI, Math::PI * 2.0f / 3.0f, Math::PI * 0.25f };
+
+		Convolve( bandWeights );
+	}
+
+	void SphericalHarmonics::Rotate( const Matrix4& rotation )
+	{
+		const f32 ( *m )[ 4 ] = rotation.M;
+
+		// Band 1 is a vector ( x, y, z ) = ( c3, c1, c2 ) and rotates like one.
+		if( m_order > 1 )
+		{
+			for( s32 channel = 0; channel < 3; ++channel )
+			{
+				f32 x = Coefficients[ 3 ][ channel ];
+				f32 y = Coefficients[ 1 ][ channel ];
+				f32 z = Coefficients[ 2 ][ channel ];
+
+				Coefficients[ 3 ][ channel ] = x * m[ 0 ][ 0 ] + y * m[ 1 ][ 0 ] + z * m[ 2 ][ 0 ];
+				Coefficients[ 1 ][ channel ] = x * m[ 0 ][ 1 ] + y * m[ 1 ][ 1 ] + z * m[ 2 ][ 1 ];
+				Coefficients[ 2 ][ channel ] = x * m[ 0 ][ 2 ] + y * m[ 1 ][ 2 ] + z * m[ 2 ][ 2 ];
+			}
+		}
+
+		// Band 2 is evaluated at five fixed directions turned back by the rotation, and the rotated
+		// coefficients are solved from those values with the inverse basis matrix of the directions
+		// ( 1, 0, 0 ), ( 0, 0, 1 ), ( k, k, 0 ), ( k, 0, k ), ( 0, k, k ), k = 1 / sqrt( 2 ).
+		if( m_order > 2 )
+		{
+			const f32 k = 0.707106781f;
+			const Vector3 directions[ 5 ] =
+			{
+				Vector3( 1.0f, 0.0f, 0.0f ),
+				Vector3( 0.0f, 0.0f, 1.0f ),
+				Vector3( k, k, 0.0f ),
+				Vector3( k, 0.0f, k ),
+				Vector3( 0.0f, k, k ),
+			};
+
+			Vector3 values[ 5 ];
+
+			for( s32 i = 0; i < 5; ++i )
+			{
+				// Inverse rotation, as the transpose of the 3x3 part.
+				const Vector3& d = directions[ i ];
+				Vector3 turned(
+					d.X * m[ 0 ][ 0 ] + d.Y * m[ 0 ][ 1 ] + d.Z * m[ 0 ][ 2 ],
+					d.X * m[ 1 ][ 0 ] + d.Y * m[ 1 ][ 1 ] + d.Z * m[ 1 ][ 2 ],
+					d.X * m[ 2 ][ 0 ] + d.Y * m[ 2 ][ 1 ] + d.Z * m[ 2 ][ 2 ] );
+
+				f32 basis[ MaxCoefficientCount ];
+				EvaluateBasis( 3, turned.X, turned.Y, turned.Z, basis );
+
+				values[ i ].Set( 0.0f, 0.0f, 0.0f );
+				for( s32 j = 4; j < 9; ++j )
+				{
+					values[ i ] += Coefficients[ j ] * basis[ j ];
+				}
+			}
+
+			const f32 a = 0.915291233f;
+			const f32 b = 1.830582466f;
+			const f32 c = 1.585330919f;
+
+			Coefficients[ 4 ] = values[ 1 ] * a + values[ 2 ] * b;
+			Coefficients[ 5 ] = values[ 0 ] * a + values[ 4 ] * b;
+			Coefficients[ 6 ] = values[ 1 ] * c;
+			Coefficients[ 7 ] = values[ 3 ] * b - ( values[ 0 ] + values[ 1 ] ) * a;
+			Coefficients[ 8 ] = values[ 0 ] * b + values[ 1 ] * a;
+		}
+	}
+
+	void SphericalHarmonics::Rotate( const Quaternion& rotation )
+	{
+		Rotate( Matrix4::CreateFromQuaternion( rotation ) );
+	}
+
+	Vector3 SphericalHarmonics::Evaluate( const Vector3& direction ) const
+	{
+		f32 basis[ MaxCoefficientCount ];
+		EvaluateBasis( m_order, direction.X, direction.Y, direction.Z, basis );
+
+		Vector3 result( 0.0f, 0.0f, 0.0f );
+		for( s32 i = 0; i < GetCoefficientCount(); ++i )
+		{
+			result += Coefficients[ i ] * basis[ i ];
+		}
+
+		return result;
+	}
+
+	void SphericalHarmonics::Evaluate( const Vector3* pDirections, s32 count, Vector3* pResults ) const
+	{
+		Assert( count == 0 || ( pDirections != NULL && pResults != NULL ) );
+
+		for( s32 i = 0; i < count; i += 4 )
+		{
+			__declspec( align( 16 ) ) f32 lanes[ 3 ][ 4 ];
+
+			for( s32 lane = 0; lane < 4; ++lane )
+			{
+				const Vector3& direction = pDirections[ Math::Min( i + lane, count - 1 ) ];
+
+				lanes[ 0 ][ lane ] = direction.X;
+				lanes[ 1 ][ lane ] = direction.Y;
+				lanes[ 2 ][ lane ] = direction.Z;
+			}
+
+			__m128 basis[ MaxCoefficientCount ];
+			EvaluateBasis( m_order, _mm_load_ps( lanes[ 0 ] ), _mm_load_ps( lanes[ 1 ] ), _mm_load_ps( lanes[ 2 ] ), basis );
+
+			__m128 red = _mm_setzero_ps();
+			__m128 green = _mm_setzero_ps();
+			__m128 blue = _mm_setzero_ps();
+
+			for( s32 j = 0; j < GetCoefficientCount(); ++j )
+			{
+				red = _mm_add_ps( red, _mm_mul_ps( basis[ j ], _mm_set1_ps( Coefficients[ j ].X ) ) );
+				green = _mm_add_ps( green, _mm_mul_ps( basis[ j ], _mm_set1_ps( Coefficients[ j ].Y ) ) );
+				blue = _mm_add_ps( blue, _mm_mul_ps( basis[ j ], _mm_set1_ps( Coefficients[ j ].Z ) ) );
+			}
+
+			_mm_store_ps( lanes[ 0 ], red );
+			_mm_store_ps( lanes[ 1 ], green );
+			_mm_store_ps( lanes[ 2 ], blue );
+
+			for( s32 lane = 0; lane < 4 && i + lane < count; ++lane )
+			{
+				pResults[ i + lane ].Set( lanes[ 0 ][ lane ], lanes[ 1 ][ lane ], lanes[ 2 ][ lane ] );
+			}
+		}
+	}
+}
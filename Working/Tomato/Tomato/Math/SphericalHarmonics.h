@@ -0,0 +1,63 @@
+#pragma once
+
+namespace Tomato
+{
+	// RGB function on the sphere as real spherical harmonics of order 2 ( 4 coefficients, bands 0
+	// and 1 ) or order 3 ( 9 coefficients, bands 0 to 2 ).
+	//
+	// Coefficient l * ( l + 1 ) + m belongs to band l, index m in [ -l, l ]. Projection and
+	// evaluation of many directions run four directions per SSE instruction.
+	class TOMATO_API SphericalHarmonics
+	{
+	public:
+		enum
+		{
+			MaxOrder = 3,
+			MaxCoefficientCount = MaxOrder * MaxOrder,
+		};
+
+		explicit SphericalHarmonics( s32 order = MaxOrder );
+		~SphericalHarmonics();
+
+	public:
+		s32 GetOrder() const { return m_order; }
+		s32 GetCoefficientCount() const { return m_order * m_order; }
+
+		void SetZero();
+
+		SphericalHarmonics& operator += ( const SphericalHarmonics& sh );
+		SphericalHarmonics& operator *= ( f32 scalar );
+
+		static SphericalHarmonics Lerp( const SphericalHarmonics& sh1, const SphericalHarmonics& sh2, f32 amount );
+
+		// Adds light arriving from a single direction.
+		void AddDirectionalLight( const Vector3& direction, const Vector3& color );
+
+		// Adds color * weight for every unit direction; pWeights may be NULL for weights of 1.
+		void AddSamples( const Vector3* pDirections, const Vector3* pColors, const f32* pWeights, s32 count );
+
+		// Replaces the coefficients with the projection of a cube map. ppFaces holds the D3D faces
+		// +X, -X, +Y, -Y, +Z, -Z, each size * size texels row by row.
+		void ProjectCubeMap( const Vector3* const* ppFaces, s32 size );
+
+		// Multiplies band l by pBandWeights[ l ].
+		void Convolve( const f32* pBandWeights );
+
+		// Turns radiance into irradiance by convolving with the clamped cosine lobe.
+		// Divide by PI afterwards for the exit radiance of a white Lambertian surface.
+		void ConvolveCosine();
+
+		// Rotates the function by a rotation matrix in the row-vector convention of Matrix4.
+		void Rotate( const Matrix4& rotation );
+		void Rotate( const Quaternion& rotation );
+
+		Vector3 Evaluate( const Vector3& direction ) const;
+		void Evaluate( const Vector3* pDirections, s32 count, Vector3* pResults ) const;
+
+	public:
+		Vector3 Coefficients[ MaxCoefficientCount ];
+
+	private:
+		s32 m_order;
+	};
+}
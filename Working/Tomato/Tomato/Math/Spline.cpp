@@ -0,0 +1,330 @@
+#include "TomatoPCH.h"
+
+#include "Spline.h"
+
+#include <cmath>
+
+namespace Tomato
+{
+	Spline::Spline()
+		: m_points()
+		, m_segments()
+		, m_bClosed( false )
+		, m_samplesPerSegment( DefaultSamplesPerSegment )
+		, m_distances()
+	{
+	}
+
+	Spline::~Spline()
+	{
+	}
+
+	void Spline::SetControlPoints( const Vector3* pPoints, s32 count, bool bClosed, s32 samplesPerSegment )
+	{
+		Assert( pPoints != NULL );
+		Assert( count >= 2 );
+		Assert( samplesPerSegment > 0 );
+
+		m_points.assign( pPoints, pPoints + count );
+		m_bClosed = bClosed;
+		m_samplesPerSegment = samplesPerSegment;
+
+		s32 segmentCount = bClosed ? count : count - 1;
+		m_segments.resize( segmentCount );
+
+		for( s32 i = 0; i < segmentCount; ++i )
+		{
+			Vector3 p1 = m_points[ i ];
+			Vector3 p2 = m_points[ ( i + 1 ) % count ];
+			Vector3 p0;
+			Vector3 p3;
+
+			// Open ends are extrapolated so the path leaves its end points along the first and last chords.
+			if( bClosed )
+			{
+				p0 = m_points[ ( i + count - 1 ) % count ];
+				p3 = m_points[ ( i + 2 ) % count ];
+			}
+			else
+			{
+				p0 = ( i > 0 ) ? m_points[ i - 1 ] : p1 * 2.0f - p2;
+				p3 = ( i + 2 < count ) ? m_points[ i + 2 ] : p2 * 2.0f - p1;
+			}
+
+			Segment& segment = m_segments[ i ];
+			segment.A = p1;
+			segment.B = ( p2 - p0 ) * 0.5f;
+			segment.C = ( p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3 ) * 0.5f;
+			segment.D = ( p1 * 3.0f - p0 - p2 * 3.0f + p3 ) * 0.5f;
+		}
+
+		// Three point Gauss-Legendre quadrature of |P'( t )| over every table interval.
+		static const f32 s_nodes[ 3 ] = { -0.774596669f, 0.0f, 0.774596669f };
+		static const f32 s_weights[ 3 ] = { 0.555555556f, 0.888888889f, 0.555555556f };
+
+		s32 sampleCount = segmentCount * samplesPerSegment;
+		f32 step = 1.0f / samplesPerSegment;
+
+		m_distances.resize( sampleCount + 1 );
+		m_distances[ 0 ] = 0.0f;
+
+		for( s32 i = 0; i < sampleCount; ++i )
+		{
+			f32 center = ( i + 0.5f ) * step;
+			f32 length = 0.0f;
+
+			for( s32 j = 0; j < 3; ++j )
+			{
+				length += s_weights[ j ] * EvaluateDerivative( center + s_nodes[ j ] * step * 0.5f ).GetLength();
+			}
+
+			m_distances[ i + 1 ] = m_distances[ i ] + length * step * 0.5f;
+		}
+	}
+
+	const Vector3& Spline::GetControlPoint( s32 index ) const
+	{
+		Assert( index >= 0 );
+		Assert( index < GetControlPointCount() );
+
+		return m_points[ index ];
+	}
+
+	f32 Spline::GetLength() const
+	{
+		return m_distances.empty() ? 0.0f : m_distances.back();
+	}
+
+	void Spline::SplitParameter( f32 parameter, s32& segment, f32& t ) const
+	{
+		Assert( !m_segments.empty() );
+
+		s32 segmentCount = GetSegmentCount();
+
+		if( m_bClosed )
+		{
+			parameter = fmodf( parameter, static_cast<f32>( segmentCount ) );
+			if( parameter < 0.0f )
+			{
+				parameter += segmentCount;
+			}
+		}
+		else
+		{
+			parameter = Math::Max( 0.0f, Math::Min( parameter, static_cast<f32>( segmentCount ) ) );
+		}
+
+		segment = Math::Min( static_cast<s32>( parameter ), segmentCount - 1 );
+		t = parameter - segment;
+	}
+
+	Vector3 Spline::Evaluate( f32 parameter ) const
+	{
+		s32 index;
+		f32 t;
+		SplitParameter( parameter, index, t );
+
+		const Segment& segment = m_segments[ index ];
+		return segment.A + ( segment.B + ( segment.C + segment.D * t ) * t ) * t;
+	}
+
+	Vector3 Spline::EvaluateDerivative( f32 parameter ) const
+	{
+		s32 index;
+		f32 t;
+		SplitParameter( parameter, index, t );
+
+		const Segment& segment = m_segments[ index ];
+		return segment.B + ( segment.C * 2.0f + segment.D * ( 3.0f * t ) ) * t;
+	}
+
+	f32 Spline::WrapDistance( f32 distance ) const
+	{
+		f32 length = GetLength();
+
+		if( m_bClosed && length > 0.0f )
+		{
+			distance = fmodf( distance, length );
+			return ( distance < 0.0f ) ? distance + length : distance;
+		}
+
+		return Math::Max( 0.0f, Math::Min( distance, length ) );
+	}
+
+	// hint is the table interval of the previous lookup; walking forward from it makes sorted queries linear.
+	f32 Spline::ParameterAtDistance( f32 distance, s32& hint ) const
+	{
+		Assert( !m_distances.empty() );
+
+		distance = WrapDistance( distance );
+
+		s32 last = static_cast<s32>( m_distances.size() ) - 2;
+		s32 index = Math::Max( 0, Math::Min( hint, last ) );
+
+		if( m_distances[ index ] <= distance )
+		{
+			s32 steps = 0;
+			while( index < last && m_distances[ index + 1 ] < distance && steps < 8 )
+			{
+				++index;
+				++steps;
+			}
+		}
+
+		if( m_distances[ index ] > distance || ( index < last && m_distances[ index + 1 ] < distance ) )
+		{
+			s32 low = 0;
+			s32 high = last;
+
+			while( low < high )
+			{
+				s32 middle = ( low + high + 1 ) / 2;
+
+				if( m_distances[ middle ] <= distance )
+				{
+					low = middle;
+				}
+				else
+				{
+					high = middle - 1;
+				}
+			}
+
+			index = low;
+		}
+
+		hint = index;
+
+		f32 span = m_distances[ index + 1 ] - m_distances[ index ];
+		f32 fraction = ( span > 0.0f ) ? ( distance - m_distances[ index ] ) / span : 0.0f;
+
+		return ( index + Math::Min( fraction, 1.0f ) ) / m_samplesPerSegment;
+	}
+
+	f32 Spline::GetParameterAtDistance( f32 distance ) const
+	{
+		s32 hint = 0;
+		return ParameterAtDistance( distance, hint );
+	}
+
+	f32 Spline::GetDistanceAtParameter( f32 parameter ) const
+	{
+		s32 segment;
+		f32 t;
+		SplitParameter( parameter, segment, t );
+
+		f32 sample = ( segment + t ) * m_samplesPerSegment;
+		s32 index = Math::Min( static_cast<s32>( sample ), static_cast<s32>( m_distances.size() ) - 2 );
+
+		return Math::Lerp( m_distances[ index ], m_distances[ index + 1 ], sample - index );
+	}
+
+	Vector3 Spline::GetPositionAtDistance( f32 distance ) const
+	{
+		return Evaluate( GetParameterAtDistance( distance ) );
+	}
+
+	Vector3 Spline::GetTangentAtDistance( f32 distance ) const
+	{
+		return Vector3::Normalize( EvaluateDerivative( GetParameterAtDistance( distance ) ) );
+	}
+
+	void Spline::GetPositionsAtDistances( const f32* pDistances, s32 count, Vector3* pPositions ) const
+	{
+		Assert( count == 0 || pDistances != NULL );
+		Assert( count == 0 || pPositions != NULL );
+
+		s32 hint = 0;
+
+		for( s32 i = 0; i < count; ++i )
+		{
+			pPositions[ i ] = Evaluate( ParameterAtDistance( pDistances[ i ], hint ) );
+		}
+	}
+
+	void Spline::Sample( s32 count, Vector3* pPositions ) const
+	{
+		Assert( count >= 2 );
+		Assert( pPositions != NULL );
+
+		f32 step = GetLength() / ( count - 1 );
+		s32 hint = 0;
+
+		for( s32 i = 0; i < count - 1; ++i )
+		{
+			pPositions[ i ] = Evaluate( ParameterAtDistance( step * i, hint ) );
+		}
+
+		// Taken directly; a closed path would wrap the full length back to its start anyway.
+		pPositions[ count - 1 ] = m_bClosed ? m_points.front() : m_points.back();
+	}
+
+	f32 Spline::FindClosestDistance( const Vector3& point ) const
+	{
+		Assert( !m_segments.empty() );
+
+		// Closest table interval of the polyline through the samples...
+		s32 sampleCount = static_cast<s32>( m_distances.size() ) - 1;
+		f32 step = 1.0f / m_samplesPerSegment;
+
+		f32 bestParameter = 0.0f;
+		f32 bestDistanceSquared = Math::FloatPositiveMax;
+
+		Vector3 previous = Evaluate( 0.0f );
+
+		for( s32 i = 0; i < sampleCount; ++i )
+		{
+			Vector3 next = Evaluate( ( i + 1 ) * step );
+			Vector3 chord = next - previous;
+
+			f32 chordLengthSquared = chord.GetLengthSquared();
+			f32 fraction = ( chordLengthSquared > 0.0f ) ? Vector3::Dot( point - previous, chord ) / chordLengthSquared : 0.0f;
+			fraction = Math::Max( 0.0f, Math::Min( fraction, 1.0f ) );
+
+			f32 distanceSquared = Vector3::GetDistanceSquared( point, previous + chord * fraction );
+			if( distanceSquared < bestDistanceSquared )
+			{
+				bestDistanceSquared = distanceSquared;
+				bestParameter = ( i + fraction ) * step;
+			}
+
+			previous = next;
+		}
+
+		// ...then a few Newton steps on d/dt |P( t ) - point|^2 / 2 = ( P - point ) . P'.
+		f32 minParameter = Math::Max( 0.0f, bestParameter - step );
+		f32 maxParameter = Math::Min( static_cast<f32>( GetSegmentCount() ), bestParameter + step );
+
+		f32 parameter = bestParameter;
+
+		for( s32 iteration = 0; iteration < 4; ++iteration )
+		{
+			s32 index;
+			f32 t;
+			SplitParameter( parameter, index, t );
+
+			const Segment& segment = m_segments[ index ];
+
+			Vector3 offset = Evaluate( parameter ) - point;
+			Vector3 first = segment.B + ( segment.C * 2.0f + segment.D * ( 3.0f * t ) ) * t;
+			Vector3 second = segment.C * 2.0f + segment.D * ( 6.0f * t );
+
+			f32 numerator = Vector3::Dot( offset, first );
+			f32 denominator = Vector3::Dot( first, first ) + Vector3::Dot( offset, second );
+
+			if( denominator <= 0.0f )
+			{
+				break;
+			}
+
+			parameter = Math::Max( minParameter, Math::Min( parameter - numerator / denominator, maxParameter ) );
+		}
+
+		if( Vector3::GetDistanceSquared( Evaluate( parameter ), point ) > bestDistanceSquared )
+		{
+			parameter = bestParameter;
+		}
+
+		return GetDistanceAtParameter( parameter );
+	}
+}
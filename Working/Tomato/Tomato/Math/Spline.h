@@ -0,0 +1,72 @@
+#pragma once
+
+namespace Tomato
+{
+	// Catmull-Rom path through a list of control points, parameterized by arc length.
+	//
+	// SetControlPoints prebuilds an arc length table, so positions can be requested by
+	// distance travelled along the path and followers move at constant speed without any
+	// per-frame resampling. Segment parameters run from 0 to GetSegmentCount().
+	class TOMATO_API Spline
+	{
+	public:
+		enum { DefaultSamplesPerSegment = 16 };
+
+		Spline();
+		~Spline();
+
+	public:
+		// A closed spline also connects the last control point back to the first.
+		void SetControlPoints( const Vector3* pPoints, s32 count, bool bClosed = false, s32 samplesPerSegment = DefaultSamplesPerSegment );
+
+		s32 GetControlPointCount() const { return static_cast<s32>( m_points.size() ); }
+		const Vector3& GetControlPoint( s32 index ) const;
+
+		bool IsClosed() const { return m_bClosed; }
+		s32 GetSegmentCount() const { return static_cast<s32>( m_segments.size() ); }
+		f32 GetLength() const;
+
+		// Evaluation by segment parameter.
+		Vector3 Evaluate( f32 parameter ) const;
+		Vector3 EvaluateDerivative( f32 parameter ) const;
+
+		// Evaluation by distance along the path; distances are clamped, or wrapped for a closed spline.
+		f32 GetParameterAtDistance( f32 distance ) const;
+		f32 GetDistanceAtParameter( f32 parameter ) const;
+		Vector3 GetPositionAtDistance( f32 distance ) const;
+		Vector3 GetTangentAtDistance( f32 distance ) const;
+
+		// Positions of many followers at once. Lookups are cheapest when pDistances is sorted.
+		void GetPositionsAtDistances( const f32* pDistances, s32 count, Vector3* pPositions ) const;
+
+		// count points spaced evenly by arc length from start to end.
+		void Sample( s32 count, Vector3* pPositions ) const;
+
+		// Distance along the path of the point closest to point.
+		f32 FindClosestDistance( const Vector3& point ) const;
+
+	private:
+		// P( t ) = A + B t + C t^2 + D t^3, t in [ 0, 1 ].
+		struct Segment
+		{
+			Vector3 A;
+			Vector3 B;
+			Vector3 C;
+			Vector3 D;
+		};
+
+		void SplitParameter( f32 parameter, s32& segment, f32& t ) const;
+		f32 WrapDistance( f32 distance ) const;
+		f32 ParameterAtDistance( f32 distance, s32& hint ) const;
+
+	private:
+		std::vector<Vector3> m_points;
+		std::vector<Segment> m_segments;
+		bool m_bClosed;
+
+		s32 m_samplesPerSegment;
+
+		// Arc length at parameter i / m_samplesPerSegment.
+		std::vector<f32> m_distances;
+	};
+}
@@ -0,0 +1,246 @@
+#include "TomatoPCH.h"
+
+#include "Vector3d.h"
+
+#include <cmath>
+
+namespace Tomato
+{
+	Vector3d::Vector3d()
+		: X( 0 )
+		, Y( 0 )
+		, Z( 0 )
+	{
+	}
+
+	Vector3d::Vector3d( f64 x, f64 y, f64 z )
+		: X( x )
+		, Y( y )
+		, Z( z )
+	{
+	}
+
+	Vector3d::Vector3d( const Vector3& v )
+		: X( v.X )
+		, Y( v.Y )
+		, Z( v.Z )
+	{
+	}
+
+	Vector3d::~Vector3d()
+	{
+	}
+
+	f64& Vector3d::operator[] ( s32 index )
+	{
+		Assert( index >= 0 );
+		Assert( index < 3 );
+		return V[ index ];
+	}
+
+	const f64& Vector3d::operator[] ( s32 index ) const
+	{
+		Assert( index >= 0 );
+		Assert( index < 3 );
+		return V[ index ];
+	}
+
+	void Vector3d::Set( f64 x, f64 y, f64 z )
+	{
+		X = x;
+		Y = y;
+		Z = z;
+	}
+
+	Vector3d& Vector3d::operator = ( const Vector3d& v )
+	{
+		Set( v.X, v.Y, v.Z );
+		return *this;
+	}
+
+	Vector3d& Vector3d::operator += ( const Vector3d& v )
+	{
+		X += v.X;
+		Y += v.Y;
+		Z += v.Z;
+
+		return *this;
+	}
+
+	Vector3d& Vector3d::operator -= ( const Vector3d& v )
+	{
+		X -= v.X;
+		Y -= v.Y;
+		Z -= v.Z;
+
+		return *this;
+	}
+
+	Vector3d& Vector3d::operator *= ( f64 scalar )
+	{
+		X *= scalar;
+		Y *= scalar;
+		Z *= scalar;
+
+		return *this;
+	}
+
+	Vector3d& Vector3d::operator /= ( f64 scalar )
+	{
+		Assert( scalar != 0 );
+
+		f64 inv = 1 / scalar;
+
+		X *= inv;
+		Y *= inv;
+		Z *= inv;
+
+		return *this;
+	}
+
+	bool Vector3d::operator == ( const Vector3d& v ) const
+	{
+		return ( v.X == X && v.Y == Y && v.Z == Z );
+	}
+
+	bool Vector3d::operator != ( const Vector3d& v ) const
+	{
+		return !( (*this) == v );
+	}
+
+	Vector3d Vector3d::operator + ( const Vector3d& v ) const
+	{
+		Vector3d result = *this;
+		result += v;
+		return result;
+	}
+
+	Vector3d Vector3d::operator - ( const Vector3d& v ) const
+	{
+		Vector3d result = *this;
+		result -= v;
+		return result;
+	}
+
+	Vector3d Vector3d::operator * ( f64 scalar ) const
+	{
+		Vector3d result = *this;
+		result *= scalar;
+		return result;
+	}
+
+	Vector3d Vector3d::operator / ( f64 scalar ) const
+	{
+		Vector3d result = *this;
+		result /= scalar;
+		return result;
+	}
+
+	Vector3d Vector3d::operator - () const
+	{
+		return Vector3d( -X, -Y, -Z );
+	}
+
+	void Vector3d::SetZero()
+	{
+		Set( 0, 0, 0 );
+	}
+
+	f64 Vector3d::GetLength() const
+	{
+		return sqrt( GetLengthSquared() );
+	}
+
+	f64 Vector3d::GetLengthSquared() const
+	{
+		return ( X * X + Y * Y + Z * Z );
+	}
+
+	void Vector3d::Normalize()
+	{
+		f64 length = GetLength();
+
+		if( length != 0 )
+		{
+			f64 invLength = 1 / length;
+			X *= invLength;
+			Y *= invLength;
+			Z *= invLength;
+		}
+	}
+
+	Vector3 Vector3d::ToVector3() const
+	{
+		return Vector3(
+			static_cast<f32>( X ),
+			static_cast<f32>( Y ),
+			static_cast<f32>( Z ) );
+	}
+
+	Vector3 Vector3d::ToRelative( const Vector3d& origin ) const
+	{
+		return Vector3(
+			static_cast<f32>( X - origin.X ),
+			static_cast<f32>( Y - origin.Y ),
+			static_cast<f32>( Z - origin.Z ) );
+	}
+
+	f64 Vector3d::GetDistance( const Vector3d& v1, const Vector3d& v2 )
+	{
+		return ( v1 - v2 ).GetLength();
+	}
+
+	f64 Vector3d::GetDistanceSquared( const Vector3d& v1, const Vector3d& v2 )
+	{
+		return ( v1 - v2 ).GetLengthSquared();
+	}
+
+	f64 Vector3d::Dot( const Vector3d& v1, const Vector3d& v2 )
+	{
+		return ( ( v1.X * v2.X ) + ( v1.Y * v2.Y ) + ( v1.Z * v2.Z ) );
+	}
+
+	Vector3d Vector3d::Normalize( const Vector3d& v )
+	{
+		Vector3d vector = v;
+		vector.Normalize();
+		return vector;
+	}
+
+	Vector3d Vector3d::Cross( const Vector3d& v1, const Vector3d& v2 )
+	{
+		return Vector3d(
+			( v1.Y * v2.Z ) - ( v1.Z * v2.Y ),
+			( v1.Z * v2.X ) - ( v1.X * v2.Z ),
+			( v1.X * v2.Y ) - ( v1.Y * v2.X ) );
+	}
+
+	Vector3d Vector3d::Min( const Vector3d& v1, const Vector3d& v2 )
+	{
+		return Vector3d(
+			Math::Min( v1.X, v2.X ),
+			Math::Min( v1.Y, v2.Y ),
+			Math::Min( v1.Z, v2.Z ) );
+	}
+
+	Vector3d Vector3d::Max( const Vector3d& v1, const Vector3d& v2 )
+	{
+		return Vector3d(
+			Math::Max( v1.X, v2.X ),
+			Math::Max( v1.Y, v2.Y ),
+			Math::Max( v1.Z, v2.Z ) );
+	}
+
+	Vector3d Vector3d::Lerp( const Vector3d& v1, const Vector3d& v2, f64 w )
+	{
+		return Vector3d(
+			v1.X + ( ( v2.X - v1.X ) * w ),
+			v1.Y + ( ( v2.Y - v1.Y ) * w ),
+			v1.Z + ( ( v2.Z - v1.Z ) * w ) );
+	}
+
+	Vector3d Vector3d::Zero()
+	{
+		return Vector3d( 0, 0, 0 );
+	}
+}
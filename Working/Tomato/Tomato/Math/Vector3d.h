@@ -0,0 +1,82 @@
+#pragma once
+
+namespace Tomato
+{
+	// Double precision Vector3 for world space positions that exceed the range f32 can resolve.
+	class TOMATO_API Vector3d
+	{
+	public:
+		Vector3d();
+		Vector3d( f64 x, f64 y, f64 z );
+		explicit Vector3d( const Vector3& v );
+		~Vector3d();
+
+		f64& operator[] ( s32 index );
+		const f64& operator[] ( s32 index ) const;
+
+		void Set( f64 x, f64 y, f64 z );
+
+		Vector3d& operator = ( const Vector3d& v );
+		Vector3d& operator += ( const Vector3d& v );
+		Vector3d& operator -= ( const Vector3d& v );
+		Vector3d& operator *= ( f64 scalar );
+		Vector3d& operator /= ( f64 scalar );
+
+		bool operator == ( const Vector3d& v ) const;
+		bool operator != ( const Vector3d& v ) const;
+
+		Vector3d operator + ( const Vector3d& v ) const;
+		Vector3d operator - ( const Vector3d& v ) const;
+		Vector3d operator * ( f64 scalar ) const;
+		Vector3d operator / ( f64 scalar ) const;
+
+		Vector3d operator - () const;
+
+		void SetZero();
+
+		f64 GetLength() const;
+		f64 GetLengthSquared() const;
+
+		void Normalize();
+
+		// Narrows to f32. Only meaningful for values near the origin, see ToRelative.
+		Vector3 ToVector3() const;
+
+		// Offset from origin, computed in f64 and then narrowed to f32.
+		Vector3 ToRelative( const Vector3d& origin ) const;
+
+		static f64 GetDistance( const Vector3d& v1, const Vector3d& v2 );
+		static f64 GetDistanceSquared( const Vector3d& v1, const Vector3d& v2 );
+
+		static f64 Dot( const Vector3d& v1, const Vector3d& v2 );
+
+		static Vector3d Normalize( const Vector3d& v );
+
+		static Vector3d Cross( const Vector3d& v1, const Vector3d& v2 );
+
+		static Vector3d Min( const Vector3d& v1, const Vector3d& v2 );
+		static Vector3d Max( const Vector3d& v1, const Vector3d& v2 );
+
+		static Vector3d Lerp( const Vector3d& v1, const Vector3d& v2, f64 w );
+
+		static Vector3d Zero();
+
+	public:
+
+#pragma warning( disable: 4201 )
+
+		union
+		{
+			f64 V[3];
+
+			struct  
+			{
+				f64 X;
+				f64 Y;
+				f64 Z;
+			};
+		};
+
+#pragma warning( default: 4201 )		
+	};
+}
@@ -0,0 +1,286 @@
+#pragma once
+
+namespace Tomato
+{
+	// Packs fields of any bit width into the payload of a message stream.
+	//
+	// Bits collect in a 64-bit scratch word, least significant first, and reach the stream four
+	// bytes at a time; Flush pads the last partial byte with zeroes and writes it out. Other
+	// writes to the stream must wait until the writer has been flushed, e.g.
+	//
+	//		BitWriter<MessageStream> writer( stream );
+	//		writer.WriteBits( state, 3 );
+	//		writer.WriteNormal( normal, 11 );
+	//		writer.Flush();
+	//		stream.WriteU32( ... );
+	template<typename Stream>
+	class BitWriter
+	{
+	public:
+		explicit BitWriter( Stream& stream )
+			: m_stream( stream )
+			, m_scratch( 0 )
+			, m_scratchBits( 0 )
+			, m_bitCount( 0 )
+		{
+		}
+
+		~BitWriter()
+		{
+			Flush();
+		}
+
+	public:
+		// bitCount is 1 to 32; bits of value above bitCount must be zero.
+		void WriteBits( u32 value, u32 bitCount )
+		{
+			Assert( 1 <= bitCount && bitCount <= 32 );
+			Assert( bitCount == 32 || ( value >> bitCount ) == 0 );
+
+			m_scratch |= static_cast<u64>( value ) << m_scratchBits;
+			m_scratchBits += bitCount;
+			m_bitCount += bitCount;
+
+			if( m_scratchBits >= 32 )
+			{
+				u32 word = static_cast<u32>( m_scratch );
+				m_stream.Write( &word, sizeof( word ) );
+
+				m_scratch >>= 32;
+				m_scratchBits -= 32;
+			}
+		}
+
+		void WriteBool( bool value )
+		{
+			WriteBits( value ? 1 : 0, 1 );
+		}
+
+		void WriteU64( u64 value )
+		{
+			WriteBits( static_cast<u32>( value ), 32 );
+			WriteBits( static_cast<u32>( value >> 32 ), 32 );
+		}
+
+		// See Quantization.
+		void WriteQuantizedF32( f32 value, f32 min, f32 max, u32 bits )
+		{
+			WriteBits( Quantization::Quantize( value, min, max, bits ), bits );
+		}
+
+		// 2 * bits bits.
+		void WriteNormal( const Vector3& normal, u32 bits )
+		{
+			u32 u;
+			u32 v;
+			Quantization::QuantizeNormal( normal, bits, u, v );
+
+			WriteBits( u, bits );
+			WriteBits( v, bits );
+		}
+
+		// 2 + 3 * bits bits.
+		void WriteQuaternion( const Quaternion& rotation, u32 bits )
+		{
+			u32 largestIndex;
+			u32 components[ 3 ];
+			Quantization::QuantizeQuaternion( rotation, bits, largestIndex, components );
+
+			WriteBits( largestIndex, 2 );
+			WriteBits( components[ 0 ], bits );
+			WriteBits( components[ 1 ], bits );
+			WriteBits( components[ 2 ], bits );
+		}
+
+		// Pads with zero bits up to the next byte boundary.
+		void AlignToByte()
+		{
+			u32 padding = ( 8 - ( m_bitCount & 7 ) ) & 7;
+			if( padding > 0 )
+			{
+				WriteBits( 0, padding );
+			}
+		}
+
+		// Aligns and writes the pending bytes to the stream.
+		void Flush()
+		{
+			AlignToByte();
+
+			if( m_scratchBits > 0 )
+			{
+				u32 word = static_cast<u32>( m_scratch );
+				m_stream.Write( &word, m_scratchBits / 8 );
+
+				m_scratch = 0;
+				m_scratchBits = 0;
+			}
+		}
+
+		// Bits written since construction, including padding.
+		u32 GetBitCount() const
+		{
+			return m_bitCount;
+		}
+
+	private:
+		BitWriter( const BitWriter& copy );
+		BitWriter& operator = ( const BitWriter& copy );
+
+	private:
+		Stream& m_stream;
+
+		u64 m_scratch;
+		u32 m_scratchBits;
+		u32 m_bitCount;
+	};
+
+	// Reads what BitWriter wrote, starting at the read position of a MessageStreamBase or
+	// MessageStreamView. The stream's read position moves past the bit fields, rounded up to
+	// a whole byte, when the reader is finished or destroyed.
+	template<typename Stream>
+	class BitReader
+	{
+	public:
+		explicit BitReader( const Stream& stream )
+			: m_stream( stream )
+			, m_pData( stream.GetPayload() + stream.GetReadPosition() )
+			, m_length( stream.GetPayloadLength() - stream.GetReadPosition() )
+			, m_position( 0 )
+			, m_scratch( 0 )
+			, m_scratchBits( 0 )
+			, m_bitCount( 0 )
+			, m_bFinished( false )
+		{
+		}
+
+		~BitReader()
+		{
+			Finish();
+		}
+
+	public:
+		u32 ReadBits( u32 bitCount )
+		{
+			Assert( 1 <= bitCount && bitCount <= 32 );
+
+			if( m_scratchBits < bitCount )
+			{
+				Refill();
+
+				Assert( m_scratchBits >= bitCount );
+			}
+
+			u32 value = static_cast<u32>( m_scratch & ( 0xFFFFFFFFULL >> ( 32 - bitCount ) ) );
+
+			m_scratch >>= bitCount;
+			m_scratchBits = ( m_scratchBits > bitCount ) ? m_scratchBits - bitCount : 0;
+			m_bitCount += bitCount;
+
+			return value;
+		}
+
+		bool ReadBool()
+		{
+			return ( ReadBits( 1 ) != 0 );
+		}
+
+		u64 ReadU64()
+		{
+			u64 low = ReadBits( 32 );
+			u64 high = ReadBits( 32 );
+
+			return low | ( high << 32 );
+		}
+
+		f32 ReadQuantizedF32( f32 min, f32 max, u32 bits )
+		{
+			return Quantization::Dequantize( ReadBits( bits ), min, max, bits );
+		}
+
+		Vector3 ReadNormal( u32 bits )
+		{
+			u32 u = ReadBits( bits );
+			u32 v = ReadBits( bits );
+
+			return Quantization::DequantizeNormal( u, v, bits );
+		}
+
+		Quaternion ReadQuaternion( u32 bits )
+		{
+			u32 largestIndex = ReadBits( 2 );
+
+			u32 components[ 3 ];
+			components[ 0 ] = ReadBits( bits );
+			components[ 1 ] = ReadBits( bits );
+			components[ 2 ] = ReadBits( bits );
+
+			return Quantization::DequantizeQuaternion( largestIndex, components, bits );
+		}
+
+		// Skips the padding BitWriter::AlignToByte wrote.
+		void AlignToByte()
+		{
+			u32 padding = ( 8 - ( m_bitCount & 7 ) ) & 7;
+			if( padding > 0 )
+			{
+				ReadBits( padding );
+			}
+		}
+
+		// Aligns and hands the bytes read back to the stream; nothing can be read afterwards.
+		void Finish()
+		{
+			if( !m_bFinished )
+			{
+				AlignToByte();
+
+				m_stream.ReadBytes( m_bitCount / 8 );
+				m_bFinished = true;
+			}
+		}
+
+		u32 GetBitCount() const
+		{
+			return m_bitCount;
+		}
+
+	private:
+		BitReader( const BitReader& copy );
+		BitReader& operator = ( const BitReader& copy );
+
+		void Refill()
+		{
+			// Whole bytes are appended above the bits still in the scratch word.
+			if( m_scratchBits <= 32 && m_position + 4 <= m_length )
+			{
+				u32 word;
+				::CopyMemory( &word, m_pData + m_position, sizeof( word ) );
+
+				m_scratch |= static_cast<u64>( word ) << m_scratchBits;
+				m_scratchBits += 32;
+				m_position += 4;
+			}
+
+			while( m_scratchBits <= 56 && m_position < m_length )
+			{
+				m_scratch |= static_cast<u64>( m_pData[ m_position ] ) << m_scratchBits;
+				m_scratchBits += 8;
+				m_position += 1;
+			}
+		}
+
+	private:
+		const Stream& m_stream;
+
+		const u8* m_pData;
+		u32 m_length;
+		u32 m_position;
+
+		u64 m_scratch;
+		u32 m_scratchBits;
+		u32 m_bitCount;
+
+		bool m_bFinished;
+	};
+}
@@ -0,0 +1,94 @@
+#include "TomatoPCH.h"
+
+#include "ByteOrder.h"
+
+#include <emmintrin.h>
+
+namespace Tomato
+{
+	namespace
+	{
+		// Swaps the bytes of every 16-bit lane.
+		inline __m128i SwapBytes16( __m128i v )
+		{
+			return _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+		}
+
+		// SSE2 has no byte shuffle, so lanes are swapped by reordering their 16-bit halves first.
+		template<u32 ScalarSize>
+		inline __m128i SwapLanes( __m128i v );
+
+		template<>
+		inline __m128i SwapLanes<2>( __m128i v )
+		{
+			return SwapBytes16( v );
+		}
+
+		template<>
+		inline __m128i SwapLanes<4>( __m128i v )
+		{
+			v = _mm_shufflelo_epi16( v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+			v = _mm_shufflehi_epi16( v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+			return SwapBytes16( v );
+		}
+
+		template<>
+		inline __m128i SwapLanes<8>( __m128i v )
+		{
+			v = _mm_shufflelo_epi16( v, _MM_SHUFFLE( 0, 1, 2, 3 ) );
+			v = _mm_shufflehi_epi16( v, _MM_SHUFFLE( 0, 1, 2, 3 ) );
+			return SwapBytes16( v );
+		}
+
+		template<typename T, u32 ScalarSize>
+		void SwapScalars( byte* pDestination, const byte* pSource, u32 scalarCount )
+		{
+			u32 blockCount = scalarCount * ScalarSize / 16;
+			for( u32 i = 0; i < blockCount; ++i )
+			{
+				__m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSource ) + i );
+				_mm_storeu_si128( reinterpret_cast<__m128i*>( pDestination ) + i, SwapLanes<ScalarSize>( v ) );
+			}
+
+			for( u32 i = blockCount * 16 / ScalarSize; i < scalarCount; ++i )
+			{
+				T value;
+				::CopyMemory( &value, pSource + i * ScalarSize, ScalarSize );
+				value = ByteOrder::Swap( value );
+				::CopyMemory( pDestination + i * ScalarSize, &value, ScalarSize );
+			}
+		}
+	}
+
+	void ByteOrder::Swap( void* pDestination, const void* pSource, u32 scalarCount, u32 scalarSize )
+	{
+		byte* pDestinationBytes = static_cast<byte*>( pDestination );
+		const byte* pSourceBytes = static_cast<const byte*>( pSource );
+
+		switch( scalarSize )
+		{
+		case 1:
+			if( pDestination != pSource )
+			{
+				::CopyMemory( pDestination, pSource, scalarCount );
+			}
+			break;
+
+		case 2:
+			SwapScalars<u16, 2>( pDestinationBytes, pSourceBytes, scalarCount );
+			break;
+
+		case 4:
+			SwapScalars<u32, 4>( pDestinationBytes, pSourceBytes, scalarCount );
+			break;
+
+		case 8:
+			SwapScalars<u64, 8>( pDestinationBytes, pSourceBytes, scalarCount );
+			break;
+
+		default:
+			Assert( false );
+			break;
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+namespace Tomato
+{
+	// Byte order conversion for exchanging data with big-endian peers.
+	class TOMATO_API ByteOrder
+	{
+	public:
+		static u16 Swap( u16 value )
+		{
+			return static_cast<u16>( ( value << 8 ) | ( value >> 8 ) );
+		}
+
+		static u32 Swap( u32 value )
+		{
+			return ( value << 24 )
+				| ( ( value << 8 ) & 0x00FF0000 )
+				| ( ( value >> 8 ) & 0x0000FF00 )
+				| ( value >> 24 );
+		}
+
+		static u64 Swap( u64 value )
+		{
+			return ( static_cast<u64>( Swap( static_cast<u32>( value ) ) ) << 32 )
+				| Swap( static_cast<u32>( value >> 32 ) );
+		}
+
+		// Reverses the bytes of each of scalarCount scalars of scalarSize bytes (1, 2, 4 or 8).
+		// The source and destination may be the same but must not otherwise overlap, and need no alignment.
+		static void Swap( void* pDestination, const void* pSource, u32 scalarCount, u32 scalarSize );
+
+	private:
+		ByteOrder();
+	};
+}
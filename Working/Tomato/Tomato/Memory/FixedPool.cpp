@@ -0,0 +1,156 @@
+#include "TomatoPCH.h"
+
+#include "FixedPool.h"
+
+namespace Tomato
+{
+	FixedPool::FixedPool( u32 elementSize, u32 alignment, s32 elementsPerPage )
+		: m_elementSize( elementSize )
+		, m_stride( 0 )
+		, m_alignment( 0 )
+		, m_elementsPerPage( elementsPerPage )
+		, m_pFree( NULL )
+		, m_count( 0 )
+	{
+		Assert( elementSize > 0 );
+		Assert( alignment > 0 && ( alignment & ( alignment - 1 ) ) == 0 );
+		Assert( elementsPerPage > 0 );
+
+		// Free elements hold the free list link.
+		m_alignment = ( alignment < sizeof( FreeNode ) ) ? sizeof( FreeNode ) : alignment;
+
+		u32 size = ( elementSize < sizeof( FreeNode ) ) ? sizeof( FreeNode ) : elementSize;
+		m_stride = ( size + m_alignment - 1 ) & ~( m_alignment - 1 );
+	}
+
+	FixedPool::~FixedPool()
+	{
+		for( size_t i = 0; i < m_pages.size(); ++i )
+		{
+			_aligned_free( m_pages[ i ] );
+		}
+	}
+
+	void FixedPool::AddPage()
+	{
+		byte* pPage = static_cast<byte*>( _aligned_malloc( m_stride * m_elementsPerPage, m_alignment ) );
+		m_pages.push_back( pPage );
+
+		// Link back to front so elements are handed out in address order.
+		for( s32 i = m_elementsPerPage - 1; i >= 0; --i )
+		{
+			FreeNode* pNode = reinterpret_cast<FreeNode*>( pPage + i * m_stride );
+			pNode->pNext = m_pFree;
+			m_pFree = pNode;
+		}
+	}
+
+	void FixedPool::Clear()
+	{
+		Assert( m_count == 0 );
+
+		for( size_t i = 0; i < m_pages.size(); ++i )
+		{
+			_aligned_free( m_pages[ i ] );
+		}
+
+		m_pages.clear();
+		m_pFree = NULL;
+		m_count = 0;
+	}
+
+	ConcurrentFixedPool::ConcurrentFixedPool( u32 elementSize, u32 alignment, s32 elementsPerPage, s32 cacheSize )
+		: m_pool( elementSize, alignment, elementsPerPage )
+		, m_cacheSize( cacheSize )
+		, m_tlsIndex( ::TlsAlloc() )
+	{
+		Assert( cacheSize >= 2 );
+		Assert( m_tlsIndex != TLS_OUT_OF_INDEXES );
+
+		::InitializeCriticalSection( &m_lock );
+	}
+
+	ConcurrentFixedPool::~ConcurrentFixedPool()
+	{
+		for( size_t i = 0; i < m_caches.size(); ++i )
+		{
+			while( m_caches[ i ]->Count > 0 )
+			{
+				m_pool.Free( m_caches[ i ]->pElements[ --m_caches[ i ]->Count ] );
+			}
+
+			delete [] m_caches[ i ]->pElements;
+			delete m_caches[ i ];
+		}
+
+		::TlsFree( m_tlsIndex );
+		::DeleteCriticalSection( &m_lock );
+	}
+
+	ConcurrentFixedPool::ThreadCache& ConcurrentFixedPool::GetThreadCache()
+	{
+		ThreadCache* pCache = static_cast<ThreadCache*>( ::TlsGetValue( m_tlsIndex ) );
+		if( pCache == NULL )
+		{
+			pCache = new ThreadCache;
+			pCache->pElements = new void*[ m_cacheSize ];
+			pCache->Count = 0;
+
+			::TlsSetValue( m_tlsIndex, pCache );
+
+			::EnterCriticalSection( &m_lock );
+			m_caches.push_back( pCache );
+			::LeaveCriticalSection( &m_lock );
+		}
+
+		return *pCache;
+	}
+
+	void* ConcurrentFixedPool::Allocate()
+	{
+		ThreadCache& cache = GetThreadCache();
+
+		if( cache.Count == 0 )
+		{
+			::EnterCriticalSection( &m_lock );
+			for( s32 i = m_cacheSize / 2; i > 0; --i )
+			{
+				cache.pElements[ cache.Count++ ] = m_pool.Allocate();
+			}
+			::LeaveCriticalSection( &m_lock );
+		}
+
+		return cache.pElements[ --cache.Count ];
+	}
+
+	void ConcurrentFixedPool::Free( void* p )
+	{
+		Assert( p != NULL );
+
+		ThreadCache& cache = GetThreadCache();
+
+		if( cache.Count == m_cacheSize )
+		{
+			::EnterCriticalSection( &m_lock );
+			for( s32 i = m_cacheSize / 2; i > 0; --i )
+			{
+				m_pool.Free( cache.pElements[ --cache.Count ] );
+			}
+			::LeaveCriticalSection( &m_lock );
+		}
+
+		cache.pElements[ cache.Count++ ] = p;
+	}
+
+	void ConcurrentFixedPool::FlushThreadCache()
+	{
+		ThreadCache& cache = GetThreadCache();
+
+		::EnterCriticalSection( &m_lock );
+		while( cache.Count > 0 )
+		{
+			m_pool.Free( cache.pElements[ --cache.Count ] );
+		}
+		::LeaveCriticalSection( &m_lock );
+	}
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+namespace Tomato
+{
+	// Allocator for blocks of one fixed size.
+	//
+	// Elements are carved out of pages of elementsPerPage and recycled through an intrusive free
+	// list, so Allocate and Free are a few instructions and neighbouring objects share cache lines.
+	// Pages are only returned to the heap by the destructor or by Clear; the destructor does not
+	// require every element to have been freed.
+	class TOMATO_API FixedPool
+	{
+	public:
+		// Alignment must be a power of two.
+		FixedPool( u32 elementSize, u32 alignment = 16, s32 elementsPerPage = 256 );
+		~FixedPool();
+
+	public:
+		void* Allocate()
+		{
+			if( m_pFree == NULL )
+			{
+				AddPage();
+			}
+
+			FreeNode* pNode = m_pFree;
+			m_pFree = pNode->pNext;
+			++m_count;
+			return pNode;
+		}
+
+		void Free( void* p )
+		{
+			Assert( p != NULL );
+			Assert( m_count > 0 );
+
+			FreeNode* pNode = static_cast<FreeNode*>( p );
+			pNode->pNext = m_pFree;
+			m_pFree = pNode;
+			--m_count;
+		}
+
+		// Frees every page. No element may still be in use.
+		void Clear();
+
+		u32 GetElementSize() const { return m_elementSize; }
+
+		// Elements allocated and not freed.
+		s32 GetCount() const { return m_count; }
+		s32 GetCapacity() const { return static_cast<s32>( m_pages.size() ) * m_elementsPerPage; }
+
+	private:
+		FixedPool( const FixedPool& copy );
+		FixedPool& operator = ( const FixedPool& copy );
+
+		struct FreeNode
+		{
+			FreeNode* pNext;
+		};
+
+		void AddPage();
+
+	private:
+		u32 m_elementSize;
+		u32 m_stride;
+		u32 m_alignment;
+		s32 m_elementsPerPage;
+
+		FreeNode* m_pFree;
+		s32 m_count;
+
+		std::vector<byte*> m_pages;
+	};
+
+	// FixedPool that many threads can share.
+	//
+	// Each thread keeps a small cache of free elements and only takes the lock to move half a
+	// cache at a time to or from the shared pool. Elements may be freed by a different thread
+	// than the one that allocated them.
+	class TOMATO_API ConcurrentFixedPool
+	{
+	public:
+		ConcurrentFixedPool( u32 elementSize, u32 alignment = 16, s32 elementsPerPage = 256, s32 cacheSize = 32 );
+		~ConcurrentFixedPool();
+
+	public:
+		void* Allocate();
+		void Free( void* p );
+
+		// Returns the calling thread's cached elements to the shared pool, e.g. before the thread exits.
+		void FlushThreadCache();
+
+		u32 GetElementSize() const { return m_pool.GetElementSize(); }
+
+	private:
+		ConcurrentFixedPool( const ConcurrentFixedPool& copy );
+		ConcurrentFixedPool& operator = ( const ConcurrentFixedPool& copy );
+
+		struct ThreadCache
+		{
+			void** pElements;
+			s32 Count;
+		};
+
+		ThreadCache& GetThreadCache();
+
+	private:
+		FixedPool m_pool;
+		s32 m_cacheSize;
+
+		CRITICAL_SECTION m_lock;
+		DWORD m_tlsIndex;
+		std::vector<ThreadCache*> m_caches;
+	};
+
+	// FixedPool that constructs and destroys objects of type T.
+	template<typename T>
+	class ObjectPool
+	{
+	public:
+		explicit ObjectPool( s32 elementsPerPage = 256 )
+			: m_pool( sizeof( T ), __alignof( T ), elementsPerPage )
+		{
+		}
+
+		// Objects still alive are not destroyed, only their memory is freed.
+		~ObjectPool()
+		{
+		}
+
+	public:
+		T* Create()
+		{
+			return new( m_pool.Allocate() ) T();
+		}
+
+		template<typename A1>
+		T* Create( const A1& a1 )
+		{
+			return new( m_pool.Allocate() ) T( a1 );
+		}
+
+		template<typename A1, typename A2>
+		T* Create( const A1& a1, const A2& a2 )
+		{
+			return new( m_pool.Allocate() ) T( a1, a2 );
+		}
+
+		template<typename A1, typename A2, typename A3>
+		T* Create( const A1& a1, const A2& a2, const A3& a3 )
+		{
+			return new( m_pool.Allocate() ) T( a1, a2, a3 );
+		}
+
+		void Destroy( T* p )
+		{
+			if( p != NULL )
+			{
+				p->~T();
+				m_pool.Free( p );
+			}
+		}
+
+		s32 GetCount() const { return m_pool.GetCount(); }
+
+	private:
+		ObjectPool( const ObjectPool& copy );
+		ObjectPool& operator = ( const ObjectPool& copy );
+
+	private:
+		FixedPool m_pool;
+	};
+}
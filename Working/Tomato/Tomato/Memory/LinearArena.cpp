@@ -0,0 +1,209 @@
+#include "TomatoPCH.h"
+
+#include "LinearArena.h"
+
+namespace Tomato
+{
+	namespace
+	{
+		// Blocks start on a cache line, which covers the alignment of every built-in and SSE type.
+		enum { BlockAlignment = 64 };
+
+		class ThreadArenaRegistry
+		{
+		public:
+			ThreadArenaRegistry()
+				: m_tlsIndex( ::TlsAlloc() )
+			{
+				::InitializeCriticalSection( &m_lock );
+			}
+
+			~ThreadArenaRegistry()
+			{
+				for( size_t i = 0; i < m_arenas.size(); ++i )
+				{
+					delete m_arenas[ i ];
+				}
+
+				::TlsFree( m_tlsIndex );
+				::DeleteCriticalSection( &m_lock );
+			}
+
+			LinearArena& Get()
+			{
+				LinearArena* pArena = static_cast<LinearArena*>( ::TlsGetValue( m_tlsIndex ) );
+				if( pArena == NULL )
+				{
+					pArena = new LinearArena;
+					::TlsSetValue( m_tlsIndex, pArena );
+
+					::EnterCriticalSection( &m_lock );
+					m_arenas.push_back( pArena );
+					::LeaveCriticalSection( &m_lock );
+				}
+
+				return *pArena;
+			}
+
+			void ResetAll()
+			{
+				::EnterCriticalSection( &m_lock );
+				for( size_t i = 0; i < m_arenas.size(); ++i )
+				{
+					m_arenas[ i ]->Reset();
+				}
+				::LeaveCriticalSection( &m_lock );
+			}
+
+			void ReleaseAll()
+			{
+				::EnterCriticalSection( &m_lock );
+				for( size_t i = 0; i < m_arenas.size(); ++i )
+				{
+					m_arenas[ i ]->Release();
+				}
+				::LeaveCriticalSection( &m_lock );
+			}
+
+		private:
+			DWORD m_tlsIndex;
+			CRITICAL_SECTION m_lock;
+			std::vector<LinearArena*> m_arenas;
+		};
+
+		ThreadArenaRegistry s_threadArenas;
+	}
+
+	LinearArena::LinearArena( u32 blockSize )
+		: m_blockSize( blockSize )
+		, m_current( -1 )
+		, m_pBlock( NULL )
+		, m_blockCapacity( 0 )
+		, m_offset( 0 )
+	{
+		Assert( blockSize > 0 );
+	}
+
+	LinearArena::~LinearArena()
+	{
+		Release();
+	}
+
+	void* LinearArena::AllocateSlow( u32 size, u32 alignment )
+	{
+		Assert( alignment > 0 && ( alignment & ( alignment - 1 ) ) == 0 );
+
+		// Padding beyond the block alignment has to come out of the block itself.
+		u32 required = size + ( ( alignment > BlockAlignment ) ? alignment : 0 );
+
+		s32 next = m_current + 1;
+		if( next == static_cast<s32>( m_blocks.size() ) || m_blocks[ next ].Size < required )
+		{
+			// Cached blocks that are too small stay behind the new one for later frames.
+			Block block;
+			block.Size = ( required > m_blockSize ) ? required : m_blockSize;
+			block.pMemory = static_cast<byte*>( _aligned_malloc( block.Size, BlockAlignment ) );
+
+			m_blocks.insert( m_blocks.begin() + next, block );
+		}
+
+		SetCurrent( next, 0 );
+
+		return Allocate( size, alignment );
+	}
+
+	void LinearArena::SetCurrent( s32 block, u32 offset )
+	{
+		m_current = block;
+		m_offset = offset;
+
+		if( block >= 0 && block < static_cast<s32>( m_blocks.size() ) )
+		{
+			m_pBlock = m_blocks[ block ].pMemory;
+			m_blockCapacity = m_blocks[ block ].Size;
+		}
+		else
+		{
+			m_pBlock = NULL;
+			m_blockCapacity = 0;
+		}
+	}
+
+	LinearArena::Marker LinearArena::GetMarker() const
+	{
+		Marker marker;
+		marker.Block = m_current;
+		marker.Offset = m_offset;
+		return marker;
+	}
+
+	void LinearArena::Rewind( const Marker& marker )
+	{
+		Assert( marker.Block < m_current || ( marker.Block == m_current && marker.Offset <= m_offset ) );
+
+		SetCurrent( marker.Block, marker.Offset );
+	}
+
+	void LinearArena::Reset()
+	{
+		SetCurrent( m_blocks.empty() ? -1 : 0, 0 );
+	}
+
+	void LinearArena::Trim()
+	{
+		for( size_t i = m_current + 1; i < m_blocks.size(); ++i )
+		{
+			_aligned_free( m_blocks[ i ].pMemory );
+		}
+
+		m_blocks.resize( m_current + 1 );
+	}
+
+	void LinearArena::Release()
+	{
+		for( size_t i = 0; i < m_blocks.size(); ++i )
+		{
+			_aligned_free( m_blocks[ i ].pMemory );
+		}
+
+		m_blocks.clear();
+		SetCurrent( -1, 0 );
+	}
+
+	u32 LinearArena::GetUsedSize() const
+	{
+		u32 size = m_offset;
+		for( s32 i = 0; i < m_current; ++i )
+		{
+			size += m_blocks[ i ].Size;
+		}
+
+		return size;
+	}
+
+	u32 LinearArena::GetCapacity() const
+	{
+		u32 capacity = 0;
+		for( size_t i = 0; i < m_blocks.size(); ++i )
+		{
+			capacity += m_blocks[ i ].Size;
+		}
+
+		return capacity;
+	}
+
+	LinearArena& ThreadArena::Get()
+	{
+		return s_threadArenas.Get();
+	}
+
+	void ThreadArena::ResetAll()
+	{
+		s_threadArenas.ResetAll();
+	}
+
+	void ThreadArena::ReleaseAll()
+	{
+		s_threadArenas.ReleaseAll();
+	}
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+namespace Tomato
+{
+	// Bump allocator for short-lived memory.
+	//
+	// Allocations are carved out of large blocks and are not freed one by one: Rewind releases
+	// everything allocated after a marker and Reset releases everything, typically once per
+	// frame. Blocks are kept for reuse, so a warmed up arena does not touch the heap.
+	// Destructors are never run; destroy objects that need it before their memory is rewound.
+	class TOMATO_API LinearArena
+	{
+	public:
+		enum { DefaultBlockSize = 256 * 1024 };
+
+		struct Marker
+		{
+			s32 Block;
+			u32 Offset;
+		};
+
+		explicit LinearArena( u32 blockSize = DefaultBlockSize );
+		~LinearArena();
+
+	public:
+		// Alignment must be a power of two. Requests larger than the block size get a block of their own.
+		void* Allocate( u32 size, u32 alignment = 16 )
+		{
+			size_t top = reinterpret_cast<size_t>( m_pBlock ) + m_offset;
+			size_t aligned = ( top + alignment - 1 ) & ~static_cast<size_t>( alignment - 1 );
+			size_t end = aligned + size - reinterpret_cast<size_t>( m_pBlock );
+
+			if( m_pBlock == NULL || end > m_blockCapacity )
+			{
+				return AllocateSlow( size, alignment );
+			}
+
+			m_offset = static_cast<u32>( end );
+			return reinterpret_cast<void*>( aligned );
+		}
+
+		// Uninitialized storage for count objects of T.
+		template<typename T>
+		T* AllocateArray( s32 count )
+		{
+			return static_cast<T*>( Allocate( static_cast<u32>( count * sizeof( T ) ), __alignof( T ) ) );
+		}
+
+		// Takes back the most recent allocation so the next one can reuse its space; any other
+		// pointer is ignored and released with the next Rewind or Reset.
+		void Free( void* p, u32 size )
+		{
+			if( m_pBlock != NULL && static_cast<byte*>( p ) + size == m_pBlock + m_offset )
+			{
+				m_offset = static_cast<u32>( static_cast<byte*>( p ) - m_pBlock );
+			}
+		}
+
+		Marker GetMarker() const;
+
+		// Releases everything allocated since the marker was taken. Markers must be rewound in reverse order.
+		void Rewind( const Marker& marker );
+
+		void Reset();
+
+		// Frees the cached blocks past the one in use.
+		void Trim();
+
+		// Frees every block. Nothing allocated from the arena may still be in use.
+		void Release();
+
+		// Bytes handed out since the last Reset, including alignment padding and unused block tails.
+		u32 GetUsedSize() const;
+		u32 GetCapacity() const;
+
+	private:
+		LinearArena( const LinearArena& copy );
+		LinearArena& operator = ( const LinearArena& copy );
+
+		struct Block
+		{
+			byte* pMemory;
+			u32 Size;
+		};
+
+		void* AllocateSlow( u32 size, u32 alignment );
+		void SetCurrent( s32 block, u32 offset );
+
+	private:
+		std::vector<Block> m_blocks;
+		u32 m_blockSize;
+
+		s32 m_current;
+		byte* m_pBlock;
+		u32 m_blockCapacity;
+		u32 m_offset;
+	};
+
+	// Rewinds an arena to where it was when the scope was opened.
+	class LinearArenaScope
+	{
+	public:
+		explicit LinearArenaScope( LinearArena& arena )
+			: m_arena( arena )
+			, m_marker( arena.GetMarker() )
+		{
+		}
+
+		~LinearArenaScope()
+		{
+			m_arena.Rewind( m_marker );
+		}
+
+	private:
+		LinearArenaScope( const LinearArenaScope& copy );
+		LinearArenaScope& operator = ( const LinearArenaScope& copy );
+
+	private:
+		LinearArena& m_arena;
+		LinearArena::Marker m_marker;
+	};
+
+	// One LinearArena per thread, created the first time the thread calls Get.
+	class TOMATO_API ThreadArena
+	{
+	public:
+		static LinearArena& Get();
+
+		// Resets the arenas of all threads, e.g. at the end of a frame.
+		// No thread may be using its arena during the call.
+		static void ResetAll();
+
+		// Frees the blocks of all arenas, including those of threads that have exited.
+		// No thread may be using its arena during the call.
+		static void ReleaseAll();
+	};
+
+	// STL allocator on top of a LinearArena.
+	//
+	// deallocate only takes back the most recent allocation, so reserve containers up front where
+	// possible. A container must be destroyed or cleared before its memory is rewound.
+	template<typename T>
+	class ArenaAllocator
+	{
+	public:
+		typedef T value_type;
+		typedef T* pointer;
+		typedef const T* const_pointer;
+		typedef T& reference;
+		typedef const T& const_reference;
+		typedef size_t size_type;
+		typedef ptrdiff_t difference_type;
+
+		template<typename U>
+		struct rebind
+		{
+			typedef ArenaAllocator<U> other;
+		};
+
+		explicit ArenaAllocator( LinearArena& arena )
+			: m_pArena( &arena )
+		{
+		}
+
+		template<typename U>
+		ArenaAllocator( const ArenaAllocator<U>& other )
+			: m_pArena( &other.GetArena() )
+		{
+		}
+
+		LinearArena& GetArena() const { return *m_pArena; }
+
+		pointer address( reference value ) const { return &value; }
+		const_pointer address( const_reference value ) const { return &value; }
+
+		pointer allocate( size_type count, const void* = NULL )
+		{
+			return static_cast<pointer>( m_pArena->Allocate( static_cast<u32>( count * sizeof( T ) ), __alignof( T ) ) );
+		}
+
+		void deallocate( pointer p, size_type count )
+		{
+			m_pArena->Free( p, static_cast<u32>( count * sizeof( T ) ) );
+		}
+
+		size_type max_size() const { return static_cast<size_type>( 0x7FFFFFFF ) / sizeof( T ); }
+
+		void construct( pointer p, const T& value ) { new( static_cast<void*>( p ) ) T( value ); }
+		void destroy( pointer p ) { p->~T(); }
+
+	private:
+		LinearArena* m_pArena;
+	};
+
+	template<typename T, typename U>
+	bool operator == ( const ArenaAllocator<T>& a, const ArenaAllocator<U>& b ) { return &a.GetArena() == &b.GetArena(); }
+
+	template<typename T, typename U>
+	bool operator != ( const ArenaAllocator<T>& a, const ArenaAllocator<U>& b ) { return &a.GetArena() != &b.GetArena(); }
+
+	// std::vector on an arena: ArenaVector<s32>::Type indices( ArenaAllocator<s32>( arena ) );
+	template<typename T>
+	struct ArenaVector
+	{
+		typedef std::vector<T, ArenaAllocator<T> > Type;
+	};
+}
@@ -4,68 +4,362 @@
 
 namespace Tomato
 {
+	// Growable byte buffer.
+	//
+	// Size is the number of bytes in use and capacity the number allocated. Growing within the
+	// capacity is free; growing beyond it reallocates once with room to spare, and the new
+	// bytes are left uninitialized. The memory can also be adopted from outside the block, e.g.
+	// a receive buffer or a mapped file; adopted memory is never freed by the block, and the
+	// first growth beyond its capacity copies the contents to memory the block owns.
+	//
+	// A block can instead be backed by a reservation of address space (see VirtualMemory). It then
+	// grows by committing pages in place, so neither the data nor GetData() ever move until the
+	// reserved size is exceeded, at which point the contents move to the heap.
 	class MemoryBlock 
 	{
 	public:
-		MemoryBlock( s32 initialCapacity )
-			: m_buffer( initialCapacity )
+		MemoryBlock()
+			: m_pData( NULL )
+			, m_size( 0 )
+			, m_capacity( 0 )
+			, m_reservedSize( 0 )
+			, m_storage( Storage::Heap )
 		{
 		}
 
+		// The initial bytes are zeroed.
+		explicit MemoryBlock( s32 initialSize )
+			: m_pData( NULL )
+			, m_size( 0 )
+			, m_capacity( 0 )
+			, m_reservedSize( 0 )
+			, m_storage( Storage::Heap )
+		{
+			Resize( initialSize );
+			Reset();
+		}
+
 		MemoryBlock( const MemoryBlock& copy )
-			: m_buffer( copy.m_buffer )
+			: m_pData( NULL )
+			, m_size( 0 )
+			, m_capacity( 0 )
+			, m_reservedSize( 0 )
+			, m_storage( Storage::Heap )
 		{
+			Assign( copy.m_pData, copy.m_size );
 		}
 
 		MemoryBlock( const byte* pBuffer, s32 bufferLength )
-			: m_buffer( bufferLength )
+			: m_pData( NULL )
+			, m_size( 0 )
+			, m_capacity( 0 )
+			, m_reservedSize( 0 )
+			, m_storage( Storage::Heap )
 		{
-			std::memcpy( 
-				reinterpret_cast<void*>( &( m_buffer[ 0 ] ) ),
-				reinterpret_cast<const void*>( pBuffer ),
-				static_cast<std::size_t>( bufferLength ) );
+			Assign( pBuffer, bufferLength );
 		}
 
 		MemoryBlock( const char* pBuffer, s32 bufferLength )
-			: m_buffer( bufferLength )
+			: m_pData( NULL )
+			, m_size( 0 )
+			, m_capacity( 0 )
+			, m_reservedSize( 0 )
+			, m_storage( Storage::Heap )
 		{
-			std::memcpy( 
-				reinterpret_cast<void*>( &( m_buffer[ 0 ] ) ),
-				reinterpret_cast<const void*>( pBuffer ),
-				static_cast<std::size_t>( bufferLength ) );
+			Assign( pBuffer, bufferLength );
 		}
 
 		// .dtor: non-virtual means "DO NOT INHERIT".
 		~MemoryBlock()
 		{
+			FreeMemory();
 		}
 
 	public:
+		// Copies the bytes in use, reusing the current allocation when it is large enough.
 		MemoryBlock& operator = ( const MemoryBlock& copy )
 		{
-			m_buffer = copy.m_buffer;
+			if( this != &copy )
+			{
+				Assign( copy.m_pData, copy.m_size );
+			}
 			return *this;
 		}
 
+		void Assign( const void* pBuffer, s32 bufferLength )
+		{
+			Assert( bufferLength >= 0 );
+
+			m_size = 0;
+			Resize( bufferLength );
+
+			if( bufferLength > 0 )
+			{
+				::CopyMemory( m_pData, pBuffer, bufferLength );
+			}
+		}
+
+		void Swap( MemoryBlock& other )
+		{
+			byte* pData = m_pData;
+			s32 size = m_size;
+			s32 capacity = m_capacity;
+			s32 reservedSize = m_reservedSize;
+			Storage::Type storage = m_storage;
+
+			m_pData = other.m_pData;
+			m_size = other.m_size;
+			m_capacity = other.m_capacity;
+			m_reservedSize = other.m_reservedSize;
+			m_storage = other.m_storage;
+
+			other.m_pData = pData;
+			other.m_size = size;
+			other.m_capacity = capacity;
+			other.m_reservedSize = reservedSize;
+			other.m_storage = storage;
+		}
+
+		// Takes over the memory of source without copying and leaves source empty.
+		void Move( MemoryBlock& source )
+		{
+			if( this != &source )
+			{
+				FreeMemory();
+				Swap( source );
+			}
+		}
+
+		// Uses size bytes of external memory with room for capacity bytes. The memory must stay
+		// valid while the block refers to it and is not freed by the block.
+		void Adopt( void* pMemory, s32 size, s32 capacity )
+		{
+			Assert( pMemory != NULL || capacity == 0 );
+			Assert( 0 <= size && size <= capacity );
+
+			FreeMemory();
+
+			m_pData = static_cast<byte*>( pMemory );
+			m_size = size;
+			m_capacity = capacity;
+			m_storage = Storage::External;
+		}
+
+		// Moves the contents to a reservation of maxCapacity bytes of address space, committing only
+		// what is in use. Returns false, leaving the block as it was, if the address space is not available.
+		bool ReserveAddressSpace( s32 maxCapacity )
+		{
+			Assert( maxCapacity >= m_size );
+
+			u32 reservedSize = VirtualMemory::RoundUpToPageSize( static_cast<u32>( maxCapacity ) );
+
+			byte* pData = static_cast<byte*>( VirtualMemory::Reserve( reservedSize ) );
+			if( pData == NULL )
+			{
+				return false;
+			}
+
+			u32 committedSize = VirtualMemory::RoundUpToPageSize( static_cast<u32>( m_size ) );
+			if( !VirtualMemory::Commit( pData, committedSize ) )
+			{
+				VirtualMemory::Release( pData );
+				return false;
+			}
+
+			s32 size = m_size;
+			if( size > 0 )
+			{
+				::CopyMemory( pData, m_pData, size );
+			}
+
+			FreeMemory();
+
+			m_pData = pData;
+			m_size = size;
+			m_capacity = static_cast<s32>( committedSize );
+			m_reservedSize = static_cast<s32>( reservedSize );
+			m_storage = Storage::Virtual;
+
+			return true;
+		}
+
+		bool OwnsMemory() const { return m_storage != Storage::External; }
+
+		bool IsAddressSpaceReserved() const { return m_storage == Storage::Virtual; }
+
+		// Size of the address space reservation, or 0 when the block is not backed by one.
+		s32 GetReservedSize() const { return m_reservedSize; }
+
+		// Zeroes the bytes in use.
 		void Reset()
 		{
-			std::memset( &m_buffer[ 0 ], 0, m_buffer.size() );
+			if( m_size > 0 )
+			{
+				::ZeroMemory( m_pData, m_size );
+			}
 		}
 
 		s32 GetSize() const
 		{
-			return m_buffer.size();
+			return m_size;
 		}
 
+		s32 GetCapacity() const
+		{
+			return m_capacity;
+		}
+
+		// Bytes past the previous size are uninitialized.
 		void Resize( s32 size )
 		{
-			m_buffer.resize( size );
+			Assert( size >= 0 );
+
+			if( size > m_capacity )
+			{
+				// Committing pages in place costs no copy, so a reservation only commits what is needed.
+				Grow( ( m_storage == Storage::Virtual ) ? size : Math::Max( size, m_capacity + m_capacity / 2 ) );
+			}
+
+			m_size = size;
 		}
 
-		byte& operator [] ( s32 index ) { return m_buffer[ index ]; }
-		const byte& operator [] ( s32 index ) const { return m_buffer[ index ]; }
+		void Reserve( s32 capacity )
+		{
+			if( capacity > m_capacity )
+			{
+				Grow( capacity );
+			}
+		}
+
+		void Clear()
+		{
+			m_size = 0;
+		}
+
+		// Gives back the memory beyond the size. A reservation decommits its unused pages and keeps
+		// its address; heap memory is reallocated to the size. Adopted memory is left as it is.
+		void Trim()
+		{
+			if( m_storage == Storage::Virtual )
+			{
+				u32 committedSize = VirtualMemory::RoundUpToPageSize( static_cast<u32>( m_size ) );
+				if( committedSize < static_cast<u32>( m_capacity ) )
+				{
+					VirtualMemory::Decommit( m_pData + committedSize, m_capacity - committedSize );
+					m_capacity = static_cast<s32>( committedSize );
+				}
+			}
+			else if( m_storage == Storage::Heap && m_size < m_capacity )
+			{
+				if( m_size == 0 )
+				{
+					FreeMemory();
+					return;
+				}
+
+				byte* pData = static_cast<byte*>( std::realloc( m_pData, m_size ) );
+				if( pData != NULL )
+				{
+					m_pData = pData;
+					m_capacity = m_size;
+				}
+			}
+		}
+
+		byte* GetData() { return m_pData; }
+		const byte* GetData() const { return m_pData; }
+
+		byte& operator [] ( s32 index ) { Assert( 0 <= index && index < m_size ); return m_pData[ index ]; }
+		const byte& operator [] ( s32 index ) const { Assert( 0 <= index && index < m_size ); return m_pData[ index ]; }
+
+	private:
+		struct Storage
+		{
+			enum Type
+			{
+				Heap,
+				External,
+				Virtual,
+			};
+		};
+
+		void Grow( s32 capacity )
+		{
+			if( m_storage == Storage::Virtual )
+			{
+				if( capacity <= m_reservedSize )
+				{
+					u32 committedSize = VirtualMemory::RoundUpToPageSize( static_cast<u32>( capacity ) );
+					if( committedSize > static_cast<u32>( m_reservedSize ) )
+					{
+						committedSize = static_cast<u32>( m_reservedSize );
+					}
+
+					bool bCommitted = VirtualMemory::Commit( m_pData + m_capacity, committedSize - m_capacity );
+					Assert( bCommitted );
+
+					if( bCommitted )
+					{
+						m_capacity = static_cast<s32>( committedSize );
+						return;
+					}
+				}
+
+				// The reservation is too small; continue on the heap.
+				capacity = Math::Max( capacity, m_capacity + m_capacity / 2 );
+			}
+
+			byte* pData;
+			if( m_storage == Storage::Heap )
+			{
+				// realloc can often extend the allocation in place instead of copying.
+				pData = static_cast<byte*>( std::realloc( m_pData, capacity ) );
+			}
+			else
+			{
+				pData = static_cast<byte*>( std::malloc( capacity ) );
+				if( pData != NULL && m_size > 0 )
+				{
+					::CopyMemory( pData, m_pData, m_size );
+				}
+			}
+
+			Assert( pData != NULL );
+
+			if( m_storage == Storage::Virtual )
+			{
+				VirtualMemory::Release( m_pData );
+			}
+
+			m_pData = pData;
+			m_capacity = capacity;
+			m_reservedSize = 0;
+			m_storage = Storage::Heap;
+		}
+
+		void FreeMemory()
+		{
+			if( m_storage == Storage::Heap )
+			{
+				std::free( m_pData );
+			}
+			else if( m_storage == Storage::Virtual )
+			{
+				VirtualMemory::Release( m_pData );
+			}
+
+			m_pData = NULL;
+			m_size = 0;
+			m_capacity = 0;
+			m_reservedSize = 0;
+			m_storage = Storage::Heap;
+		}
 
 	private:
-		std::vector<byte> m_buffer;
+		byte* m_pData;
+		s32 m_size;
+		s32 m_capacity;
+		s32 m_reservedSize;
+		Storage::Type m_storage;
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,266 @@
+#include "TomatoPCH.h"
+
+#include "MessageRing.h"
+
+namespace Tomato
+{
+	namespace
+	{
+		// Every message starts with two u32s: the bytes it spans in the ring, prefix and padding
+		// included, and the length of the message. A span with PaddingFlag set only skips the
+		// rest of the ring up to its end.
+		enum
+		{
+			PrefixSize = 8,
+			FrameAlignment = 8,
+			MinCapacity = 64,
+		};
+
+		const u32 PaddingFlag = 0x80000000;
+
+		inline u32 RoundUpCapacity( u32 capacity )
+		{
+			Assert( capacity <= PaddingFlag );
+
+			u32 result = MinCapacity;
+			while( result < capacity )
+			{
+				result <<= 1;
+			}
+
+			return result;
+		}
+
+		inline u32 GetFrameSize( u32 length )
+		{
+			return ( PrefixSize + length + FrameAlignment - 1 ) & ~static_cast<u32>( FrameAlignment - 1 );
+		}
+
+		inline u8* AllocateRing( u32 capacity )
+		{
+			u8* pBuffer = static_cast<u8*>( ::_aligned_malloc( capacity, 64 ) );
+			Assert( pBuffer != NULL );
+
+			::ZeroMemory( pBuffer, capacity );
+			return pBuffer;
+		}
+
+		inline volatile LONG* GetPrefix( u8* pBuffer, u32 offset )
+		{
+			return reinterpret_cast<volatile LONG*>( pBuffer + offset );
+		}
+	}
+
+	SpscByteRing::SpscByteRing( u32 capacity )
+		: m_pBuffer( NULL )
+		, m_capacity( RoundUpCapacity( capacity ) )
+		, m_writeIndex( 0 )
+		, m_pendingWriteIndex( 0 )
+		, m_cachedReadIndex( 0 )
+		, m_readIndex( 0 )
+		, m_pendingReadIndex( 0 )
+		, m_cachedWriteIndex( 0 )
+	{
+		m_pBuffer = AllocateRing( m_capacity );
+	}
+
+	SpscByteRing::~SpscByteRing()
+	{
+		::_aligned_free( m_pBuffer );
+	}
+
+	u8* SpscByteRing::BeginWrite( u32 length )
+	{
+		u32 frameSize = GetFrameSize( length );
+		Assert( frameSize <= m_capacity / 2 );
+
+		u32 writeIndex = static_cast<u32>( m_writeIndex );
+		u32 offset = writeIndex & ( m_capacity - 1 );
+		u32 contiguous = m_capacity - offset;
+		u32 required = ( frameSize > contiguous ) ? contiguous + frameSize : frameSize;
+
+		if( required > m_capacity - ( writeIndex - m_cachedReadIndex ) )
+		{
+			m_cachedReadIndex = static_cast<u32>( m_readIndex );
+
+			if( required > m_capacity - ( writeIndex - m_cachedReadIndex ) )
+			{
+				return NULL;
+			}
+		}
+
+		if( frameSize > contiguous )
+		{
+			*GetPrefix( m_pBuffer, offset ) = static_cast<LONG>( PaddingFlag | contiguous );
+
+			writeIndex += contiguous;
+			offset = 0;
+		}
+
+		volatile LONG* pPrefix = GetPrefix( m_pBuffer, offset );
+		pPrefix[ 0 ] = static_cast<LONG>( frameSize );
+		pPrefix[ 1 ] = static_cast<LONG>( length );
+
+		m_pendingWriteIndex = writeIndex + frameSize;
+
+		return m_pBuffer + offset + PrefixSize;
+	}
+
+	void SpscByteRing::EndWrite( u8* pData )
+	{
+		Assert( pData != NULL );
+
+		// The message must be complete before the consumer can see the new index.
+		_ReadWriteBarrier();
+		m_writeIndex = static_cast<LONG>( m_pendingWriteIndex );
+	}
+
+	const u8* SpscByteRing::BeginRead( u32& length )
+	{
+		u32 readIndex = static_cast<u32>( m_readIndex );
+
+		if( readIndex == m_cachedWriteIndex )
+		{
+			m_cachedWriteIndex = static_cast<u32>( m_writeIndex );
+
+			if( readIndex == m_cachedWriteIndex )
+			{
+				return NULL;
+			}
+		}
+
+		_ReadWriteBarrier();
+
+		u32 offset = readIndex & ( m_capacity - 1 );
+		u32 frameSize = static_cast<u32>( *GetPrefix( m_pBuffer, offset ) );
+
+		// A padding span is always followed by a message at the start of the ring.
+		if( ( frameSize & PaddingFlag ) != 0 )
+		{
+			readIndex += frameSize & ~PaddingFlag;
+			offset = 0;
+			frameSize = static_cast<u32>( *GetPrefix( m_pBuffer, 0 ) );
+		}
+
+		length = static_cast<u32>( GetPrefix( m_pBuffer, offset )[ 1 ] );
+		m_pendingReadIndex = readIndex + frameSize;
+
+		return m_pBuffer + offset + PrefixSize;
+	}
+
+	void SpscByteRing::EndRead()
+	{
+		// The message must be read before the producer can overwrite it.
+		_ReadWriteBarrier();
+		m_readIndex = static_cast<LONG>( m_pendingReadIndex );
+	}
+
+	MpscByteRing::MpscByteRing( u32 capacity )
+		: m_pBuffer( NULL )
+		, m_capacity( RoundUpCapacity( capacity ) )
+		, m_reserveIndex( 0 )
+		, m_readIndex( 0 )
+		, m_pendingReadIndex( 0 )
+	{
+		m_pBuffer = AllocateRing( m_capacity );
+	}
+
+	MpscByteRing::~MpscByteRing()
+	{
+		::_aligned_free( m_pBuffer );
+	}
+
+	u8* MpscByteRing::BeginWrite( u32 length )
+	{
+		u32 frameSize = GetFrameSize( length );
+		Assert( frameSize <= m_capacity / 2 );
+
+		u32 reserveIndex;
+		u32 offset;
+		u32 contiguous;
+		u32 required;
+
+		for( ;; )
+		{
+			reserveIndex = static_cast<u32>( m_reserveIndex );
+			offset = reserveIndex & ( m_capacity - 1 );
+			contiguous = m_capacity - offset;
+			required = ( frameSize > contiguous ) ? contiguous + frameSize : frameSize;
+
+			if( required > m_capacity - ( reserveIndex - static_cast<u32>( m_readIndex ) ) )
+			{
+				return NULL;
+			}
+
+			if( ::InterlockedCompareExchange( &m_reserveIndex, static_cast<LONG>( reserveIndex + required ), static_cast<LONG>( reserveIndex ) ) == static_cast<LONG>( reserveIndex ) )
+			{
+				break;
+			}
+		}
+
+		if( frameSize > contiguous )
+		{
+			*GetPrefix( m_pBuffer, offset ) = static_cast<LONG>( PaddingFlag | contiguous );
+			offset = 0;
+		}
+
+		// The span is published by EndWrite; until then the consumer sees a zero prefix.
+		GetPrefix( m_pBuffer, offset )[ 1 ] = static_cast<LONG>( length );
+
+		return m_pBuffer + offset + PrefixSize;
+	}
+
+	void MpscByteRing::EndWrite( u8* pData )
+	{
+		volatile LONG* pPrefix = GetPrefix( pData - PrefixSize, 0 );
+
+		_ReadWriteBarrier();
+		pPrefix[ 0 ] = static_cast<LONG>( GetFrameSize( static_cast<u32>( pPrefix[ 1 ] ) ) );
+	}
+
+	const u8* MpscByteRing::BeginRead( u32& length )
+	{
+		u32 readIndex = static_cast<u32>( m_readIndex );
+		u32 offset = readIndex & ( m_capacity - 1 );
+		u32 frameSize = static_cast<u32>( *GetPrefix( m_pBuffer, offset ) );
+
+		if( ( frameSize & PaddingFlag ) != 0 )
+		{
+			// Release the padding at once; the message after it may not be published yet.
+			u32 paddingSize = frameSize & ~PaddingFlag;
+			::ZeroMemory( m_pBuffer + offset, PrefixSize );
+
+			_ReadWriteBarrier();
+			readIndex += paddingSize;
+			m_readIndex = static_cast<LONG>( readIndex );
+
+			offset = 0;
+			frameSize = static_cast<u32>( *GetPrefix( m_pBuffer, 0 ) );
+		}
+
+		if( frameSize == 0 )
+		{
+			return NULL;
+		}
+
+		_ReadWriteBarrier();
+
+		length = static_cast<u32>( GetPrefix( m_pBuffer, offset )[ 1 ] );
+		m_pendingReadIndex = readIndex + frameSize;
+
+		return m_pBuffer + offset + PrefixSize;
+	}
+
+	void MpscByteRing::EndRead()
+	{
+		u32 readIndex = static_cast<u32>( m_readIndex );
+		u32 frameSize = m_pendingReadIndex - readIndex;
+
+		// Producers rely on unused space being zero; the message space is zeroed, not just the
+		// prefix, because later messages may start anywhere in it.
+		::ZeroMemory( m_pBuffer + ( readIndex & ( m_capacity - 1 ) ), frameSize );
+
+		_ReadWriteBarrier();
+		m_readIndex = static_cast<LONG>( m_pendingReadIndex );
+	}
+}
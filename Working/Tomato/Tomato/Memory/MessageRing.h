@@ -0,0 +1,184 @@
+#pragma once
+
+namespace Tomato
+{
+	// Fixed-size ring of variable-length messages from one producer thread to one consumer thread.
+	//
+	// Neither side ever waits or takes a lock: a write fails when the ring is full and a read
+	// when it is empty. Each message is framed by an 8-byte prefix and padded to 8 bytes; one
+	// that would straddle the end of the ring starts over at the beginning instead. The two
+	// indices live on separate cache lines and each side keeps a copy of the other's index, so
+	// the shared lines are only touched when the copy says the ring is full or empty.
+	//
+	// Messages are written and read in place:
+	//		u8* pData = ring.BeginWrite( length ); ... ring.EndWrite( pData );
+	//		const u8* pData = ring.BeginRead( length ); ... ring.EndRead();
+	class TOMATO_API SpscByteRing
+	{
+	public:
+		// Capacity is rounded up to a power of two; a message may use at most half of it.
+		explicit SpscByteRing( u32 capacity );
+		~SpscByteRing();
+
+	public:
+		// Producer. Returns NULL if the ring is full.
+		u8* BeginWrite( u32 length );
+		void EndWrite( u8* pData );
+
+		// Consumer. Returns NULL if the ring is empty.
+		const u8* BeginRead( u32& length );
+		void EndRead();
+
+		u32 GetCapacity() const { return m_capacity; }
+
+	private:
+		SpscByteRing( const SpscByteRing& copy );
+		SpscByteRing& operator = ( const SpscByteRing& copy );
+
+	private:
+		enum { CacheLineSize = 64 };
+
+		u8* m_pBuffer;
+		u32 m_capacity;
+
+		u8 m_producerPadding[ CacheLineSize ];
+
+		volatile LONG m_writeIndex;
+		u32 m_pendingWriteIndex;
+		u32 m_cachedReadIndex;
+
+		u8 m_consumerPadding[ CacheLineSize ];
+
+		volatile LONG m_readIndex;
+		u32 m_pendingReadIndex;
+		u32 m_cachedWriteIndex;
+
+		u8 m_endPadding[ CacheLineSize ];
+	};
+
+	// SpscByteRing that any number of producer threads can write to.
+	//
+	// Producers claim space with a compare-and-swap on a shared index and publish a message by
+	// filling in its prefix, so they never wait for each other to finish copying. The consumer
+	// zeroes the space of every message it releases, which is how it tells an unpublished prefix
+	// from a published one; it stops at the oldest message not yet published.
+	class TOMATO_API MpscByteRing
+	{
+	public:
+		// Capacity is rounded up to a power of two; a message may use at most half of it.
+		explicit MpscByteRing( u32 capacity );
+		~MpscByteRing();
+
+	public:
+		// Producers. Returns NULL if the ring is full.
+		u8* BeginWrite( u32 length );
+		void EndWrite( u8* pData );
+
+		// Consumer. Returns NULL if the ring is empty or the next message is still being written.
+		const u8* BeginRead( u32& length );
+		void EndRead();
+
+		u32 GetCapacity() const { return m_capacity; }
+
+	private:
+		MpscByteRing( const MpscByteRing& copy );
+		MpscByteRing& operator = ( const MpscByteRing& copy );
+
+	private:
+		enum { CacheLineSize = 64 };
+
+		u8* m_pBuffer;
+		u32 m_capacity;
+
+		u8 m_producerPadding[ CacheLineSize ];
+
+		volatile LONG m_reserveIndex;
+
+		u8 m_consumerPadding[ CacheLineSize ];
+
+		volatile LONG m_readIndex;
+		u32 m_pendingReadIndex;
+
+		u8 m_endPadding[ CacheLineSize ];
+	};
+
+	// Passes MessageStreamBase messages, header and payload, between threads through a byte ring.
+	// ByteRing is SpscByteRing or MpscByteRing.
+	template<u32 HeaderLength, typename ByteRing>
+	class MessageRingBase
+	{
+	public:
+		explicit MessageRingBase( u32 capacity )
+			: m_ring( capacity )
+		{
+		}
+
+	public:
+		// Copies the message into the ring. Returns false if the ring is full.
+		bool TryWrite( const MessageStreamBase<HeaderLength>& message )
+		{
+			u32 length = message.GetLength();
+
+			u8* pData = m_ring.BeginWrite( length );
+			if( pData == NULL )
+			{
+				return false;
+			}
+
+			::CopyMemory( pData, message.GetBuffer(), length );
+			m_ring.EndWrite( pData );
+
+			return true;
+		}
+
+		// Copies the next message out of the ring into message. Returns false if there is none.
+		bool TryRead( MessageStreamBase<HeaderLength>& message )
+		{
+			u32 length;
+			const u8* pData = m_ring.BeginRead( length );
+			if( pData == NULL )
+			{
+				return false;
+			}
+
+			message.Reset();
+			message.WriteHeader( pData, HeaderLength );
+			message.Write( pData + HeaderLength, length - HeaderLength );
+
+			m_ring.EndRead();
+
+			return true;
+		}
+
+		// Reads the next message in place; the view is valid until EndRead.
+		bool BeginRead( MessageStreamViewBase<HeaderLength>& view )
+		{
+			u32 length;
+			const u8* pData = m_ring.BeginRead( length );
+			if( pData == NULL )
+			{
+				return false;
+			}
+
+			view = MessageStreamViewBase<HeaderLength>( pData, length );
+			return true;
+		}
+
+		void EndRead()
+		{
+			m_ring.EndRead();
+		}
+
+		ByteRing& GetByteRing() { return m_ring; }
+
+	private:
+		MessageRingBase( const MessageRingBase& copy );
+		MessageRingBase& operator = ( const MessageRingBase& copy );
+
+	private:
+		ByteRing m_ring;
+	};
+
+	typedef MessageRingBase<2, SpscByteRing> SpscMessageRing;
+	typedef MessageRingBase<2, MpscByteRing> MpscMessageRing;
+}
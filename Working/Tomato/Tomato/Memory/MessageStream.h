@@ -17,9 +17,9 @@ namespace Tomato
 		{
 		}
 
-		// Read-only
+		// Read-only; only the bytes written to copy are duplicated. MessageStreamView reads without copying.
 		MessageStreamBase( const MessageStreamBase& copy )
-			: m_buffer( copy.m_buffer )
+			: m_buffer( copy.m_buffer.GetData(), static_cast<s32>( HeaderLength + copy.m_writePosition ) )
 			, m_readPosition( 0 )
 			, m_writePosition( copy.m_writePosition )
 		{
@@ -40,34 +40,52 @@ namespace Tomato
 
 		MessageStreamBase& operator = ( const MessageStreamBase& copy )
 		{
-			m_buffer = copy.m_buffer;
+			if( this != &copy )
+			{
+				m_buffer.Assign( copy.m_buffer.GetData(), static_cast<s32>( HeaderLength + copy.m_writePosition ) );
+			}
 			m_readPosition = 0;
 			m_writePosition = copy.m_writePosition;
 
 			return *this;
 		}
 
+		// Exchanges the contents of two streams without copying.
+		void Swap( MessageStreamBase& other )
+		{
+			m_buffer.Swap( other.m_buffer );
+
+			u32 readPosition = m_readPosition;
+			u32 writePosition = m_writePosition;
+
+			m_readPosition = other.m_readPosition;
+			m_writePosition = other.m_writePosition;
+
+			other.m_readPosition = readPosition;
+			other.m_writePosition = writePosition;
+		}
+
 	public:
 
 		// Buffer = Header + Payload
-		u8* GetBuffer() { return &m_buffer[ 0 ]; }
-		const u8* GetBuffer() const { return &m_buffer[ 0 ]; }
+		u8* GetBuffer() { return m_buffer.GetData(); }
+		const u8* GetBuffer() const { return m_buffer.GetData(); }
 		u32 GetLength() const
 		{
 			return HeaderLength + m_writePosition;
 		}
 
 		// Header
-		u8* GetHeader() { return &m_buffer[ 0 ]; }
-		const u8* GetHeader() const { return &m_buffer[ 0 ]; }
+		u8* GetHeader() { return m_buffer.GetData(); }
+		const u8* GetHeader() const { return m_buffer.GetData(); }
 		u32 GetHeaderLength() const
 		{
 			return HeaderLength;
 		}
 
 		// Payload
-		u8* GetPayload() { return &m_buffer[ HeaderLength ]; }
-		const u8* GetPayload() const { return &m_buffer[ HeaderLength ]; }
+		u8* GetPayload() { return m_buffer.GetData() + HeaderLength; }
+		const u8* GetPayload() const { return m_buffer.GetData() + HeaderLength; }
 		u32 GetPayloadLength() const
 		{
 			return m_writePosition;
@@ -93,7 +111,21 @@ namespace Tomato
 
 		u32 GetCapacity() const
 		{
-			return m_buffer.GetSize();
+			return m_buffer.GetCapacity();
+		}
+
+		// Backs the stream with a reservation of address space for up to maxPayloadLength bytes of
+		// payload, so writing never copies what was written before.
+		bool ReserveAddressSpace( u32 maxPayloadLength )
+		{
+			return m_buffer.ReserveAddressSpace( static_cast<s32>( HeaderLength + maxPayloadLength ) );
+		}
+
+		// Gives back the memory beyond what has been written, e.g. after a burst of large messages.
+		void Trim()
+		{
+			m_buffer.Resize( static_cast<s32>( HeaderLength + m_writePosition ) );
+			m_buffer.Trim();
 		}
 
 		void Resize( u32 payloadLength, bool bReset = true, bool bClear = false )
@@ -122,20 +154,47 @@ namespace Tomato
 		{
 			if( size > 0 )
 			{
-				u32 bufferSize = static_cast<u32>( m_buffer.GetSize() );
-				if( HeaderLength + m_writePosition + size > bufferSize )
-				{
-					do
-					{
-						bufferSize *= 2;
-					} 
-					while( HeaderLength + m_writePosition + size > bufferSize );
+				::CopyMemory( WriteBytes( size ), pBuffer, size );
+			}
+		}
 
-					m_buffer.Resize( bufferSize );
-				}
+		// Appends size uninitialized bytes and returns where they start, for the caller to fill
+		// in place. The pointer stays valid until the next write or resize.
+		u8* WriteBytes( u32 size )
+		{
+			// Growing keeps the written bytes and leaves the rest uninitialized; the block
+			// reserves room to spare, or commits pages in place when it holds a reservation.
+			u32 requiredSize = HeaderLength + m_writePosition + size;
+			if( requiredSize > static_cast<u32>( m_buffer.GetSize() ) )
+			{
+				m_buffer.Resize( static_cast<s32>( requiredSize ) );
+			}
+
+			u8* pBytes = m_buffer.GetData() + HeaderLength + m_writePosition;
+			m_writePosition += size;
+
+			return pBytes;
+		}
 
-				::CopyMemory( &( m_buffer[ HeaderLength + m_writePosition ] ), pBuffer, size );
-				m_writePosition += size;
+		// Copies count values of a trivially copyable type, e.g. s32, f32, Vector3 or Matrix4,
+		// as one block in the native byte order.
+		template<typename T>
+		void WriteArray( const T* pValues, u32 count )
+		{
+			Write( pValues, count * sizeof( T ) );
+		}
+
+		// WriteArray for a peer of the other byte order. T must consist of scalars of scalarSize
+		// bytes, e.g. 4 for Vector3 and Matrix4.
+		template<typename T>
+		void WriteArraySwapped( const T* pValues, u32 count, u32 scalarSize = sizeof( T ) )
+		{
+			Assert( sizeof( T ) % scalarSize == 0 );
+
+			u32 size = count * sizeof( T );
+			if( size > 0 )
+			{
+				ByteOrder::Swap( WriteBytes( size ), pValues, size / scalarSize, scalarSize );
 			}
 		}
 
@@ -146,7 +205,7 @@ namespace Tomato
 			if( ( size > 0 )
 				&& ( size <= HeaderLength ) )
 			{
-				::CopyMemory( &( m_buffer[ 0 ] ), pBuffer, size );
+				::CopyMemory( m_buffer.GetData(), pBuffer, size );
 			}
 		}
 
@@ -162,6 +221,19 @@ namespace Tomato
 		void WriteF64( f64 value ) { Write<f64>( value ); }
 		void WriteBool( bool value ) { Write<bool>( value ); }
 
+		// Variable-length integers (see VarInt); the signed ones are zigzag encoded.
+		void WriteVarU32( u32 value ) { u8 bytes[ VarInt::MaxLength32 ]; Write( bytes, VarInt::Encode( bytes, value ) ); }
+		void WriteVarS32( s32 value ) { WriteVarU32( VarInt::ZigZag( value ) ); }
+		void WriteVarU64( u64 value ) { u8 bytes[ VarInt::MaxLength64 ]; Write( bytes, VarInt::Encode( bytes, value ) ); }
+		void WriteVarS64( s64 value ) { WriteVarU64( VarInt::ZigZag( value ) ); }
+
+		// Stores value quantized to bits within [min, max] (see Quantization) in ( bits + 7 ) / 8 bytes.
+		void WriteQuantizedF32( f32 value, f32 min, f32 max, u32 bits )
+		{
+			u32 quantized = Quantization::Quantize( value, min, max, bits );
+			Write( &quantized, ( bits + 7 ) / 8 );
+		}
+
 		void WriteHeaderU8( unsigned __int8 value ) { WriteHeader<unsigned __int8>( value ); }
 		void WriteHeaderS8( __int8 value ) { WriteHeader<__int8>( value ); }
 		void WriteHeaderU16( unsigned __int16 value ) { WriteHeader<unsigned __int16>( value ); }
@@ -180,18 +252,47 @@ namespace Tomato
 
 			if( size > 0 )
 			{
-				::CopyMemory( pBuffer, &( m_buffer[ HeaderLength + m_readPosition ] ), size );
+				::CopyMemory( pBuffer, m_buffer.GetData() + HeaderLength + m_readPosition, size );
 				m_readPosition += size;
 			}
 		}
 
+		// Skips size bytes and returns where they start in the buffer, which stays valid until the next write or resize.
+		const u8* ReadBytes( u32 size ) const
+		{
+			Assert( m_readPosition + size <= m_writePosition );
+
+			const u8* pBytes = m_buffer.GetData() + HeaderLength + m_readPosition;
+			m_readPosition += size;
+
+			return pBytes;
+		}
+
 		void ReadHeader( void* pBuffer, u32 size ) const
 		{
 			Assert( size <= HeaderLength );
 
 			if( size > 0 )
 			{
-				::CopyMemory( pBuffer, &( m_buffer[ 0 ] ), size );
+				::CopyMemory( pBuffer, m_buffer.GetData(), size );
+			}
+		}
+
+		template<typename T>
+		void ReadArray( T* pValues, u32 count ) const
+		{
+			Read( pValues, count * sizeof( T ) );
+		}
+
+		template<typename T>
+		void ReadArraySwapped( T* pValues, u32 count, u32 scalarSize = sizeof( T ) ) const
+		{
+			Assert( sizeof( T ) % scalarSize == 0 );
+
+			u32 size = count * sizeof( T );
+			if( size > 0 )
+			{
+				ByteOrder::Swap( pValues, ReadBytes( size ), size / scalarSize, scalarSize );
 			}
 		}
 
@@ -219,6 +320,40 @@ namespace Tomato
 		void ReadF64( f64& value ) const { return Read<f64>( value ); }
 		void ReadBool( bool& value ) const { return Read<bool>( value ); }
 
+		u32 ReadVarU32() const { return ReadVar<u32>(); }
+		s32 ReadVarS32() const { return VarInt::UnZigZag( ReadVar<u32>() ); }
+		u64 ReadVarU64() const { return ReadVar<u64>(); }
+		s64 ReadVarS64() const { return VarInt::UnZigZag( ReadVar<u64>() ); }
+
+		// False for a truncated or overflowing varint; value is then 0 and the read position does not move.
+		bool TryReadVarU32( u32& value ) const { return TryReadVar<u32>( value ); }
+		bool TryReadVarU64( u64& value ) const { return TryReadVar<u64>( value ); }
+
+		bool TryReadVarS32( s32& value ) const
+		{
+			u32 zigZag = 0;
+			bool bDecoded = TryReadVar<u32>( zigZag );
+
+			value = VarInt::UnZigZag( zigZag );
+			return bDecoded;
+		}
+
+		bool TryReadVarS64( s64& value ) const
+		{
+			u64 zigZag = 0;
+			bool bDecoded = TryReadVar<u64>( zigZag );
+
+			value = VarInt::UnZigZag( zigZag );
+			return bDecoded;
+		}
+
+		f32 ReadQuantizedF32( f32 min, f32 max, u32 bits ) const
+		{
+			u32 quantized = 0;
+			Read( &quantized, ( bits + 7 ) / 8 );
+			return Quantization::Dequantize( quantized, min, max, bits );
+		}
+
 		unsigned __int8 ReadHeaderU8() const { return ReadHeader<unsigned __int8>(); }
 		__int8 ReadHeaderS8() const { return ReadHeader<__int8>(); }
 		unsigned __int16 ReadHeaderU16() const { return ReadHeader<unsigned __int16>(); }
@@ -366,6 +501,23 @@ namespace Tomato
 			return buffer;
 		}
 
+		// Non-owning views of the characters in the buffer; see ReadBytes.
+		StringViewW ReadStringView() const
+		{
+			u16 bytesCount = ReadU16();
+
+			const wchar* pCharacters = reinterpret_cast<const wchar*>( ReadBytes( bytesCount ) );
+			return StringViewW( pCharacters, bytesCount / sizeof( wchar ) );
+		}
+
+		StringViewA ReadAnsiStringView() const
+		{
+			u16 bytesCount = ReadU16();
+
+			const char* pCharacters = reinterpret_cast<const char*>( ReadBytes( bytesCount ) );
+			return StringViewA( pCharacters, bytesCount );
+		}
+
 	public:
 		template<typename T>
 		MessageStreamBase& operator << ( const T& value )
@@ -447,6 +599,32 @@ namespace Tomato
 			return ( ( ReadHeader<u8>() != 0 ) ? true : false );
 		}
 
+		template<typename T>
+		T ReadVar() const
+		{
+			T value = 0;
+			if( !TryReadVar<T>( value ) )
+			{
+				Assert( false );
+			}
+
+			return value;
+		}
+
+		template<typename T>
+		bool TryReadVar( T& value ) const
+		{
+			u32 length = VarInt::Decode( GetPayload() + m_readPosition, m_writePosition - m_readPosition, value );
+			if( length == 0 )
+			{
+				value = 0;
+				return false;
+			}
+
+			m_readPosition += length;
+			return true;
+		}
+
 	private:
 		MemoryBlock m_buffer;
 
@@ -0,0 +1,335 @@
+#pragma once
+
+namespace Tomato
+{
+	// Read-only stream over a message someone else owns, e.g. a socket receive buffer or a
+	// mapped file, laid out like MessageStreamBase: Header + Payload.
+	//
+	// Nothing is copied to construct a view, and ReadBytes and the Read*View readers return
+	// pointers into the buffer, which must stay valid and unchanged while they are used.
+	// Copying a view is cheap; each copy has its own read position.
+	//
+	// A buffer too short to hold the header gives an invalid view with an empty payload, so check
+	// IsValid before reading a message that came from outside the process.
+	//
+	// Reading past the end of the payload never touches memory outside the buffer: the read gives
+	// zeros or an empty view, and HasFailed stays true until the read position is reset, so a
+	// message can be read through and checked once at the end.
+	template<u32 HeaderLength>
+	class MessageStreamViewBase
+	{
+	public:
+		MessageStreamViewBase()
+			: m_pBuffer( NULL )
+			, m_payloadLength( 0 )
+			, m_readPosition( 0 )
+			, m_bFailed( false )
+		{
+		}
+
+		// Buffer = Header + Payload
+		MessageStreamViewBase( const void* pBuffer, u32 length )
+			: m_pBuffer( NULL )
+			, m_payloadLength( 0 )
+			, m_readPosition( 0 )
+			, m_bFailed( false )
+		{
+			if( pBuffer != NULL && length >= HeaderLength )
+			{
+				m_pBuffer = static_cast<const u8*>( pBuffer );
+				m_payloadLength = length - HeaderLength;
+			}
+		}
+
+		// The view is invalidated by writing to or resizing the stream.
+		MessageStreamViewBase( const MessageStreamBase<HeaderLength>& stream )
+			: m_pBuffer( stream.GetBuffer() )
+			, m_payloadLength( stream.GetPayloadLength() )
+			, m_readPosition( 0 )
+			, m_bFailed( false )
+		{
+		}
+
+	public:
+
+		// False for a default constructed view or a buffer shorter than the header.
+		bool IsValid() const { return ( m_pBuffer != NULL ); }
+
+		// True once a read ran past the end of the payload or met a truncated or overflowing varint.
+		bool HasFailed() const { return m_bFailed; }
+
+		// Buffer = Header + Payload
+		const u8* GetBuffer() const { return m_pBuffer; }
+		u32 GetLength() const
+		{
+			return HeaderLength + m_payloadLength;
+		}
+
+		// Header
+		const u8* GetHeader() const { return m_pBuffer; }
+		u32 GetHeaderLength() const
+		{
+			return HeaderLength;
+		}
+
+		// Payload
+		const u8* GetPayload() const { return m_pBuffer + HeaderLength; }
+		u32 GetPayloadLength() const
+		{
+			return m_payloadLength;
+		}
+
+		// Also clears HasFailed.
+		void ResetReadPosition( u32 readPosition = 0 ) const
+		{
+			Assert( readPosition <= m_payloadLength );
+
+			m_readPosition = ( readPosition < m_payloadLength ) ? readPosition : m_payloadLength;
+			m_bFailed = false;
+		}
+
+		u32 GetReadPosition() const
+		{
+			return m_readPosition;
+		}
+
+		// Payload bytes not read yet.
+		u32 GetRemainingLength() const
+		{
+			return m_payloadLength - m_readPosition;
+		}
+
+	public:
+
+		// Gives zeros when the payload is too short.
+		void Read( void* pBuffer, u32 size ) const
+		{
+			const u8* pBytes = ReadBytes( size );
+
+			if( m_bFailed )
+			{
+				::ZeroMemory( pBuffer, size );
+			}
+			else if( size > 0 )
+			{
+				::CopyMemory( pBuffer, pBytes, size );
+			}
+		}
+
+		// Skips size bytes and returns where they start in the buffer. When fewer than size bytes
+		// are left nothing is skipped, HasFailed becomes true and no bytes may be used.
+		const u8* ReadBytes( u32 size ) const
+		{
+			if( m_bFailed || !IsValid() || size > m_payloadLength - m_readPosition )
+			{
+				m_bFailed = true;
+				return IsValid() ? GetPayload() + m_readPosition : NULL;
+			}
+
+			const u8* pBytes = GetPayload() + m_readPosition;
+			m_readPosition += size;
+
+			return pBytes;
+		}
+
+		// Gives zeros for an invalid view.
+		void ReadHeader( void* pBuffer, u32 size ) const
+		{
+			Assert( size <= HeaderLength );
+
+			if( !IsValid() )
+			{
+				m_bFailed = true;
+				::ZeroMemory( pBuffer, size );
+			}
+			else if( size > 0 )
+			{
+				::CopyMemory( pBuffer, m_pBuffer, size );
+			}
+		}
+
+		// See MessageStreamBase::WriteArray and WriteArraySwapped.
+		template<typename T>
+		void ReadArray( T* pValues, u32 count ) const
+		{
+			Read( pValues, count * sizeof( T ) );
+		}
+
+		template<typename T>
+		void ReadArraySwapped( T* pValues, u32 count, u32 scalarSize = sizeof( T ) ) const
+		{
+			Assert( sizeof( T ) % scalarSize == 0 );
+
+			u32 size = count * sizeof( T );
+			const u8* pBytes = ReadBytes( size );
+
+			if( m_bFailed )
+			{
+				::ZeroMemory( pValues, size );
+			}
+			else if( size > 0 )
+			{
+				ByteOrder::Swap( pValues, pBytes, size / scalarSize, scalarSize );
+			}
+		}
+
+		unsigned __int8 ReadU8() const { return Read<unsigned __int8>(); }
+		__int8 ReadS8() const { return Read<__int8>(); }
+		unsigned __int16 ReadU16() const { return Read<unsigned __int16>(); }
+		__int16 ReadS16() const { return Read<__int16>(); }
+		unsigned __int32 ReadU32() const { return Read<unsigned __int32>(); }
+		__int32 ReadS32() const { return Read<__int32>(); }
+		u64 ReadU64() const { return Read<u64>(); }
+		s64 ReadS64() const { return Read<s64>(); }
+		f32 ReadF32() const { return Read<f32>(); }
+		f64 ReadF64() const { return Read<f64>(); }
+		bool ReadBool() const { return ( Read<u8>() != 0 ); }
+
+		void ReadU8( unsigned __int8& value ) const { Read<unsigned __int8>( value ); }
+		void ReadS8( __int8& value ) const { Read<__int8>( value ); }
+		void ReadU16( unsigned __int16& value ) const { Read<unsigned __int16>( value ); }
+		void ReadS16( __int16& value ) const { Read<__int16>( value ); }
+		void ReadU32( unsigned __int32& value ) const { Read<unsigned __int32>( value ); }
+		void ReadS32( __int32& value ) const { Read<__int32>( value ); }
+		void ReadU64( u64& value ) const { Read<u64>( value ); }
+		void ReadS64( s64& value ) const { Read<s64>( value ); }
+		void ReadF32( f32& value ) const { Read<f32>( value ); }
+		void ReadF64( f64& value ) const { Read<f64>( value ); }
+		void ReadBool( bool& value ) const { value = ReadBool(); }
+
+		u32 ReadVarU32() const { return ReadVar<u32>(); }
+		s32 ReadVarS32() const { return VarInt::UnZigZag( ReadVar<u32>() ); }
+		u64 ReadVarU64() const { return ReadVar<u64>(); }
+		s64 ReadVarS64() const { return VarInt::UnZigZag( ReadVar<u64>() ); }
+
+		f32 ReadQuantizedF32( f32 min, f32 max, u32 bits ) const
+		{
+			u32 quantized = 0;
+			Read( &quantized, ( bits + 7 ) / 8 );
+			return Quantization::Dequantize( quantized, min, max, bits );
+		}
+
+		unsigned __int8 ReadHeaderU8() const { return ReadHeader<unsigned __int8>(); }
+		__int8 ReadHeaderS8() const { return ReadHeader<__int8>(); }
+		unsigned __int16 ReadHeaderU16() const { return ReadHeader<unsigned __int16>(); }
+		__int16 ReadHeaderS16() const { return ReadHeader<__int16>(); }
+		unsigned __int32 ReadHeaderU32() const { return ReadHeader<unsigned __int32>(); }
+		__int32 ReadHeaderS32() const { return ReadHeader<__int32>(); }
+		u64 ReadHeaderU64() const { return ReadHeader<u64>(); }
+		s64 ReadHeaderS64() const { return ReadHeader<s64>(); }
+		f32 ReadHeaderF32() const { return ReadHeader<f32>(); }
+		f64 ReadHeaderF64() const { return ReadHeader<f64>(); }
+		bool ReadHeaderBool() const { return ( ReadHeader<u8>() != 0 ); }
+
+	public:
+
+		// Strings are a 16-bit byte count followed by the characters, as MessageStreamBase writes them.
+		StringW ReadString() const
+		{
+			return ReadStringView().ToString();
+		}
+
+		StringW ReadMultiByteString( Encoding::Type encoding ) const
+		{
+			return TextHelper::ConvertToUnicodeString( ReadAnsiStringView().ToString(), encoding );
+		}
+
+		StringA ReadAnsiString() const
+		{
+			return ReadAnsiStringView().ToString();
+		}
+
+		StringA ReadMultiByteString() const
+		{
+			return ReadAnsiStringView().ToString();
+		}
+
+		StringViewW ReadStringView() const
+		{
+			u16 bytesCount = ReadU16();
+
+			const wchar* pCharacters = reinterpret_cast<const wchar*>( ReadBytes( bytesCount ) );
+			if( m_bFailed )
+			{
+				return StringViewW();
+			}
+
+			return StringViewW( pCharacters, bytesCount / sizeof( wchar ) );
+		}
+
+		StringViewA ReadAnsiStringView() const
+		{
+			u16 bytesCount = ReadU16();
+
+			const char* pCharacters = reinterpret_cast<const char*>( ReadBytes( bytesCount ) );
+			if( m_bFailed )
+			{
+				return StringViewA();
+			}
+
+			return StringViewA( pCharacters, bytesCount );
+		}
+
+	public:
+		template<typename T>
+		const MessageStreamViewBase& operator >> ( T& value ) const
+		{
+			Read<T>( value );
+			return *this;
+		}
+
+	private:
+		template<typename T> 
+		void Read( T& value ) const
+		{
+			Read( static_cast<void*>( &value ), sizeof( T ) );
+		}
+
+		template<typename T> 
+		T Read() const
+		{
+			T value;
+			Read( static_cast<void*>( &value ), sizeof( T ) );
+			return value;
+		}
+
+		template<typename T> 
+		T ReadHeader() const
+		{
+			T value;
+			ReadHeader( static_cast<void*>( &value ), sizeof( T ) );
+			return value;
+		}
+
+		// Gives 0 and sets HasFailed for a varint that cannot be decoded.
+		template<typename T>
+		T ReadVar() const
+		{
+			T value = 0;
+
+			u32 length = 0;
+			if( !m_bFailed && IsValid() )
+			{
+				length = VarInt::Decode( GetPayload() + m_readPosition, m_payloadLength - m_readPosition, value );
+			}
+
+			if( length == 0 )
+			{
+				m_bFailed = true;
+				return 0;
+			}
+
+			m_readPosition += length;
+			return value;
+		}
+
+	private:
+		const u8* m_pBuffer;
+		u32 m_payloadLength;
+
+		mutable u32 m_readPosition;
+		mutable bool m_bFailed;
+	};
+
+	typedef MessageStreamViewBase<2> MessageStreamView;
+}
@@ -0,0 +1,194 @@
+#include "TomatoPCH.h"
+
+#include "SegmentedBuffer.h"
+
+namespace Tomato
+{
+	namespace
+	{
+		ConcurrentFixedPool s_defaultChunkPool( SegmentedBuffer::DefaultChunkSize, 16, 64, 8 );
+	}
+
+	SegmentedBuffer::SegmentedBuffer()
+		: m_pPool( &s_defaultChunkPool )
+		, m_chunkCapacity( DefaultChunkSize - sizeof( Chunk ) )
+		, m_pHead( NULL )
+		, m_pTail( NULL )
+		, m_chunkCount( 0 )
+		, m_length( 0 )
+	{
+	}
+
+	SegmentedBuffer::SegmentedBuffer( ConcurrentFixedPool& chunkPool )
+		: m_pPool( &chunkPool )
+		, m_chunkCapacity( chunkPool.GetElementSize() - sizeof( Chunk ) )
+		, m_pHead( NULL )
+		, m_pTail( NULL )
+		, m_chunkCount( 0 )
+		, m_length( 0 )
+	{
+		Assert( chunkPool.GetElementSize() > sizeof( Chunk ) );
+	}
+
+	SegmentedBuffer::~SegmentedBuffer()
+	{
+		Clear();
+	}
+
+	u8* SegmentedBuffer::WriteBytes( u32 size )
+	{
+		Assert( size <= m_chunkCapacity );
+
+		if( m_pTail == NULL || size > m_chunkCapacity - m_pTail->Length )
+		{
+			AddChunk();
+		}
+
+		u8* pBytes = GetData( m_pTail ) + m_pTail->Length;
+		m_pTail->Length += size;
+		m_length += size;
+
+		return pBytes;
+	}
+
+	void SegmentedBuffer::Overwrite( u32 offset, const void* pBuffer, u32 size )
+	{
+		Assert( offset + size <= m_length );
+
+		const u8* pSource = static_cast<const u8*>( pBuffer );
+
+		for( Chunk* pChunk = m_pHead; pChunk != NULL && size > 0; pChunk = pChunk->pNext )
+		{
+			if( offset >= pChunk->Length )
+			{
+				offset -= pChunk->Length;
+				continue;
+			}
+
+			u32 count = Math::Min( static_cast<s32>( size ), static_cast<s32>( pChunk->Length - offset ) );
+			::CopyMemory( GetData( pChunk ) + offset, pSource, count );
+
+			pSource += count;
+			size -= count;
+			offset = 0;
+		}
+	}
+
+	void SegmentedBuffer::CopyTo( u32 offset, void* pBuffer, u32 size ) const
+	{
+		Assert( offset + size <= m_length );
+
+		u8* pDestination = static_cast<u8*>( pBuffer );
+
+		for( const Chunk* pChunk = m_pHead; pChunk != NULL && size > 0; pChunk = pChunk->pNext )
+		{
+			if( offset >= pChunk->Length )
+			{
+				offset -= pChunk->Length;
+				continue;
+			}
+
+			u32 count = Math::Min( static_cast<s32>( size ), static_cast<s32>( pChunk->Length - offset ) );
+			::CopyMemory( pDestination, GetData( pChunk ) + offset, count );
+
+			pDestination += count;
+			size -= count;
+			offset = 0;
+		}
+	}
+
+	void SegmentedBuffer::GetSegments( std::vector<Segment>& segments ) const
+	{
+		segments.clear();
+		segments.reserve( m_chunkCount );
+
+		for( const Chunk* pChunk = m_pHead; pChunk != NULL; pChunk = pChunk->pNext )
+		{
+			if( pChunk->Length > 0 )
+			{
+				Segment segment;
+				segment.pData = GetData( pChunk );
+				segment.Length = pChunk->Length;
+
+				segments.push_back( segment );
+			}
+		}
+	}
+
+	void SegmentedBuffer::Clear()
+	{
+		Chunk* pChunk = m_pHead;
+		while( pChunk != NULL )
+		{
+			Chunk* pNext = pChunk->pNext;
+			m_pPool->Free( pChunk );
+			pChunk = pNext;
+		}
+
+		m_pHead = NULL;
+		m_pTail = NULL;
+		m_chunkCount = 0;
+		m_length = 0;
+	}
+
+	void SegmentedBuffer::Swap( SegmentedBuffer& other )
+	{
+		Assert( m_pPool == other.m_pPool );
+
+		Chunk* pHead = m_pHead;
+		Chunk* pTail = m_pTail;
+		s32 chunkCount = m_chunkCount;
+		u32 length = m_length;
+
+		m_pHead = other.m_pHead;
+		m_pTail = other.m_pTail;
+		m_chunkCount = other.m_chunkCount;
+		m_length = other.m_length;
+
+		other.m_pHead = pHead;
+		other.m_pTail = pTail;
+		other.m_chunkCount = chunkCount;
+		other.m_length = length;
+	}
+
+	void SegmentedBuffer::WriteSlow( const void* pBuffer, u32 size )
+	{
+		const u8* pSource = static_cast<const u8*>( pBuffer );
+
+		while( size > 0 )
+		{
+			if( m_pTail == NULL || m_pTail->Length == m_chunkCapacity )
+			{
+				AddChunk();
+			}
+
+			u32 count = Math::Min( static_cast<s32>( size ), static_cast<s32>( m_chunkCapacity - m_pTail->Length ) );
+			::CopyMemory( GetData( m_pTail ) + m_pTail->Length, pSource, count );
+
+			m_pTail->Length += count;
+			m_length += count;
+
+			pSource += count;
+			size -= count;
+		}
+	}
+
+	void SegmentedBuffer::AddChunk()
+	{
+		Chunk* pChunk = static_cast<Chunk*>( m_pPool->Allocate() );
+		pChunk->pNext = NULL;
+		pChunk->Length = 0;
+
+		if( m_pTail != NULL )
+		{
+			m_pTail->pNext = pChunk;
+		}
+		else
+		{
+			m_pHead = pChunk;
+		}
+
+		m_pTail = pChunk;
+		++m_chunkCount;
+	}
+}
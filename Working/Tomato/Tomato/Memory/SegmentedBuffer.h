@@ -0,0 +1,206 @@
+#pragma once
+
+namespace Tomato
+{
+	// Byte buffer made of a chain of fixed-size chunks.
+	//
+	// Appending fills the last chunk and then links a new one from a pool, so data once written
+	// is never moved or copied again, however large the buffer grows. The contents are handed
+	// out as a list of segments for scatter/gather I/O (WSASend, writev) instead of as one block.
+	class TOMATO_API SegmentedBuffer
+	{
+	public:
+		enum { DefaultChunkSize = 4096 };
+
+		// One contiguous run of bytes; maps directly onto a WSABUF or an iovec.
+		struct Segment
+		{
+			const u8* pData;
+			u32 Length;
+		};
+
+		// Chunks of DefaultChunkSize bytes come from a pool shared by every such buffer.
+		SegmentedBuffer();
+
+		// Chunks come from chunkPool, which must outlive the buffer.
+		explicit SegmentedBuffer( ConcurrentFixedPool& chunkPool );
+
+		~SegmentedBuffer();
+
+	public:
+		void Write( const void* pBuffer, u32 size )
+		{
+			if( m_pTail != NULL && size <= m_chunkCapacity - m_pTail->Length )
+			{
+				::CopyMemory( GetData( m_pTail ) + m_pTail->Length, pBuffer, size );
+				m_pTail->Length += size;
+				m_length += size;
+			}
+			else
+			{
+				WriteSlow( pBuffer, size );
+			}
+		}
+
+		// Appends size uninitialized, contiguous bytes and returns where they start. A new chunk is
+		// started if the last one cannot hold them; size must not exceed GetChunkCapacity().
+		u8* WriteBytes( u32 size );
+
+		// Replaces bytes already written, e.g. to patch in a length once it is known.
+		void Overwrite( u32 offset, const void* pBuffer, u32 size );
+
+		void CopyTo( u32 offset, void* pBuffer, u32 size ) const;
+
+		// Replaces the contents of segments.
+		void GetSegments( std::vector<Segment>& segments ) const;
+		s32 GetSegmentCount() const { return m_chunkCount; }
+
+		u32 GetLength() const { return m_length; }
+		u32 GetChunkCapacity() const { return m_chunkCapacity; }
+
+		// Returns every chunk to the pool.
+		void Clear();
+
+		// Buffers must share a pool to be swapped.
+		void Swap( SegmentedBuffer& other );
+
+	private:
+		SegmentedBuffer( const SegmentedBuffer& copy );
+		SegmentedBuffer& operator = ( const SegmentedBuffer& copy );
+
+		// The data of a chunk follows its header.
+		struct Chunk
+		{
+			Chunk* pNext;
+			u32 Length;
+		};
+
+		static u8* GetData( Chunk* pChunk ) { return reinterpret_cast<u8*>( pChunk + 1 ); }
+		static const u8* GetData( const Chunk* pChunk ) { return reinterpret_cast<const u8*>( pChunk + 1 ); }
+
+		void WriteSlow( const void* pBuffer, u32 size );
+		void AddChunk();
+
+	private:
+		ConcurrentFixedPool* m_pPool;
+		u32 m_chunkCapacity;
+
+		Chunk* m_pHead;
+		Chunk* m_pTail;
+		s32 m_chunkCount;
+
+		u32 m_length;
+	};
+
+	// MessageStreamBase writer on a SegmentedBuffer, for messages too large to build in one block.
+	// The first HeaderLength bytes are the header, as in MessageStreamBase.
+	template<u32 HeaderLength>
+	class SegmentedMessageStreamBase
+	{
+	public:
+		SegmentedMessageStreamBase()
+		{
+			::ZeroMemory( m_buffer.WriteBytes( HeaderLength ), HeaderLength );
+		}
+
+		explicit SegmentedMessageStreamBase( ConcurrentFixedPool& chunkPool )
+			: m_buffer( chunkPool )
+		{
+			::ZeroMemory( m_buffer.WriteBytes( HeaderLength ), HeaderLength );
+		}
+
+	public:
+		// Buffer = Header + Payload
+		u32 GetLength() const
+		{
+			return m_buffer.GetLength();
+		}
+
+		u32 GetHeaderLength() const
+		{
+			return HeaderLength;
+		}
+
+		u32 GetPayloadLength() const
+		{
+			return m_buffer.GetLength() - HeaderLength;
+		}
+
+		void GetSegments( std::vector<SegmentedBuffer::Segment>& segments ) const
+		{
+			m_buffer.GetSegments( segments );
+		}
+
+		// Discards the payload and zeroes the header.
+		void Reset()
+		{
+			m_buffer.Clear();
+			::ZeroMemory( m_buffer.WriteBytes( HeaderLength ), HeaderLength );
+		}
+
+		// Copies header and payload into a contiguous stream for local readers.
+		void CopyTo( MessageStreamBase<HeaderLength>& stream ) const
+		{
+			stream.Reset();
+
+			u8 header[ HeaderLength ];
+			m_buffer.CopyTo( 0, header, HeaderLength );
+			stream.WriteHeader( header, HeaderLength );
+
+			u32 payloadLength = GetPayloadLength();
+			if( payloadLength > 0 )
+			{
+				m_buffer.CopyTo( HeaderLength, stream.WriteBytes( payloadLength ), payloadLength );
+			}
+		}
+
+	public:
+		void Write( const void* pBuffer, u32 size )
+		{
+			m_buffer.Write( pBuffer, size );
+		}
+
+		void WriteHeader( const void* pBuffer, u32 size )
+		{
+			Assert( size <= HeaderLength );
+
+			m_buffer.Overwrite( 0, pBuffer, size );
+		}
+
+		void WriteU8( u8 value ) { Write( &value, sizeof( value ) ); }
+		void WriteS8( s8 value ) { Write( &value, sizeof( value ) ); }
+		void WriteU16( u16 value ) { Write( &value, sizeof( value ) ); }
+		void WriteS16( __int16 value ) { Write( &value, sizeof( value ) ); }
+		void WriteU32( u32 value ) { Write( &value, sizeof( value ) ); }
+		void WriteS32( s32 value ) { Write( &value, sizeof( value ) ); }
+		void WriteU64( u64 value ) { Write( &value, sizeof( value ) ); }
+		void WriteS64( s64 value ) { Write( &value, sizeof( value ) ); }
+		void WriteF32( f32 value ) { Write( &value, sizeof( value ) ); }
+		void WriteF64( f64 value ) { Write( &value, sizeof( value ) ); }
+		void WriteBool( bool value ) { WriteU8( value ? 1 : 0 ); }
+
+		void WriteHeaderU8( u8 value ) { WriteHeader( &value, sizeof( value ) ); }
+		void WriteHeaderU16( u16 value ) { WriteHeader( &value, sizeof( value ) ); }
+		void WriteHeaderU32( u32 value ) { WriteHeader( &value, sizeof( value ) ); }
+
+		void WriteVarU32( u32 value ) { u8 bytes[ VarInt::MaxLength32 ]; Write( bytes, VarInt::Encode( bytes, value ) ); }
+		void WriteVarS32( s32 value ) { WriteVarU32( VarInt::ZigZag( value ) ); }
+		void WriteVarU64( u64 value ) { u8 bytes[ VarInt::MaxLength64 ]; Write( bytes, VarInt::Encode( bytes, value ) ); }
+		void WriteVarS64( s64 value ) { WriteVarU64( VarInt::ZigZag( value ) ); }
+
+		template<typename T>
+		void WriteArray( const T* pValues, u32 count )
+		{
+			Write( pValues, count * sizeof( T ) );
+		}
+
+	private:
+		SegmentedMessageStreamBase( const SegmentedMessageStreamBase& copy );
+		SegmentedMessageStreamBase& operator = ( const SegmentedMessageStreamBase& copy );
+
+	private:
+		SegmentedBuffer m_buffer;
+	};
+
+	typedef SegmentedMessageStreamBase<2> SegmentedMessageStream;
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+namespace Tomato
+{
+	// Densely stored objects addressed through 32 bit handles.
+	//
+	// A handle packs a slot index with the generation of that slot, which changes every time the
+	// slot's object is removed, so a stale handle is detected in O(1) instead of reaching whatever
+	// object took its place. Freed slots are reused oldest first, and the 12 bit generation only
+	// repeats after a slot has been reused 4095 times.
+	//
+	// Objects are kept contiguous for iteration with GetCount and operator []. Remove moves the
+	// last object into the hole, so pointers and dense indices only stay valid until the next
+	// Insert or Remove; handles stay valid until their object is removed.
+	template<typename T>
+	class SlotMap
+	{
+	public:
+		typedef u32 Handle;
+
+		enum
+		{
+			IndexBits = 20,
+			GenerationBits = 32 - IndexBits,
+
+			// Never returned by Insert.
+			InvalidHandle = 0,
+
+			MaxCount = 1 << IndexBits,
+		};
+
+		SlotMap()
+			: m_freeHead( NoSlot )
+			, m_freeTail( NoSlot )
+		{
+		}
+
+	public:
+		Handle Insert( const T& value )
+		{
+			u32 slot;
+			if( m_freeHead != NoSlot )
+			{
+				slot = m_freeHead;
+				m_freeHead = m_slots[ slot ].NextFree;
+				if( m_freeHead == NoSlot )
+				{
+					m_freeTail = NoSlot;
+				}
+			}
+			else
+			{
+				Assert( m_slots.size() < MaxCount );
+
+				Slot newSlot;
+				newSlot.DenseIndex = NoSlot;
+				newSlot.NextFree = NoSlot;
+				newSlot.Generation = 1;
+
+				slot = static_cast<u32>( m_slots.size() );
+				m_slots.push_back( newSlot );
+			}
+
+			m_slots[ slot ].DenseIndex = static_cast<u32>( m_objects.size() );
+			m_objects.push_back( value );
+			m_denseToSlot.push_back( slot );
+
+			return ( m_slots[ slot ].Generation << IndexBits ) | slot;
+		}
+
+		// Returns false if the handle is stale or invalid.
+		bool Remove( Handle handle )
+		{
+			if( Get( handle ) == NULL )
+			{
+				return false;
+			}
+
+			u32 slot = handle & IndexMask;
+			u32 dense = m_slots[ slot ].DenseIndex;
+			u32 last = static_cast<u32>( m_objects.size() ) - 1;
+
+			if( dense != last )
+			{
+				m_objects[ dense ] = m_objects[ last ];
+				m_denseToSlot[ dense ] = m_denseToSlot[ last ];
+				m_slots[ m_denseToSlot[ dense ] ].DenseIndex = dense;
+			}
+
+			m_objects.pop_back();
+			m_denseToSlot.pop_back();
+
+			FreeSlot( slot );
+			return true;
+		}
+
+		// Removes every object; all handles become stale.
+		void Clear()
+		{
+			for( size_t i = 0; i < m_denseToSlot.size(); ++i )
+			{
+				FreeSlot( m_denseToSlot[ i ] );
+			}
+
+			m_objects.clear();
+			m_denseToSlot.clear();
+		}
+
+		// NULL if the handle is stale or invalid.
+		T* Get( Handle handle )
+		{
+			u32 slot = handle & IndexMask;
+			if( slot >= m_slots.size() )
+			{
+				return NULL;
+			}
+
+			// A free slot can carry a matching generation once it has wrapped, or for a forged
+			// handle, so the slot must also be in use.
+			const Slot& entry = m_slots[ slot ];
+			if( entry.Generation != ( handle >> IndexBits ) || entry.DenseIndex == NoSlot )
+			{
+				return NULL;
+			}
+
+			return &m_objects[ entry.DenseIndex ];
+		}
+
+		const T* Get( Handle handle ) const
+		{
+			return const_cast<SlotMap*>( this )->Get( handle );
+		}
+
+		bool Contains( Handle handle ) const { return Get( handle ) != NULL; }
+
+		void Reserve( s32 count )
+		{
+			m_objects.reserve( count );
+			m_denseToSlot.reserve( count );
+			m_slots.reserve( count );
+		}
+
+		s32 GetCount() const { return static_cast<s32>( m_objects.size() ); }
+
+		// Dense access for iteration, 0 <= index < GetCount().
+		T& operator [] ( s32 index ) { return m_objects[ index ]; }
+		const T& operator [] ( s32 index ) const { return m_objects[ index ]; }
+
+		Handle GetHandle( s32 index ) const
+		{
+			u32 slot = m_denseToSlot[ index ];
+			return ( m_slots[ slot ].Generation << IndexBits ) | slot;
+		}
+
+	private:
+		enum
+		{
+			IndexMask = MaxCount - 1,
+			GenerationMask = ( 1 << GenerationBits ) - 1,
+		};
+
+		static const u32 NoSlot = 0xFFFFFFFF;
+
+		struct Slot
+		{
+			// Index into m_objects while the slot is in use, NoSlot otherwise.
+			u32 DenseIndex;
+
+			// Next slot in the free list while the slot is free.
+			u32 NextFree;
+
+			u32 Generation;
+		};
+
+		void FreeSlot( u32 slot )
+		{
+			// Generation 0 is skipped so no handle is ever InvalidHandle.
+			u32 generation = ( m_slots[ slot ].Generation + 1 ) & GenerationMask;
+			m_slots[ slot ].Generation = ( generation == 0 ) ? 1 : generation;
+			m_slots[ slot ].DenseIndex = NoSlot;
+			m_slots[ slot ].NextFree = NoSlot;
+
+			if( m_freeTail == NoSlot )
+			{
+				m_freeHead = slot;
+			}
+			else
+			{
+				m_slots[ m_freeTail ].NextFree = slot;
+			}
+
+			m_freeTail = slot;
+		}
+
+	private:
+		std::vector<T> m_objects;
+		std::vector<u32> m_denseToSlot;
+		std::vector<Slot> m_slots;
+
+		u32 m_freeHead;
+		u32 m_freeTail;
+	};
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+namespace Tomato
+{
+	// LEB128 variable-length integers: seven bits per byte, least significant group first, with
+	// the high bit set on every byte but the last. Values below 128 take one byte.
+	//
+	// Signed values are zigzag mapped first (0, -1, 1, -2, ... -> 0, 1, 2, 3, ...) so that small
+	// negative numbers stay short too.
+	class VarInt
+	{
+	public:
+		enum
+		{
+			MaxLength32 = 5,
+			MaxLength64 = 10,
+		};
+
+		static u32 ZigZag( s32 value )
+		{
+			return ( static_cast<u32>( value ) << 1 ) ^ static_cast<u32>( value >> 31 );
+		}
+
+		static u64 ZigZag( s64 value )
+		{
+			return ( static_cast<u64>( value ) << 1 ) ^ static_cast<u64>( value >> 63 );
+		}
+
+		static s32 UnZigZag( u32 value )
+		{
+			return static_cast<s32>( value >> 1 ) ^ -static_cast<s32>( value & 1 );
+		}
+
+		static s64 UnZigZag( u64 value )
+		{
+			return static_cast<s64>( value >> 1 ) ^ -static_cast<s64>( value & 1 );
+		}
+
+		// Returns the number of bytes written, at most MaxLength32.
+		static u32 Encode( u8* pBuffer, u32 value )
+		{
+			u32 length = 0;
+			while( value >= 0x80 )
+			{
+				pBuffer[ length++ ] = static_cast<u8>( value | 0x80 );
+				value >>= 7;
+			}
+			pBuffer[ length++ ] = static_cast<u8>( value );
+
+			return length;
+		}
+
+		// Returns the number of bytes written, at most MaxLength64.
+		static u32 Encode( u8* pBuffer, u64 value )
+		{
+			u32 length = 0;
+			while( value >= 0x80 )
+			{
+				pBuffer[ length++ ] = static_cast<u8>( value | 0x80 );
+				value >>= 7;
+			}
+			pBuffer[ length++ ] = static_cast<u8>( value );
+
+			return length;
+		}
+
+		// Returns the number of bytes consumed, or 0 if the value is truncated or does not fit.
+		static u32 Decode( const u8* pBuffer, u32 bufferLength, u32& value )
+		{
+			u32 result = 0;
+			u32 length = ( bufferLength < static_cast<u32>( MaxLength32 ) ) ? bufferLength : static_cast<u32>( MaxLength32 );
+
+			for( u32 i = 0; i < length; ++i )
+			{
+				u8 current = pBuffer[ i ];
+
+				// The last byte only has room for the top 4 bits.
+				if( i == static_cast<u32>( MaxLength32 ) - 1 && ( current & 0x70 ) != 0 )
+				{
+					return 0;
+				}
+
+				result |= static_cast<u32>( current & 0x7F ) << ( i * 7 );
+
+				if( ( current & 0x80 ) == 0 )
+				{
+					value = result;
+					return i + 1;
+				}
+			}
+
+			return 0;
+		}
+
+		static u32 Decode( const u8* pBuffer, u32 bufferLength, u64& value )
+		{
+			u64 result = 0;
+			u32 length = ( bufferLength < static_cast<u32>( MaxLength64 ) ) ? bufferLength : static_cast<u32>( MaxLength64 );
+
+			for( u32 i = 0; i < length; ++i )
+			{
+				u8 current = pBuffer[ i ];
+
+				// The last byte only has room for the top bit.
+				if( i == static_cast<u32>( MaxLength64 ) - 1 && current > 1 )
+				{
+					return 0;
+				}
+
+				result |= static_cast<u64>( current & 0x7F ) << ( i * 7 );
+
+				if( ( current & 0x80 ) == 0 )
+				{
+					value = result;
+					return i + 1;
+				}
+			}
+
+			return 0;
+		}
+
+		static u32 GetLength( u32 value )
+		{
+			u32 length = 1;
+			while( value >= 0x80 )
+			{
+				value >>= 7;
+				++length;
+			}
+
+			return length;
+		}
+
+		static u32 GetLength( u64 value )
+		{
+			u32 length = 1;
+			while( value >= 0x80 )
+			{
+				value >>= 7;
+				++length;
+			}
+
+			return length;
+		}
+
+	private:
+		VarInt();
+	};
+}
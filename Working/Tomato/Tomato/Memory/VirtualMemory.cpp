@@ -0,0 +1,65 @@
+#include "TomatoPCH.h"
+
+#include "VirtualMemory.h"
+
+namespace Tomato
+{
+	u32 VirtualMemory::GetPageSize()
+	{
+		static u32 s_pageSize = 0;
+
+		if( s_pageSize == 0 )
+		{
+			SYSTEM_INFO systemInfo;
+			::GetSystemInfo( &systemInfo );
+
+			s_pageSize = static_cast<u32>( systemInfo.dwPageSize );
+		}
+
+		return s_pageSize;
+	}
+
+	u32 VirtualMemory::RoundUpToPageSize( u32 size )
+	{
+		u32 pageSize = GetPageSize();
+
+		return ( size + pageSize - 1 ) & ~( pageSize - 1 );
+	}
+
+	void* VirtualMemory::Reserve( u32 size )
+	{
+		Assert( size > 0 );
+
+		return ::VirtualAlloc( NULL, RoundUpToPageSize( size ), MEM_RESERVE, PAGE_NOACCESS );
+	}
+
+	bool VirtualMemory::Commit( void* pAddress, u32 size )
+	{
+		Assert( pAddress != NULL );
+
+		if( size == 0 )
+		{
+			return true;
+		}
+
+		return ( ::VirtualAlloc( pAddress, size, MEM_COMMIT, PAGE_READWRITE ) != NULL );
+	}
+
+	void VirtualMemory::Decommit( void* pAddress, u32 size )
+	{
+		Assert( pAddress != NULL );
+
+		if( size > 0 )
+		{
+			::VirtualFree( pAddress, size, MEM_DECOMMIT );
+		}
+	}
+
+	void VirtualMemory::Release( void* pBase )
+	{
+		if( pBase != NULL )
+		{
+			::VirtualFree( pBase, 0, MEM_RELEASE );
+		}
+	}
+}
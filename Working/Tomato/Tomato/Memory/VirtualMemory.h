@@ -0,0 +1,31 @@
+#pragma once
+
+namespace Tomato
+{
+	// Reserve-then-commit address space.
+	//
+	// Reserve claims a contiguous range of addresses without using any memory; pages of the range
+	// are backed by memory only once they are committed, and committed pages start zeroed. A buffer
+	// built on a reservation can grow up to the reserved size without its address ever changing.
+	class TOMATO_API VirtualMemory
+	{
+	public:
+		// Reservations and commits are rounded up to this size.
+		static u32 GetPageSize();
+
+		static u32 RoundUpToPageSize( u32 size );
+
+		// Returns NULL if the address space is not available.
+		static void* Reserve( u32 size );
+
+		// The range must lie inside a reservation; committing pages that are already committed keeps their contents.
+		static bool Commit( void* pAddress, u32 size );
+		static void Decommit( void* pAddress, u32 size );
+
+		// Releases a whole reservation, committed or not.
+		static void Release( void* pBase );
+
+	private:
+		VirtualMemory();
+	};
+}
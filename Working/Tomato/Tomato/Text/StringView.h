@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+
+namespace Tomato
+{
+	// Non-owning, read-only run of characters, e.g. a string inside a message buffer.
+	//
+	// The characters are not null-terminated and must outlive the view. They may also be
+	// unaligned when the view points into a packed buffer.
+	template<typename StringType, typename CharType>
+	class StringViewT
+	{
+	public:
+		StringViewT()
+			: m_pCharacters( NULL )
+			, m_length( 0 )
+		{
+		}
+
+		StringViewT( const CharType* pCharacters, s32 length )
+			: m_pCharacters( pCharacters )
+			, m_length( length )
+		{
+			Assert( pCharacters != NULL || length == 0 );
+			Assert( length >= 0 );
+		}
+
+	public:
+		bool operator ==( const StringViewT& str ) const
+		{
+			return ( m_length == str.m_length )
+				&& ( m_length == 0 || std::memcmp( m_pCharacters, str.m_pCharacters, m_length * sizeof( CharType ) ) == 0 );
+		}
+
+		bool operator !=( const StringViewT& str ) const
+		{
+			return !( *this == str );
+		}
+
+		const CharType& operator []( s32 index ) const
+		{
+			Assert( 0 <= index && index < m_length );
+			return m_pCharacters[ index ];
+		}
+
+		const CharType* GetCharacters() const { return m_pCharacters; }
+		s32 GetLength() const { return m_length; }
+		bool IsEmpty() const { return m_length == 0; }
+
+		// Copies the characters into an owning string.
+		StringType ToString() const
+		{
+			return StringType( std::basic_string<CharType>( m_pCharacters, m_pCharacters + m_length ) );
+		}
+
+	private:
+		const CharType* m_pCharacters;
+		s32 m_length;
+	};
+
+	typedef StringViewT<StringA, char> StringViewA;
+	typedef StringViewT<StringW, wchar> StringViewW;
+
+#ifdef UNICODE
+	typedef StringViewW StringView;
+#else
+	typedef StringViewA StringView;
+#endif
+}
@@ -18,6 +18,7 @@
 // Core
 #include "Core/Diagnostics.h"
 #include "Core/Timer.h"
+#include "Core/Parallel.h"
 
 // Math
 #include "Math/Math.h"
@@ -26,6 +27,18 @@
 #include "Math/Vector4.h"
 #include "Math/Matrix4.h"
 #include "Math/Quaternion.h"
+#include "Math/BoundingBox.h"
+#include "Math/Frustum.h"
+#include "Math/Vector3d.h"
+#include "Math/Matrix4d.h"
+#include "Math/Spline.h"
+#include "Math/Noise.h"
+#include "Math/SphericalHarmonics.h"
+#include "Math/Fixed.h"
+#include "Math/FixedVector.h"
+#include "Math/MatrixLayout.h"
+#include "Math/Predicates.h"
+#include "Math/Quantization.h"
 
 // Text
 #include "Text/Encoding.h"
@@ -33,6 +46,7 @@
 #include "Text/StringA.h"
 #include "Text/StringW.h"
 #include "Text/String.h"
+#include "Text/StringView.h"
 #include "Text/TextHelper.h"
 #include "Text/StringTokenizerT.h"
 #include "Text/StringTokenizerA.h"
@@ -40,8 +54,31 @@
 #include "Text/StringTokenizer.h"
 
 // Memory
+#include "Memory/VirtualMemory.h"
 #include "Memory/MemoryBlock.h"
+#include "Memory/ByteOrder.h"
+#include "Memory/VarInt.h"
 #include "Memory/MessageStream.h"
+#include "Memory/MessageStreamView.h"
+#include "Memory/BitStream.h"
+#include "Memory/LinearArena.h"
+#include "Memory/FixedPool.h"
+#include "Memory/SlotMap.h"
+#include "Memory/SegmentedBuffer.h"
+#include "Memory/MessageRing.h"
+
+// Graphics
+#include "Graphics/Culling/OcclusionBuffer.h"
+#include "Graphics/Culling/MultiViewCuller.h"
+#include "Graphics/Geometry/ConvexHull.h"
+#include "Graphics/Geometry/MeshSimplifier.h"
+#include "Graphics/Geometry/MeshletBuilder.h"
+#include "Graphics/Instancing/InstanceRingBuffer.h"
+#include "Graphics/Instancing/InstanceFormat.h"
+#include "Graphics/Instancing/InstanceStreamWriter.h"
+#include "Graphics/Lighting/LightProbeGrid.h"
+#include "Graphics/Particle/ParticleSystem.h"
+#include "Graphics/Terrain/TerrainQuadtree.h"
 
 // Console Variable
 //#include "Core/ConsoleVariable/DataType.h"